@@ -0,0 +1,174 @@
+#include "ByteClass.h"
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define BYTECLASS_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// GCC/Clang 需要为 AVX2 函数单独开启指令集，MSVC 不需要
+#if defined(BYTECLASS_X86) && (defined(__GNUC__) || defined(__clang__))
+#define BYTECLASS_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define BYTECLASS_TARGET_AVX2
+#endif
+
+namespace {
+
+inline bool isSpaceByte(unsigned char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+inline bool isControlByte(unsigned char c) {
+    return (c < 0x20 && !isSpaceByte(c)) || c == 0x7F;
+}
+
+// 逐字节分类，向量实现用它处理整块之后剩余的字节
+void classifyTail(const unsigned char* data, size_t size, ByteClass& result) {
+    for (size_t i = 0; i < size; ++i) {
+        unsigned char c = data[i];
+        result.lineBreaks += c == '\n';
+        result.allWhitespace = result.allWhitespace && isSpaceByte(c);
+        result.printable = result.printable && !isControlByte(c);
+    }
+}
+
+ByteClass classifyScalar(const char* data, size_t size) {
+    ByteClass result = { 0, true, true };
+    classifyTail(reinterpret_cast<const unsigned char*>(data), size, result);
+    return result;
+}
+
+#ifdef BYTECLASS_X86
+
+inline unsigned popCount(uint32_t mask) {
+#ifdef _MSC_VER
+    return __popcnt(mask);
+#else
+    return static_cast<unsigned>(__builtin_popcount(mask));
+#endif
+}
+
+// 无符号比较 v <= limit：min(v, limit) == v
+ByteClass classifySse2(const char* data, size_t size) {
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i spanCr = _mm_set1_epi8('\r' - '\t');
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i below = _mm_set1_epi8(0x1F);
+    const __m128i del = _mm_set1_epi8(0x7F);
+
+    __m128i notSpace = _mm_setzero_si128();
+    __m128i control = _mm_setzero_si128();
+    size_t lineBreaks = 0;
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i fromTab = _mm_sub_epi8(v, tab);
+        __m128i ws = _mm_or_si128(_mm_cmpeq_epi8(v, space),
+                                  _mm_cmpeq_epi8(_mm_min_epu8(fromTab, spanCr), fromTab));
+        __m128i low = _mm_cmpeq_epi8(_mm_min_epu8(v, below), v);
+        notSpace = _mm_or_si128(notSpace, _mm_xor_si128(ws, _mm_set1_epi8(-1)));
+        control = _mm_or_si128(control, _mm_or_si128(_mm_andnot_si128(ws, low), _mm_cmpeq_epi8(v, del)));
+        lineBreaks += popCount(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, newline))));
+    }
+
+    ByteClass result = { lineBreaks, _mm_movemask_epi8(notSpace) == 0, _mm_movemask_epi8(control) == 0 };
+    classifyTail(reinterpret_cast<const unsigned char*>(data + i), size - i, result);
+    return result;
+}
+
+BYTECLASS_TARGET_AVX2
+ByteClass classifyAvx2(const char* data, size_t size) {
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i spanCr = _mm256_set1_epi8('\r' - '\t');
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const __m256i below = _mm256_set1_epi8(0x1F);
+    const __m256i del = _mm256_set1_epi8(0x7F);
+
+    __m256i notSpace = _mm256_setzero_si256();
+    __m256i control = _mm256_setzero_si256();
+    size_t lineBreaks = 0;
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i fromTab = _mm256_sub_epi8(v, tab);
+        __m256i ws = _mm256_or_si256(_mm256_cmpeq_epi8(v, space),
+                                     _mm256_cmpeq_epi8(_mm256_min_epu8(fromTab, spanCr), fromTab));
+        __m256i low = _mm256_cmpeq_epi8(_mm256_min_epu8(v, below), v);
+        notSpace = _mm256_or_si256(notSpace, _mm256_xor_si256(ws, _mm256_set1_epi8(-1)));
+        control = _mm256_or_si256(control,
+                                  _mm256_or_si256(_mm256_andnot_si256(ws, low), _mm256_cmpeq_epi8(v, del)));
+        lineBreaks += popCount(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, newline))));
+    }
+
+    ByteClass result = { lineBreaks, _mm256_movemask_epi8(notSpace) == 0, _mm256_movemask_epi8(control) == 0 };
+    classifyTail(reinterpret_cast<const unsigned char*>(data + i), size - i, result);
+    return result;
+}
+
+bool cpuHasAvx2() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    // 操作系统需要保存 YMM 寄存器（OSXSAVE + XCR0 的 SSE/AVX 位）
+    if ((info[2] & (1 << 27)) == 0 || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif // BYTECLASS_X86
+
+ByteClassKernel detectKernel() {
+#ifdef BYTECLASS_X86
+    return cpuHasAvx2() ? ByteClassKernel::Avx2 : ByteClassKernel::Sse2;
+#else
+    return ByteClassKernel::Scalar;
+#endif
+}
+
+} // namespace
+
+ByteClassKernel byteClassKernel() {
+    static const ByteClassKernel kernel = detectKernel();
+    return kernel;
+}
+
+const char* byteClassKernelName(ByteClassKernel kernel) {
+    switch (kernel) {
+        case ByteClassKernel::Avx2: return "avx2";
+        case ByteClassKernel::Sse2: return "sse2";
+        default: return "scalar";
+    }
+}
+
+ByteClass classifyBytes(const char* data, size_t size) {
+    return classifyBytes(data, size, byteClassKernel());
+}
+
+ByteClass classifyBytes(const char* data, size_t size, ByteClassKernel kernel) {
+#ifdef BYTECLASS_X86
+    if (kernel == ByteClassKernel::Avx2 && byteClassKernel() == ByteClassKernel::Avx2) {
+        return classifyAvx2(data, size);
+    }
+    if (kernel != ByteClassKernel::Scalar) {
+        return classifySse2(data, size);
+    }
+#else
+    (void)kernel;
+#endif
+    return classifyScalar(data, size);
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <cstddef>
+
+// 数据块的字节分类结果，一次扫描得到
+struct ByteClass {
+    size_t lineBreaks;   // '\n' 的个数
+    bool allWhitespace;  // 为空或只有空白字符（C 语言环境的 isspace：空格 \t \n \v \f \r）
+    bool printable;      // 文本：不含除空白外的控制字符和 0x7F；0x80 以上视为多字节编码的一部分
+
+    bool hasNewline() const { return lineBreaks > 0; }
+};
+
+enum class ByteClassKernel { Scalar, Sse2, Avx2 };
+
+// 使用运行时检测到的最快实现
+ByteClass classifyBytes(const char* data, size_t size);
+// 指定实现，CPU 不支持时退回标量版本；用于测试和性能对比
+ByteClass classifyBytes(const char* data, size_t size, ByteClassKernel kernel);
+
+ByteClassKernel byteClassKernel();  // 运行时选中的实现
+const char* byteClassKernelName(ByteClassKernel kernel);
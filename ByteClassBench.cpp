@@ -0,0 +1,63 @@
+// 字节分类的吞吐量测试：测量各实现和旧版 std::all_of + std::isspace 的吞吐量
+// 正确性检查见 ByteClassTest
+// 用法: ByteClassBench [数据块大小] [数据量MB]
+#include "ByteClass.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+
+const ByteClassKernel kKernels[] = { ByteClassKernel::Scalar, ByteClassKernel::Sse2, ByteClassKernel::Avx2 };
+
+void report(const char* name, size_t bytes, double seconds) {
+    std::cout << std::left << std::setw(20) << name << std::right
+              << std::setw(10) << std::fixed << std::setprecision(3) << seconds << " s"
+              << std::setw(10) << std::setprecision(2) << bytes / seconds / 1e9 << " GB/s" << std::endl;
+}
+
+template <typename Fn>
+void bench(const char* name, const std::vector<char>& data, size_t chunkSize, Fn classify) {
+    size_t sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t offset = 0; offset + chunkSize <= data.size(); offset += chunkSize) {
+        sink += classify(data.data() + offset, chunkSize);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (sink == 1) {
+        std::cout << "";  // 防止循环被优化掉
+    }
+    report(name, data.size() / chunkSize * chunkSize, seconds);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t chunkSize = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1024;
+    size_t megabytes = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 256;
+    chunkSize = std::max<size_t>(chunkSize, 1);
+
+    // 最坏情况：只有空白，旧版实现不能提前结束
+    std::vector<char> data(megabytes * 1024 * 1024);
+    std::mt19937 rng(1);
+    for (auto& c : data) {
+        c = " \t\r\n"[rng() % 4];
+    }
+
+    std::cout << "Whitespace-only data, " << chunkSize << "-byte chunks:" << std::endl;
+    bench("all_of + isspace", data, chunkSize, [](const char* p, size_t n) {
+        return static_cast<size_t>(std::all_of(p, p + n,
+            [](char c) { return std::isspace(static_cast<unsigned char>(c)) != 0; }));
+    });
+    for (ByteClassKernel kernel : kKernels) {
+        bench(byteClassKernelName(kernel), data, chunkSize, [kernel](const char* p, size_t n) {
+            return classifyBytes(p, n, kernel).lineBreaks;
+        });
+    }
+    return 0;
+}
@@ -0,0 +1,123 @@
+// 字节分类的正确性检查：各实现（标量、SSE2、AVX2）与 std::isspace 逐字节的结果对比，不一致时退出码为 1
+//   - 边界长度 0、15、16、31、32、33，起始地址相对 64 字节对齐偏移 0-63，异类字节放在每一个位置
+//   - 随机数据，长度 0-300、偏移 0-3，三个结果都有真有假
+// 用法: ByteClassTest
+#include "ByteClass.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+
+const ByteClassKernel kKernels[] = { ByteClassKernel::Scalar, ByteClassKernel::Sse2, ByteClassKernel::Avx2 };
+
+// 逐字节的参考结果
+ByteClass reference(const char* data, size_t size) {
+    ByteClass result = { 0, true, true };
+    for (size_t i = 0; i < size; ++i) {
+        unsigned char c = static_cast<unsigned char>(data[i]);
+        bool space = std::isspace(c) != 0;
+        result.lineBreaks += c == '\n';
+        result.allWhitespace = result.allWhitespace && space;
+        result.printable = result.printable && !((std::iscntrl(c) && !space) || c == 0x7F);
+    }
+    return result;
+}
+
+bool same(const ByteClass& a, const ByteClass& b) {
+    return a.lineBreaks == b.lineBreaks && a.allWhitespace == b.allWhitespace && a.printable == b.printable;
+}
+
+size_t g_cases = 0;
+
+bool checkAll(const char* data, size_t size, const char* what) {
+    ByteClass expected = reference(data, size);
+    for (ByteClassKernel kernel : kKernels) {
+        ByteClass actual = classifyBytes(data, size, kernel);
+        if (!same(actual, expected)) {
+            std::cerr << "Mismatch: " << byteClassKernelName(kernel) << " " << what << " size " << size
+                      << " address % 64 = " << reinterpret_cast<uintptr_t>(data) % 64 << std::endl;
+            return false;
+        }
+    }
+    ++g_cases;
+    return true;
+}
+
+// SSE2 / AVX2 一次处理 16 / 32 字节，这些长度正好落在整块和尾部的边界上
+bool edgeCases() {
+    const size_t sizes[] = { 0, 15, 16, 31, 32, 33 };
+    // 每种字节单独出现在空白中时应改变的结果
+    const unsigned char odd[] = { 'a', '\n', '\t', 0x00, 0x1F, 0x7F, 0x80, 0xFF };
+    alignas(64) char buffer[64 + 64];
+    for (size_t size : sizes) {
+        for (size_t offset = 0; offset < 64; ++offset) {
+            char* data = buffer + offset;
+            std::memset(buffer, 'x', sizeof(buffer));  // 范围外的字节不能影响结果
+            std::memset(data, ' ', size);
+            if (!checkAll(data, size, "all spaces")) {
+                return false;
+            }
+            for (size_t position = 0; position < size; ++position) {
+                for (unsigned char c : odd) {
+                    data[position] = static_cast<char>(c);
+                    if (!checkAll(data, size, "single byte")) {
+                        std::cerr << "  byte 0x" << std::hex << static_cast<int>(c) << std::dec
+                                  << " at " << position << std::endl;
+                        return false;
+                    }
+                }
+                data[position] = ' ';
+            }
+            std::memset(data, '\n', size);
+            if (!checkAll(data, size, "all newlines")) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// 从不同的字节集合生成数据，让三个结果都有真有假
+bool randomCases() {
+    const std::vector<std::vector<unsigned char>> alphabets = {
+        { ' ', '\t', '\n', '\v', '\f', '\r' },
+        { ' ', '\n', 'a', 'Z', '~', 0x80, 0xE4, 0xFF },
+        { ' ', '\n', 'a', 0x00, 0x08, 0x0E, 0x1F, 0x7F },
+    };
+    std::mt19937 rng(7);
+    std::vector<char> buffer(4096 + 64);
+    for (const auto& alphabet : alphabets) {
+        for (size_t size = 0; size <= 300; ++size) {
+            for (size_t offset = 0; offset < 4; ++offset) {
+                for (size_t i = 0; i < size; ++i) {
+                    buffer[offset + i] = static_cast<char>(alphabet[rng() % alphabet.size()]);
+                }
+                // 偶尔只放一个异类字节，检查单个字节在块内任意位置都能被发现
+                if (size > 0 && rng() % 4 == 0) {
+                    std::fill(buffer.begin() + offset, buffer.begin() + offset + size, ' ');
+                    buffer[offset + rng() % size] = static_cast<char>(alphabet[rng() % alphabet.size()]);
+                }
+                if (!checkAll(buffer.data() + offset, size, "random")) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main() {
+    if (!edgeCases() || !randomCases()) {
+        return 1;
+    }
+    std::cout << "Byte classification check passed: " << g_cases << " cases, runtime kernel "
+              << byteClassKernelName(byteClassKernel()) << std::endl;
+    return 0;
+}
@@ -0,0 +1,91 @@
+#include "Chunk.h"
+#include "MemoryBudget.h"
+#include <new>
+
+namespace {
+
+constexpr size_t kCacheLine = 64;
+
+} // namespace
+
+ChunkPool::ChunkPool(size_t chunkSize, size_t slabChunks, MemoryBudget* budget)
+    : m_refs(1), m_chunkSize(chunkSize), m_slabChunks(slabChunks > 0 ? slabChunks : 1),
+      m_budget(budget), m_local(nullptr), m_returned(nullptr),
+      m_allocations(0), m_acquires(0), m_recycled(0), m_allocatedBytes(0) {
+    // 每个数据块按缓存行对齐，避免相邻块被不同线程访问时的伪共享
+    size_t bytes = sizeof(ChunkBuffer) + ChunkBuffer::kHeadroom + m_chunkSize;
+    m_stride = (bytes + kCacheLine - 1) / kCacheLine * kCacheLine;
+}
+
+void ChunkPool::retire() {
+    release();
+}
+
+void ChunkPool::release() {
+    if (m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete this;
+    }
+}
+
+void ChunkPool::grow() {
+    std::unique_ptr<char[]> slab(new char[m_stride * m_slabChunks + kCacheLine]);
+    char* base = slab.get();
+    base += (kCacheLine - reinterpret_cast<uintptr_t>(base) % kCacheLine) % kCacheLine;
+
+    for (size_t i = 0; i < m_slabChunks; ++i) {
+        auto* buffer = new (base + i * m_stride) ChunkBuffer();
+        buffer->refs.store(0, std::memory_order_relaxed);
+        buffer->size = 0;
+        buffer->capacity = static_cast<uint32_t>(m_chunkSize);
+        buffer->sequence = 0;
+        buffer->pool = this;
+        buffer->next = m_local;
+        m_local = buffer;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_slabMutex);
+        m_slabs.push_back(std::move(slab));
+    }
+    m_allocations.fetch_add(1, std::memory_order_relaxed);
+    m_allocatedBytes.fetch_add(m_stride * m_slabChunks, std::memory_order_relaxed);
+}
+
+ChunkRef ChunkPool::acquire() {
+    if (!m_local) {
+        // 一次取回其他线程归还的全部数据块；只有本线程取，不存在 ABA 问题
+        m_local = m_returned.exchange(nullptr, std::memory_order_acquire);
+        if (!m_local) {
+            grow();
+        }
+    }
+
+    ChunkBuffer* buffer = m_local;
+    m_local = buffer->next;
+    m_refs.fetch_add(1, std::memory_order_relaxed);
+    buffer->refs.store(1, std::memory_order_relaxed);
+    buffer->size = 0;
+    m_acquires.fetch_add(1, std::memory_order_relaxed);
+    if (m_budget) {
+        m_budget->charge(m_stride);
+    }
+    return ChunkRef(buffer);
+}
+
+void ChunkPool::recycle(ChunkBuffer* buffer) {
+    ChunkBuffer* head = m_returned.load(std::memory_order_relaxed);
+    do {
+        buffer->next = head;
+    } while (!m_returned.compare_exchange_weak(head, buffer,
+        std::memory_order_release, std::memory_order_relaxed));
+    m_recycled.fetch_add(1, std::memory_order_relaxed);
+    if (m_budget) {
+        m_budget->credit(m_stride);
+    }
+    release();
+}
+
+size_t ChunkPool::outstanding() const {
+    return static_cast<size_t>(m_acquires.load(std::memory_order_relaxed) -
+                               m_recycled.load(std::memory_order_relaxed));
+}
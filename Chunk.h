@@ -0,0 +1,145 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class ChunkPool;
+class MemoryBudget;
+
+// 池中的一个数据块：头部 + 预留区 + 定长数据区，由引用计数管理生命周期
+struct ChunkBuffer {
+    // 数据区前的预留空间，转发时可以就地写入帧头，与数据一起连续发送
+    static constexpr size_t kHeadroom = 32;
+
+    std::atomic<uint32_t> refs;
+    uint32_t size;
+    uint32_t capacity;
+    std::chrono::system_clock::time_point time;  // 读取时刻
+    uint64_t sequence;  // 串口内的数据块序号
+    ChunkPool* pool;
+    ChunkBuffer* next;  // 空闲链表
+
+    char* data() { return reinterpret_cast<char*>(this + 1) + kHeadroom; }
+};
+
+// 数据块的引用，复制只增加引用计数，不复制数据
+// 写盘和 TCP 转发可以同时持有同一个数据块，最后一个引用释放时归还到池中
+class ChunkRef {
+public:
+    ChunkRef() : m_buffer(nullptr) {}
+    explicit ChunkRef(ChunkBuffer* buffer) : m_buffer(buffer) {}
+    ChunkRef(const ChunkRef& other) : m_buffer(other.m_buffer) { retain(); }
+    ChunkRef(ChunkRef&& other) noexcept : m_buffer(other.m_buffer) { other.m_buffer = nullptr; }
+    ~ChunkRef() { reset(); }
+
+    ChunkRef& operator=(const ChunkRef& other) {
+        if (this != &other) {
+            reset();
+            m_buffer = other.m_buffer;
+            retain();
+        }
+        return *this;
+    }
+    ChunkRef& operator=(ChunkRef&& other) noexcept {
+        if (this != &other) {
+            reset();
+            m_buffer = other.m_buffer;
+            other.m_buffer = nullptr;
+        }
+        return *this;
+    }
+
+    explicit operator bool() const { return m_buffer != nullptr; }
+
+    const char* data() const { return m_buffer->data(); }
+    char* data() { return m_buffer->data(); }
+    size_t size() const { return m_buffer->size; }
+    size_t capacity() const { return m_buffer->capacity; }
+    bool empty() const { return !m_buffer || m_buffer->size == 0; }
+    std::chrono::system_clock::time_point time() const { return m_buffer->time; }
+    uint64_t sequence() const { return m_buffer->sequence; }
+    // 数据区前 size 字节的预留区，size 不超过 ChunkBuffer::kHeadroom
+    char* headroom(size_t size) const { return m_buffer->data() - size; }
+
+    void setSize(size_t size) { m_buffer->size = static_cast<uint32_t>(size); }
+    void setTime(std::chrono::system_clock::time_point time) { m_buffer->time = time; }
+    void setSequence(uint64_t sequence) { m_buffer->sequence = sequence; }
+
+    void reset();
+
+private:
+    void retain() {
+        if (m_buffer) {
+            m_buffer->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    ChunkBuffer* m_buffer;
+};
+
+// 单个串口的数据块池，按 slab 批量分配
+// acquire() 只能在读取线程调用；release 可以在任意线程发生（写盘、TCP 线程）
+// 池本身也有引用计数：所有者调用 retire() 后，最后一个数据块归还时才释放，
+// 因此下游（如多个串口共用的 TCP 连接）持有的数据块可以比采集器活得更久
+// 指定 budget 时取出和归还的数据块计入全局预算，budget 必须比池活得更久
+class ChunkPool {
+public:
+    static constexpr size_t kDefaultChunkSize = 1024;
+    static constexpr size_t kDefaultSlabChunks = 64;
+
+    // 配合 std::unique_ptr 使用的删除器
+    struct Retire {
+        void operator()(ChunkPool* pool) const { pool->retire(); }
+    };
+
+    explicit ChunkPool(size_t chunkSize = kDefaultChunkSize, size_t slabChunks = kDefaultSlabChunks,
+                       MemoryBudget* budget = nullptr);
+
+    ChunkPool(const ChunkPool&) = delete;
+    ChunkPool& operator=(const ChunkPool&) = delete;
+
+    ChunkRef acquire();
+    void recycle(ChunkBuffer* buffer);
+    void retire();  // 所有者放弃池，之后不能再 acquire()
+
+    size_t chunkSize() const { return m_chunkSize; }
+    uint64_t allocations() const { return m_allocations.load(std::memory_order_relaxed); }
+    uint64_t acquires() const { return m_acquires.load(std::memory_order_relaxed); }
+    size_t outstanding() const;
+    size_t outstandingBytes() const { return outstanding() * m_stride; }  // 已取出未归还的数据块占用的内存
+    size_t allocatedBytes() const { return m_allocatedBytes.load(std::memory_order_relaxed); }
+
+private:
+    ~ChunkPool() = default;  // 只能通过 retire() 释放
+    void grow();
+    void release();
+
+    std::atomic<size_t> m_refs;  // 所有者 + 已取出未归还的数据块
+    size_t m_chunkSize;
+    size_t m_slabChunks;
+    size_t m_stride;
+    MemoryBudget* m_budget;
+
+    ChunkBuffer* m_local;                   // 读取线程私有的空闲链表
+    std::atomic<ChunkBuffer*> m_returned;   // 其他线程归还的数据块
+
+    std::mutex m_slabMutex;
+    std::vector<std::unique_ptr<char[]>> m_slabs;
+    std::atomic<uint64_t> m_allocations;    // 堆分配次数（slab 数）
+    std::atomic<uint64_t> m_acquires;
+    std::atomic<uint64_t> m_recycled;
+    std::atomic<size_t> m_allocatedBytes;
+};
+
+inline void ChunkRef::reset() {
+    if (m_buffer) {
+        if (m_buffer->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            m_buffer->pool->recycle(m_buffer);
+        }
+        m_buffer = nullptr;
+    }
+}
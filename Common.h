@@ -1,9 +1,141 @@
 #pragma once
 #include <string>
+#include <ctime>
+#include <tuple>
+#include <vector>
+
+#ifndef _WIN32
+// POSIX 下用 localtime_r 实现 MSVC 的 localtime_s
+inline int localtime_s(struct tm* result, const time_t* time) {
+    return localtime_r(time, result) ? 0 : -1;
+}
+#endif
+
+// 数据文件格式
+enum class FileFormat {
+    Text,    // YYYYMMDD.data：可选时间戳前缀的文本行（默认）
+    Record,  // YYYYMMDD.rec + .idx：带纳秒时间戳的二进制记录和稀疏时间索引（见 Record.h）
+};
+
+// 文本格式时间戳前缀的精度
+enum class TimestampPrecision {
+    Second,  // [2024-01-18 12:34:56]（默认）
+    Milli,   // [2024-01-18 12:34:56.123]
+    Micro,   // [2024-01-18 12:34:56.123456]
+};
+
+// 已关闭数据文件分段的压缩算法，由后台压缩线程处理（见 Compressor.h）
+enum class Codec {
+    None,
+    Zstd,
+    Lz4,
+    Gzip,
+};
+
+// 压缩后追加在原文件名后的扩展名
+inline const char* codecExtension(Codec codec) {
+    switch (codec) {
+        case Codec::Zstd: return ".zst";
+        case Codec::Lz4:  return ".lz4";
+        case Codec::Gzip: return ".gz";
+        default:          return "";
+    }
+}
+
+// 数据块内存超出预算时的处理（见 MemoryBudget.h），作用于积压最多的阶段（写盘或 TCP 转发）
+enum class MemoryPolicy {
+    DropNewest,  // 不再把新数据块交给该阶段（默认）
+    DropOldest,  // 该阶段下次取数据时丢弃队列中最旧的数据块
+    Block,       // 读取线程暂停，数据留在驱动和 UART 中，由流控或驱动缓冲承受
+    Spill,       // TCP 转发改为写入存储转发的磁盘队列，需要 storeAndForward
+};
+
+// 线程调度（见 Scheduling.h）：串口的读取线程、Reactor 线程或其余后台线程
+struct SchedulingConfig {
+    std::vector<int> cpus;  // 绑定的 CPU 编号，为空时不绑定
+    int priority;           // SCHED_FIFO 优先级 1-99，0 为普通调度
+};
+
+inline bool operator==(const SchedulingConfig& a, const SchedulingConfig& b) {
+    return std::tie(a.cpus, a.priority) == std::tie(b.cpus, b.priority);
+}
+inline bool operator!=(const SchedulingConfig& a, const SchedulingConfig& b) { return !(a == b); }
+
+// 串口字节流的分帧方式（见 Framer.h），每帧作为一个数据块写盘和转发
+enum class FramingMode {
+    None,       // 每次 read() 返回的字节为一块（默认）
+    Delimiter,  // 以分隔符结尾，分隔符保留在帧内
+    Length,     // 帧头中的长度字段
+    Fixed,      // 固定长度
+    IdleGap,    // 字节间静默超过阈值时结束一帧（如 Modbus RTU 的 3.5 个字符时间）
+};
+
+struct FramingConfig {
+    FramingMode mode;
+    std::string delimiter;  // Delimiter：如 "\r\n"
+    int lengthOffset;       // Length：长度字段在帧内的偏移
+    int lengthSize;         // Length：长度字段字节数，1、2 或 4
+    bool lengthBigEndian;   // Length：长度字段为大端
+    int lengthAdjust;       // Length：帧长 = lengthOffset + lengthSize + 字段值 + lengthAdjust
+    int frameSize;          // Fixed：帧长
+    int idleGapUs;          // IdleGap：静默阈值（微秒），0 为 3.5 个字符时间
+    int maxFrameSize;       // 超过后强制切分；长度字段超出时视为错误并重新同步
+};
+
+inline bool operator==(const FramingConfig& a, const FramingConfig& b) {
+    return std::tie(a.mode, a.delimiter, a.lengthOffset, a.lengthSize, a.lengthBigEndian,
+                    a.lengthAdjust, a.frameSize, a.idleGapUs, a.maxFrameSize) ==
+           std::tie(b.mode, b.delimiter, b.lengthOffset, b.lengthSize, b.lengthBigEndian,
+                    b.lengthAdjust, b.frameSize, b.idleGapUs, b.maxFrameSize);
+}
+inline bool operator!=(const FramingConfig& a, const FramingConfig& b) { return !(a == b); }
 
 struct TcpConfig {
     bool enabled;
     std::string server;
     int port;
-    int reconnectInterval;
-}; 
\ No newline at end of file
+    int reconnectInterval;  // 重连退避的最长间隔（秒）
+    int reconnectInitialMs; // 重连退避的初始间隔，每次失败加倍
+    int connectTimeoutMs;   // 单次连接的超时时间
+    bool keepAlive;         // SO_KEEPALIVE，空闲连接上检测断线
+    int keepAliveIdle;      // 空闲多少秒后开始探测
+    int keepAliveInterval;  // 探测间隔（秒）
+    int keepAliveCount;     // 连续多少次探测失败判定断线
+    int userTimeoutMs;      // TCP_USER_TIMEOUT（仅 Linux），已发送数据多久未确认判定断线，0 为系统默认
+    int coalesceBytes;  // 单次批量发送的最大字节数
+    int coalesceUs;     // 凑批等待的最长时间（微秒），0 表示不等待
+    bool noDelay;       // TCP_NODELAY
+    bool cork;          // TCP_CORK（仅 Linux），每批发送后解除以推出尾部数据
+    bool storeAndForward;  // 无法发送的数据写入磁盘队列，重连后补发
+    int spoolSegmentMB;    // 磁盘队列单个分段文件大小
+    int spoolMaxMB;        // 磁盘队列上限，超出后丢弃
+    int windowBytes;       // 内存中保留的已发送未确认数据上限
+    bool multiplex;        // 同一 server:port 的串口共用一个连接，数据按帧发送（见 Frame.h）
+    int portId;            // 帧头中的串口编号，默认为串口在配置中的序号（从 1 开始）
+};
+
+inline bool operator==(const TcpConfig& a, const TcpConfig& b) {
+    return std::tie(a.enabled, a.server, a.port, a.reconnectInterval, a.reconnectInitialMs,
+                    a.connectTimeoutMs, a.keepAlive, a.keepAliveIdle, a.keepAliveInterval,
+                    a.keepAliveCount, a.userTimeoutMs, a.coalesceBytes, a.coalesceUs, a.noDelay,
+                    a.cork, a.storeAndForward, a.spoolSegmentMB, a.spoolMaxMB, a.windowBytes,
+                    a.multiplex, a.portId) ==
+           std::tie(b.enabled, b.server, b.port, b.reconnectInterval, b.reconnectInitialMs,
+                    b.connectTimeoutMs, b.keepAlive, b.keepAliveIdle, b.keepAliveInterval,
+                    b.keepAliveCount, b.userTimeoutMs, b.coalesceBytes, b.coalesceUs, b.noDelay,
+                    b.cork, b.storeAndForward, b.spoolSegmentMB, b.spoolMaxMB, b.windowBytes,
+                    b.multiplex, b.portId);
+}
+inline bool operator!=(const TcpConfig& a, const TcpConfig& b) { return !(a == b); }
+
+// 本机共享内存发布（见 ShmRing.h），本机的分析进程映射后直接读取数据块
+struct SharedMemoryConfig {
+    bool enabled;
+    std::string name;  // shm_open() 的名称（Linux 上为 /dev/shm/<name>），为空时为 "serial.<串口名>"
+    int sizeKB;        // 数据区大小，向上取 2 的幂
+};
+
+inline bool operator==(const SharedMemoryConfig& a, const SharedMemoryConfig& b) {
+    return std::tie(a.enabled, a.name, a.sizeKB) == std::tie(b.enabled, b.name, b.sizeKB);
+}
+inline bool operator!=(const SharedMemoryConfig& a, const SharedMemoryConfig& b) { return !(a == b); }
@@ -0,0 +1,304 @@
+#include "Compressor.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef HAVE_LZ4
+#include <lz4frame.h>
+#endif
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+uint64_t threadCpuNs() {
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user)) {
+        return 0;
+    }
+    auto ticks = [](const FILETIME& time) {
+        return (static_cast<uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime;
+    };
+    return (ticks(kernel) + ticks(user)) * 100;
+#else
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+#endif
+}
+
+// 把文件内容落到磁盘，之后才能删除原文件
+bool syncFile(std::FILE* file) {
+    if (std::fflush(file) != 0) {
+        return false;
+    }
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+// 一次压缩一个独立的块，每个任务创建一次算法上下文
+class BlockEncoder {
+public:
+    BlockEncoder(Codec codec, int level) : m_codec(codec), m_level(level) {
+#ifdef HAVE_ZSTD
+        m_zstd = codec == Codec::Zstd ? ZSTD_createCCtx() : nullptr;
+#endif
+#ifdef HAVE_ZLIB
+        m_zlibReady = false;
+        if (codec == Codec::Gzip) {
+            m_zlib = {};
+            // windowBits + 16 输出 gzip 格式，每次 deflateReset 后开始一个新的 gzip 成员
+            m_zlibReady = deflateInit2(&m_zlib, level > 0 ? level : Z_DEFAULT_COMPRESSION,
+                                       Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+        }
+#endif
+    }
+
+    ~BlockEncoder() {
+#ifdef HAVE_ZSTD
+        ZSTD_freeCCtx(m_zstd);
+#endif
+#ifdef HAVE_ZLIB
+        if (m_zlibReady) {
+            deflateEnd(&m_zlib);
+        }
+#endif
+    }
+
+    BlockEncoder(const BlockEncoder&) = delete;
+    BlockEncoder& operator=(const BlockEncoder&) = delete;
+
+    size_t bound(size_t size) {
+        switch (m_codec) {
+#ifdef HAVE_ZSTD
+            case Codec::Zstd: return ZSTD_compressBound(size);
+#endif
+#ifdef HAVE_LZ4
+            case Codec::Lz4: {
+                LZ4F_preferences_t prefs = preferences(size);
+                return LZ4F_compressFrameBound(size, &prefs);
+            }
+#endif
+#ifdef HAVE_ZLIB
+            case Codec::Gzip: return m_zlibReady ? deflateBound(&m_zlib, static_cast<uLong>(size)) : 0;
+#endif
+            default: return 0;
+        }
+    }
+
+    // 返回压缩后的字节数，失败返回 0
+    size_t encode(const char* input, size_t size, char* output, size_t capacity) {
+        switch (m_codec) {
+#ifdef HAVE_ZSTD
+            case Codec::Zstd: {
+                if (!m_zstd) {
+                    return 0;
+                }
+                // 级别 0 即 zstd 默认级别
+                size_t result = ZSTD_compressCCtx(m_zstd, output, capacity, input, size, m_level);
+                return ZSTD_isError(result) ? 0 : result;
+            }
+#endif
+#ifdef HAVE_LZ4
+            case Codec::Lz4: {
+                LZ4F_preferences_t prefs = preferences(size);
+                size_t result = LZ4F_compressFrame(output, capacity, input, size, &prefs);
+                return LZ4F_isError(result) ? 0 : result;
+            }
+#endif
+#ifdef HAVE_ZLIB
+            case Codec::Gzip: {
+                if (!m_zlibReady || deflateReset(&m_zlib) != Z_OK) {
+                    return 0;
+                }
+                m_zlib.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input));
+                m_zlib.avail_in = static_cast<uInt>(size);
+                m_zlib.next_out = reinterpret_cast<Bytef*>(output);
+                m_zlib.avail_out = static_cast<uInt>(capacity);
+                return deflate(&m_zlib, Z_FINISH) == Z_STREAM_END ? capacity - m_zlib.avail_out : 0;
+            }
+#endif
+            default:
+                return 0;
+        }
+    }
+
+private:
+#ifdef HAVE_LZ4
+    LZ4F_preferences_t preferences(size_t size) const {
+        LZ4F_preferences_t prefs = {};
+        prefs.compressionLevel = m_level;
+        prefs.frameInfo.contentSize = size;
+        prefs.frameInfo.blockSizeID = LZ4F_max4MB;
+        return prefs;
+    }
+#endif
+
+    Codec m_codec;
+    int m_level;
+#ifdef HAVE_ZSTD
+    ZSTD_CCtx* m_zstd;
+#endif
+#ifdef HAVE_ZLIB
+    z_stream m_zlib;
+    bool m_zlibReady;
+#endif
+};
+
+} // namespace
+
+Compressor::Compressor() : m_running(false) {}
+
+Compressor::~Compressor() {
+    stop();
+}
+
+bool Compressor::available(Codec codec) {
+    switch (codec) {
+#ifdef HAVE_ZSTD
+        case Codec::Zstd: return true;
+#endif
+#ifdef HAVE_LZ4
+        case Codec::Lz4: return true;
+#endif
+#ifdef HAVE_ZLIB
+        case Codec::Gzip: return true;
+#endif
+        default: return false;
+    }
+}
+
+void Compressor::start() {
+    m_running = true;
+    m_thread = std::thread(&Compressor::run, this);
+}
+
+void Compressor::stop() {
+    if (!m_running.exchange(false)) {
+        return;
+    }
+    m_signal.notify();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+    std::lock_guard<std::mutex> lock(m_jobsMutex);
+    m_jobs.clear();
+}
+
+void Compressor::submit(Job job) {
+    {
+        std::lock_guard<std::mutex> lock(m_jobsMutex);
+        m_jobs.push_back(std::move(job));
+    }
+    m_signal.notify();
+}
+
+void Compressor::run() {
+    // 压缩让位于采集和写盘线程
+#ifdef _WIN32
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
+#else
+    setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 10);
+#endif
+
+    while (m_running) {
+        Job job;
+        bool hasJob = false;
+        {
+            std::lock_guard<std::mutex> lock(m_jobsMutex);
+            if (!m_jobs.empty()) {
+                job = std::move(m_jobs.front());
+                m_jobs.pop_front();
+                hasJob = true;
+            }
+        }
+        if (hasJob) {
+            compress(job);
+            continue;
+        }
+        m_signal.wait([this] {
+            std::lock_guard<std::mutex> lock(m_jobsMutex);
+            return !m_running || !m_jobs.empty();
+        });
+    }
+}
+
+bool Compressor::compress(const Job& job) {
+    std::string port = job.path.parent_path().filename().string();
+    auto target = job.path;
+    target += codecExtension(job.codec);
+    auto temp = target;
+    temp += ".tmp";
+
+    std::FILE* input = std::fopen(job.path.string().c_str(), "rb");
+    if (!input) {
+        LOG_ERROR(port, "Failed to open " + job.path.string() + " for compression");
+        return false;
+    }
+    std::FILE* output = std::fopen(temp.string().c_str(), "wb");
+    if (!output) {
+        std::fclose(input);
+        LOG_ERROR(port, "Failed to create " + temp.string());
+        return false;
+    }
+
+    BlockEncoder encoder(job.codec, job.level);
+    size_t blockSize = (std::max)(job.blockSize, static_cast<size_t>(4096));
+    std::vector<char> block(blockSize);
+    std::vector<char> compressed(encoder.bound(blockSize));
+    bool ok = !compressed.empty();
+    while (ok && m_running) {
+        size_t size = std::fread(block.data(), 1, block.size(), input);
+        if (size == 0) {
+            ok = !std::ferror(input);
+            break;
+        }
+        uint64_t cpuStart = threadCpuNs();
+        size_t packed = encoder.encode(block.data(), size, compressed.data(), compressed.size());
+        job.stats->cpuNs.fetch_add(threadCpuNs() - cpuStart, std::memory_order_relaxed);
+        ok = packed > 0 && std::fwrite(compressed.data(), 1, packed, output) == packed;
+        job.stats->bytesIn.fetch_add(size, std::memory_order_relaxed);
+        job.stats->bytesOut.fetch_add(packed, std::memory_order_relaxed);
+    }
+    std::fclose(input);
+    ok = ok && m_running && syncFile(output);
+    ok = std::fclose(output) == 0 && ok;
+
+    std::error_code ec;
+    if (!ok) {
+        if (m_running) {
+            LOG_ERROR(port, "Failed to compress " + job.path.string());
+        }
+        std::filesystem::remove(temp, ec);
+        return false;
+    }
+
+    std::filesystem::rename(temp, target, ec);
+    if (ec) {
+        LOG_ERROR(port, "Failed to rename " + temp.string() + ": " + ec.message());
+        std::filesystem::remove(temp, ec);
+        return false;
+    }
+    std::filesystem::remove(job.path, ec);
+    job.stats->files.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
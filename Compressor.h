@@ -0,0 +1,54 @@
+#pragma once
+#include "Common.h"
+#include "SpscRing.h"
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// 一个串口的压缩统计，压缩线程更新，状态显示读取
+struct CompressionStats {
+    std::atomic<uint64_t> files{ 0 };     // 已压缩完成的分段数
+    std::atomic<uint64_t> bytesIn{ 0 };
+    std::atomic<uint64_t> bytesOut{ 0 };
+    std::atomic<uint64_t> cpuNs{ 0 };     // 压缩算法占用的线程 CPU 时间，不含文件读写
+};
+
+// 后台压缩线程：把已关闭的数据文件分段压缩为 <文件名><扩展名>，完成并落盘后删除原文件
+// 原始数据按 blockSize 切块，每块是一个完整的 zstd/LZ4 帧或 gzip 成员，可以单独解压；
+// 各块直接拼接，zstd -d / lz4 -d / gunzip 也能整体解压
+class Compressor {
+public:
+    struct Job {
+        std::filesystem::path path;
+        Codec codec;
+        int level;  // 0 为算法默认级别
+        size_t blockSize;
+        std::shared_ptr<CompressionStats> stats;
+    };
+
+    Compressor();
+    ~Compressor();
+
+    void start();
+    // 正在压缩的分段放弃并删除临时文件，未处理的分段下次启动时重新压缩
+    void stop();
+
+    void submit(Job job);
+
+    // 编译时是否链接了该算法的库
+    static bool available(Codec codec);
+
+private:
+    void run();
+    bool compress(const Job& job);
+
+    std::atomic<bool> m_running;
+    std::thread m_thread;
+    std::mutex m_jobsMutex;
+    std::deque<Job> m_jobs;
+    WakeSignal m_signal;
+};
@@ -6,7 +6,78 @@
 using json = nlohmann::json;
 using namespace std;
 
+namespace {
+
+ReadMode parseReadMode(const std::string& mode) {
+    if (mode == "blocking") return ReadMode::Blocking;
+    if (mode == "poll") return ReadMode::Poll;
+    if (mode == "legacy") return ReadMode::Legacy;
+    return ReadMode::Event;
+}
+
+FileFormat parseFileFormat(const std::string& format) {
+    if (format == "record") return FileFormat::Record;
+    return FileFormat::Text;
+}
+
+TimestampPrecision parseTimestampPrecision(const std::string& precision) {
+    if (precision == "ms") return TimestampPrecision::Milli;
+    if (precision == "us") return TimestampPrecision::Micro;
+    return TimestampPrecision::Second;
+}
+
+FramingMode parseFramingMode(const std::string& mode) {
+    if (mode == "delimiter") return FramingMode::Delimiter;
+    if (mode == "length") return FramingMode::Length;
+    if (mode == "fixed") return FramingMode::Fixed;
+    if (mode == "idleGap") return FramingMode::IdleGap;
+    return FramingMode::None;
+}
+
+MemoryPolicy parseMemoryPolicy(const std::string& policy) {
+    if (policy == "dropOldest") return MemoryPolicy::DropOldest;
+    if (policy == "block") return MemoryPolicy::Block;
+    if (policy == "spill") return MemoryPolicy::Spill;
+    return MemoryPolicy::DropNewest;
+}
+
+SchedulingConfig parseScheduling(const json& scheduling) {
+    SchedulingConfig config;
+    config.cpus = scheduling.value("cpus", std::vector<int>());
+    config.priority = scheduling.value("priority", 0);
+    return config;
+}
+
+Codec parseCodec(const std::string& codec) {
+    if (codec == "zstd") return Codec::Zstd;
+    if (codec == "lz4") return Codec::Lz4;
+    if (codec == "gzip") return Codec::Gzip;
+    return Codec::None;
+}
+
+} // namespace
+
 bool Config::load(const std::string& filename, std::vector<PortConfig>& configs) {
+    CollectorConfig collector;
+    return load(filename, configs, collector);
+}
+
+bool Config::load(const std::string& filename, std::vector<PortConfig>& configs,
+                  CollectorConfig& collector) {
+    collector.reactorThreads = 1;
+    collector.metricsPort = 0;
+    collector.metricsAddress = "127.0.0.1";
+    collector.metricsSocket.clear();
+    collector.headless = false;
+    collector.diskBackend = "write";
+    collector.directIo = false;
+    collector.uringEntries = 256;
+    collector.uringBufferMB = 16;
+    collector.memoryBudgetMB = 0;
+    collector.reactorScheduling = SchedulingConfig();
+    collector.bulkScheduling = SchedulingConfig();
+    collector.lockMemory = false;
+
     std::ifstream file(filename);
     if (!file.is_open()) {
         return saveDefault(filename);
@@ -16,16 +87,60 @@ bool Config::load(const std::string& filename, std::vector<PortConfig>& configs)
         json j;
         file >> j;
 
+        auto collectorJson = j.value("collector", json::object());
+        collector.reactorThreads = collectorJson.value("reactorThreads", 1);
+        collector.metricsPort = collectorJson.value("metricsPort", 0);
+        collector.metricsAddress = collectorJson.value("metricsAddress", std::string("127.0.0.1"));
+        collector.metricsSocket = collectorJson.value("metricsSocket", std::string());
+        collector.headless = collectorJson.value("headless", false);
+        collector.diskBackend = collectorJson.value("diskBackend", std::string("write"));
+        collector.directIo = collectorJson.value("directIo", false);
+        collector.uringEntries = collectorJson.value("uringEntries", 256);
+        collector.uringBufferMB = collectorJson.value("uringBufferMB", 16);
+        collector.memoryBudgetMB = collectorJson.value("memoryBudgetMB", 0);
+        collector.reactorScheduling = parseScheduling(collectorJson.value("reactorScheduling", json::object()));
+        collector.bulkScheduling = parseScheduling(collectorJson.value("bulkScheduling", json::object()));
+        collector.lockMemory = collectorJson.value("lockMemory", false);
+
         configs.clear();
+        int portIndex = 0;
         for (const auto& port : j["ports"]) {
+            ++portIndex;
             PortConfig config;
             config.name = port["name"].get<std::string>();
             config.baudRate = port["baudRate"].get<int>();
             config.dataBits = port["dataBits"].get<int>();
             config.stopBits = port["stopBits"].get<int>();
             config.parity = port["parity"].get<std::string>();
+            config.flowControl = port.value("flowControl", "none");
+            config.lowLatency = port.value("lowLatency", false);
             config.addTimestamp = port["addTimestamp"].get<bool>();
+            config.timestampPrecision = parseTimestampPrecision(port.value("timestampPrecision", "s"));
             config.timeout = port.value("timeout", 60);
+            config.writeBufferSize = port.value("writeBufferSize", 65536);
+            config.flushInterval = port.value("flushInterval", 1000);
+            config.queueCapacity = port.value("queueCapacity", 1024);
+            config.memoryBudgetKB = port.value("memoryBudgetKB", 0);
+            config.memoryPolicy = parseMemoryPolicy(port.value("memoryPolicy", "dropNewest"));
+            config.fileFormat = parseFileFormat(port.value("fileFormat", "text"));
+            config.maxFileMB = port.value("maxFileMB", 0);
+            config.compression = parseCodec(port.value("compression", "none"));
+            config.compressionLevel = port.value("compressionLevel", 0);
+            config.compressionBlockKB = port.value("compressionBlockKB", 1024);
+            config.readMode = parseReadMode(port.value("readMode", "event"));
+            config.vmin = port.value("vmin", 1);
+            config.vtime = port.value("vtime", 1);
+            config.pollTimeout = port.value("pollTimeout", 100);
+            json framing = port.value("framing", json::object());
+            config.framing.mode = parseFramingMode(framing.value("mode", "none"));
+            config.framing.delimiter = framing.value("delimiter", "\n");
+            config.framing.lengthOffset = framing.value("lengthOffset", 0);
+            config.framing.lengthSize = framing.value("lengthSize", 2);
+            config.framing.lengthBigEndian = framing.value("lengthBigEndian", true);
+            config.framing.lengthAdjust = framing.value("lengthAdjust", 0);
+            config.framing.frameSize = framing.value("frameSize", 0);
+            config.framing.idleGapUs = framing.value("idleGapUs", 0);
+            config.framing.maxFrameSize = framing.value("maxFrameSize", 4096);
             config.tcpForward.enabled = port.value("tcpForward", json::object())
                 .value("enabled", false);
             config.tcpForward.server = port.value("tcpForward", json::object())
@@ -34,6 +149,45 @@ bool Config::load(const std::string& filename, std::vector<PortConfig>& configs)
                 .value("port", 8080);
             config.tcpForward.reconnectInterval = port.value("tcpForward", json::object())
                 .value("reconnectInterval", 5);
+            config.tcpForward.reconnectInitialMs = port.value("tcpForward", json::object())
+                .value("reconnectInitialMs", 500);
+            config.tcpForward.connectTimeoutMs = port.value("tcpForward", json::object())
+                .value("connectTimeoutMs", 3000);
+            config.tcpForward.keepAlive = port.value("tcpForward", json::object())
+                .value("keepAlive", true);
+            config.tcpForward.keepAliveIdle = port.value("tcpForward", json::object())
+                .value("keepAliveIdle", 30);
+            config.tcpForward.keepAliveInterval = port.value("tcpForward", json::object())
+                .value("keepAliveInterval", 10);
+            config.tcpForward.keepAliveCount = port.value("tcpForward", json::object())
+                .value("keepAliveCount", 3);
+            config.tcpForward.userTimeoutMs = port.value("tcpForward", json::object())
+                .value("userTimeoutMs", 0);
+            config.tcpForward.coalesceBytes = port.value("tcpForward", json::object())
+                .value("coalesceBytes", 65536);
+            config.tcpForward.coalesceUs = port.value("tcpForward", json::object())
+                .value("coalesceUs", 0);
+            config.tcpForward.noDelay = port.value("tcpForward", json::object())
+                .value("noDelay", false);
+            config.tcpForward.cork = port.value("tcpForward", json::object())
+                .value("cork", false);
+            config.tcpForward.storeAndForward = port.value("tcpForward", json::object())
+                .value("storeAndForward", false);
+            config.tcpForward.spoolSegmentMB = port.value("tcpForward", json::object())
+                .value("spoolSegmentMB", 16);
+            config.tcpForward.spoolMaxMB = port.value("tcpForward", json::object())
+                .value("spoolMaxMB", 1024);
+            config.tcpForward.windowBytes = port.value("tcpForward", json::object())
+                .value("windowBytes", 1048576);
+            config.tcpForward.multiplex = port.value("tcpForward", json::object())
+                .value("multiplex", false);
+            config.tcpForward.portId = port.value("tcpForward", json::object())
+                .value("portId", portIndex);
+            json sharedMemory = port.value("sharedMemory", json::object());
+            config.sharedMemory.enabled = sharedMemory.value("enabled", false);
+            config.sharedMemory.name = sharedMemory.value("name", "");
+            config.sharedMemory.sizeKB = sharedMemory.value("sizeKB", 4096);
+            config.scheduling = parseScheduling(port.value("scheduling", json::object()));
             configs.push_back(config);
         }
     }
@@ -53,8 +207,28 @@ std::vector<PortConfig> Config::getDefaultConfig() {
     config.dataBits = 8;
     config.stopBits = 1;
     config.parity = "none";
+    config.flowControl = "none";
+    config.lowLatency = false;
     config.addTimestamp = true;
+    config.timestampPrecision = TimestampPrecision::Second;
     config.timeout = 60;
+    config.writeBufferSize = 65536;
+    config.flushInterval = 1000;
+    config.queueCapacity = 1024;
+    config.memoryBudgetKB = 0;
+    config.memoryPolicy = MemoryPolicy::DropNewest;
+    config.fileFormat = FileFormat::Text;
+    config.maxFileMB = 0;
+    config.compression = Codec::None;
+    config.compressionLevel = 0;
+    config.compressionBlockKB = 1024;
+    config.readMode = ReadMode::Event;
+    config.vmin = 1;
+    config.vtime = 1;
+    config.pollTimeout = 100;
+    config.framing = { FramingMode::None, "\n", 0, 2, true, 0, 0, 0, 4096 };
+    config.sharedMemory = { false, "", 4096 };
+    config.scheduling = SchedulingConfig();
     configs.push_back(config);
     return configs;
 }
@@ -2,10 +2,41 @@
 #include "SerialPort.h"
 #include <vector>
 #include <string>
+#include <tuple>
+
+// 采集器全局配置
+struct CollectorConfig {
+    int reactorThreads;  // epoll 事件循环线程数
+    int metricsPort;  // 统计接口 TCP 端口，0 为不监听
+    std::string metricsAddress;
+    std::string metricsSocket;  // 统计接口 Unix 套接字路径，空为不监听
+    bool headless;  // 不显示控制台状态，用于作为服务运行
+    std::string diskBackend;  // 数据文件写出方式：write 或 uring（见 DiskBackend.h）
+    bool directIo;  // 整块写入使用 O_DIRECT
+    int uringEntries;  // io_uring 提交队列长度
+    int uringBufferMB;  // 注册给 io_uring 的固定缓冲区大小
+    int memoryBudgetMB;  // 所有串口数据块内存的上限，0 为不限
+    SchedulingConfig reactorScheduling;  // Event 模式的 Reactor 线程
+    SchedulingConfig bulkScheduling;     // 写盘、TCP、压缩、日志等其余线程，由主线程启动时设置后继承
+    bool lockMemory;  // mlockall，避免缺页和换出造成的读取停顿
+};
+
+// 热加载时据此判断 collector 部分是否变化；新增字段时需要同时加到这里
+inline bool operator==(const CollectorConfig& a, const CollectorConfig& b) {
+    return std::tie(a.reactorThreads, a.metricsPort, a.metricsAddress, a.metricsSocket, a.headless,
+                    a.diskBackend, a.directIo, a.uringEntries, a.uringBufferMB, a.memoryBudgetMB,
+                    a.reactorScheduling, a.bulkScheduling, a.lockMemory) ==
+           std::tie(b.reactorThreads, b.metricsPort, b.metricsAddress, b.metricsSocket, b.headless,
+                    b.diskBackend, b.directIo, b.uringEntries, b.uringBufferMB, b.memoryBudgetMB,
+                    b.reactorScheduling, b.bulkScheduling, b.lockMemory);
+}
+inline bool operator!=(const CollectorConfig& a, const CollectorConfig& b) { return !(a == b); }
 
 class Config {
 public:
     static bool load(const std::string& filename, std::vector<PortConfig>& configs);
+    static bool load(const std::string& filename, std::vector<PortConfig>& configs,
+                     CollectorConfig& collector);
     static bool saveDefault(const std::string& filename);
 
 private:
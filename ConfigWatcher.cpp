@@ -0,0 +1,162 @@
+#include "ConfigWatcher.h"
+#include "Logger.h"
+#include <system_error>
+
+#ifdef __linux__
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+namespace {
+
+// 最后一次文件事件后静默该时间才通知，避免读到写了一半的文件
+constexpr int kDebounceMs = 200;
+
+std::filesystem::file_time_type modifiedTime(const std::filesystem::path& path) {
+    std::error_code ec;
+    auto time = std::filesystem::last_write_time(path, ec);
+    return ec ? std::filesystem::file_time_type::min() : time;
+}
+
+} // namespace
+
+ConfigWatcher::ConfigWatcher(std::filesystem::path path, Callback onChange)
+    : m_path(std::filesystem::absolute(path)), m_onChange(std::move(onChange)), m_running(false) {
+#ifdef __linux__
+    m_inotifyFd = -1;
+    m_wakeFd = -1;
+#endif
+}
+
+ConfigWatcher::~ConfigWatcher() {
+    stop();
+}
+
+bool ConfigWatcher::start() {
+#ifdef __linux__
+    m_inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    m_wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_inotifyFd < 0 || m_wakeFd < 0 ||
+        inotify_add_watch(m_inotifyFd, m_path.parent_path().c_str(),
+                          IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0) {
+        // 退回按修改时间轮询
+        LOG_ERROR("Config", std::string("inotify unavailable, polling for changes: ") + std::strerror(errno));
+        if (m_inotifyFd >= 0) {
+            ::close(m_inotifyFd);
+            m_inotifyFd = -1;
+        }
+    }
+#endif
+    m_running = true;
+    m_thread = std::thread(&ConfigWatcher::run, this);
+    return true;
+}
+
+void ConfigWatcher::stop() {
+    if (!m_running.exchange(false)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopped.notify_all();
+    }
+#ifdef __linux__
+    if (m_wakeFd >= 0) {
+        uint64_t one = 1;
+        ssize_t ignored = ::write(m_wakeFd, &one, sizeof(one));
+        (void)ignored;
+    }
+#endif
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+#ifdef __linux__
+    if (m_inotifyFd >= 0) {
+        ::close(m_inotifyFd);
+        m_inotifyFd = -1;
+    }
+    if (m_wakeFd >= 0) {
+        ::close(m_wakeFd);
+        m_wakeFd = -1;
+    }
+#endif
+}
+
+void ConfigWatcher::run() {
+    while (m_running) {
+        bool changed;
+#ifdef __linux__
+        changed = m_inotifyFd >= 0 ? waitInotify() : waitModified();
+#else
+        changed = waitModified();
+#endif
+        if (changed && m_running) {
+            m_onChange();
+        }
+    }
+}
+
+#ifdef __linux__
+bool ConfigWatcher::waitInotify() {
+    pollfd fds[2] = {};
+    fds[0].fd = m_inotifyFd;
+    fds[0].events = POLLIN;
+    fds[1].fd = m_wakeFd;
+    fds[1].events = POLLIN;
+
+    // 有配置文件的事件后继续等到静默 kDebounceMs 为止
+    bool changed = false;
+    std::string filename = m_path.filename().string();
+    while (m_running) {
+        int ready = ::poll(fds, 2, changed ? kDebounceMs : -1);
+        if (ready < 0 && errno != EINTR) {
+            return false;
+        }
+        if (ready == 0) {
+            return changed;
+        }
+        if (fds[1].revents) {
+            return false;
+        }
+        if (!(fds[0].revents & POLLIN)) {
+            continue;
+        }
+
+        alignas(inotify_event) char buffer[4096];
+        ssize_t size;
+        while ((size = ::read(m_inotifyFd, buffer, sizeof(buffer))) > 0) {
+            for (ssize_t offset = 0; offset < size;) {
+                auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+                if (event->len > 0 && filename == event->name) {
+                    changed = true;
+                }
+                offset += sizeof(inotify_event) + event->len;
+            }
+        }
+    }
+    return false;
+}
+#endif
+
+bool ConfigWatcher::waitModified() {
+    auto last = modifiedTime(m_path);
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (m_running) {
+        m_stopped.wait_for(lock, std::chrono::seconds(1));
+        if (!m_running) {
+            return false;
+        }
+        auto now = modifiedTime(m_path);
+        if (now != last) {
+            // 与 inotify 一样等写入结束
+            lock.unlock();
+            std::this_thread::sleep_for(std::chrono::milliseconds(kDebounceMs));
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// 监视配置文件，内容变化后在监视线程中调用回调。
+// Linux 用 inotify 监视所在目录（编辑器多为写临时文件再改名），其他平台每秒检查修改时间；
+// 连续的写入合并为一次通知
+class ConfigWatcher {
+public:
+    using Callback = std::function<void()>;
+
+    ConfigWatcher(std::filesystem::path path, Callback onChange);
+    ~ConfigWatcher();
+
+    ConfigWatcher(const ConfigWatcher&) = delete;
+    ConfigWatcher& operator=(const ConfigWatcher&) = delete;
+
+    bool start();
+    void stop();
+
+private:
+    void run();
+#ifdef __linux__
+    bool waitInotify();
+#endif
+    bool waitModified();
+
+    std::filesystem::path m_path;
+    Callback m_onChange;
+    std::atomic<bool> m_running;
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_stopped;
+#ifdef __linux__
+    int m_inotifyFd;
+    int m_wakeFd;
+#endif
+};
@@ -0,0 +1,30 @@
+#include "CustomBaud.h"
+
+#ifdef __linux__
+#include <asm/termbits.h>
+#include <sys/ioctl.h>
+
+bool setCustomBaudRate(int fd, int baudRate) {
+    struct termios2 options;
+    if (ioctl(fd, TCGETS2, &options) != 0) {
+        return false;
+    }
+    options.c_cflag &= ~CBAUD;
+    options.c_cflag |= BOTHER;
+    options.c_cflag &= ~(CBAUD << IBSHIFT);
+    options.c_cflag |= BOTHER << IBSHIFT;
+    options.c_ispeed = static_cast<speed_t>(baudRate);
+    options.c_ospeed = static_cast<speed_t>(baudRate);
+    return ioctl(fd, TCSETS2, &options) == 0;
+}
+
+bool getBaudRate(int fd, int& inputBaud, int& outputBaud) {
+    struct termios2 options;
+    if (ioctl(fd, TCGETS2, &options) != 0) {
+        return false;
+    }
+    inputBaud = static_cast<int>(options.c_ispeed);
+    outputBaud = static_cast<int>(options.c_ospeed);
+    return true;
+}
+#endif
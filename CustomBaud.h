@@ -0,0 +1,11 @@
+#pragma once
+
+// Linux 下通过 termios2/BOTHER 设置任意波特率（921600、3000000 以及非标准速率）
+// <asm/termbits.h> 与 glibc 的 <termios.h> 定义了同名结构，不能在同一个编译单元中包含，
+// 所以放在单独的文件里，SerialPort 先用 tcsetattr 设置其他参数再调用这里
+#ifdef __linux__
+// 输入输出速率都设为 baudRate，驱动不支持时返回 false
+bool setCustomBaudRate(int fd, int baudRate);
+// 读回驱动实际使用的速率，可能被取整到硬件分频能达到的值
+bool getBaudRate(int fd, int& inputBaud, int& outputBaud);
+#endif
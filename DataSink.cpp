@@ -0,0 +1,600 @@
+#include "DataSink.h"
+#include "Common.h"
+#include "Logger.h"
+#include "Record.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <map>
+#include <new>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace {
+
+int seekFile(std::FILE* file, uint64_t offset) {
+#ifdef _WIN32
+    return _fseeki64(file, static_cast<__int64>(offset), SEEK_SET);
+#else
+    return fseeko(file, static_cast<off_t>(offset), SEEK_SET);
+#endif
+}
+
+// 解析分段文件名 YYYYMMDD[.N]<ext>[<压缩扩展名>]；day 为空时匹配任意日期
+bool parseSegmentName(const std::string& file, const std::string& day, const std::string& ext,
+                      unsigned& index, bool& compressed) {
+    if (file.size() < 8 || !std::all_of(file.begin(), file.begin() + 8, ::isdigit) ||
+        (!day.empty() && file.compare(0, 8, day) != 0)) {
+        return false;
+    }
+    size_t pos = 8;
+    index = 0;
+    if (file.compare(pos, ext.size(), ext) != 0) {
+        size_t end = pos + 1;
+        while (end < file.size() && std::isdigit(static_cast<unsigned char>(file[end]))) {
+            ++end;
+        }
+        if (file[pos] != '.' || end == pos + 1 || end - pos > 10 ||
+            file.compare(end, ext.size(), ext) != 0) {
+            return false;
+        }
+        index = static_cast<unsigned>(std::stoul(file.substr(pos + 1, end - pos - 1)));
+        pos = end;
+    }
+    std::string suffix = file.substr(pos + ext.size());
+    compressed = suffix == codecExtension(Codec::Zstd) || suffix == codecExtension(Codec::Lz4) ||
+                 suffix == codecExtension(Codec::Gzip);
+    return suffix.empty() || compressed;
+}
+
+} // namespace
+
+DataSink::DataSink(const std::string& portName, bool addTimestamp,
+                   size_t blockSize, int flushIntervalMs, FileFormat format,
+                   TimestampPrecision precision, DiskBackend* backend)
+    : m_addTimestamp(addTimestamp), m_format(format),
+      m_blockSize(std::max(blockSize, kBlockAlignment)),
+      m_flushInterval(flushIntervalMs),
+      m_block(nullptr), m_used(0), m_file(nullptr), m_backend(backend), m_directFd(-1),
+      m_blockStart(0), m_flushed(0), m_fileOffset(0), m_dayEnd(0),
+      m_lastFlush(std::chrono::steady_clock::now()), m_maxFileBytes(0), m_scanned(false),
+      m_timestamp(precision), m_indexFile(nullptr), m_durable(0), m_nextIndexAt(0),
+      m_bytesWritten(0) {
+    // Linux 下串口名是设备路径（/dev/ttyUSB0），只取最后一段作为目录名
+    m_dir = std::filesystem::path("data") / std::filesystem::path(portName).filename();
+
+    // 块大小向上取整到对齐边界
+    m_blockSize = (m_blockSize + kBlockAlignment - 1) / kBlockAlignment * kBlockAlignment;
+    // 使用后端时块在打开文件时向后端申请，关闭时归还
+    if (!m_backend) {
+        m_block = static_cast<char*>(::operator new[](m_blockSize, std::align_val_t(kBlockAlignment)));
+    }
+}
+
+DataSink::~DataSink() {
+    close();
+    if (!m_backend) {
+        ::operator delete[](m_block, std::align_val_t(kBlockAlignment));
+    }
+}
+
+bool DataSink::openFile(time_t now) {
+    closeFile();
+
+    std::error_code ec;
+    std::filesystem::create_directories(m_dir, ec);
+
+    struct tm timeinfo;
+    localtime_s(&timeinfo, &now);
+    char name[16];
+    std::strftime(name, sizeof(name), "%Y%m%d", &timeinfo);
+
+    std::string ext = m_format == FileFormat::Record ? ".rec" : ".data";
+    unsigned index = selectSegment(name, ext);
+    m_path = m_dir / (std::string(name) + (index > 0 ? "." + std::to_string(index) : "") + ext);
+    if (!m_scanned) {
+        m_scanned = true;
+        reportClosedSegments(ext);
+    }
+
+    bool opened;
+    if (m_format == FileFormat::Record) {
+        opened = openRecordFile(m_path);
+    } else {
+        m_file = std::fopen(m_path.string().c_str(), "a");
+        opened = m_file != nullptr;
+        if (opened) {
+            // 缓冲由 m_block 负责，关闭 stdio 自身的缓冲（必须在第一次读写之前）
+            std::setvbuf(m_file, nullptr, _IONBF, 0);
+        } else {
+            LOG_ERROR(m_dir.filename().string(), "Failed to open data file: " + m_path.string());
+        }
+        m_fileOffset = opened ? std::filesystem::file_size(m_path, ec) : 0;
+    }
+    if (!opened) {
+        closeFile();
+        return false;
+    }
+    m_durable = m_fileOffset;
+    if (m_backend) {
+        prepareBackend();
+    }
+
+    timeinfo.tm_hour = 0;
+    timeinfo.tm_min = 0;
+    timeinfo.tm_sec = 0;
+    timeinfo.tm_mday += 1;
+    timeinfo.tm_isdst = -1;
+    m_dayEnd = std::mktime(&timeinfo);
+    return true;
+}
+
+unsigned DataSink::selectSegment(const std::string& day, const std::string& ext) const {
+    // 当天最后一个分段未压缩且未写满时接着写，否则新开一个分段
+    std::map<unsigned, uint64_t> segments;  // 序号 -> 未压缩文件大小，已压缩为 UINT64_MAX
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(m_dir, ec)) {
+        unsigned index;
+        bool compressed;
+        if (!parseSegmentName(entry.path().filename().string(), day, ext, index, compressed)) {
+            continue;
+        }
+        uint64_t size = compressed ? UINT64_MAX : entry.file_size(ec);
+        auto it = segments.find(index);
+        segments[index] = it == segments.end() ? size : std::min(it->second, size);
+    }
+    if (segments.empty()) {
+        return 0;
+    }
+    auto last = segments.rbegin();
+    bool full = last->second == UINT64_MAX || (m_maxFileBytes > 0 && last->second >= m_maxFileBytes);
+    return full ? last->first + 1 : last->first;
+}
+
+void DataSink::reportClosedSegments(const std::string& ext) const {
+    // 以前运行留下的未压缩分段（除了正要继续写的分段）交给压缩，按文件名即时间顺序
+    if (!m_onClosed) {
+        return;
+    }
+    std::vector<std::filesystem::path> closed;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(m_dir, ec)) {
+        unsigned index;
+        bool compressed;
+        if (entry.path() != m_path && entry.is_regular_file(ec) &&
+            parseSegmentName(entry.path().filename().string(), "", ext, index, compressed) &&
+            !compressed) {
+            closed.push_back(entry.path());
+        }
+    }
+    std::sort(closed.begin(), closed.end());
+    for (const auto& path : closed) {
+        m_onClosed(path);
+    }
+}
+
+void DataSink::setRotation(uint64_t maxBytes,
+                           std::function<void(const std::filesystem::path&)> onClosed) {
+    m_maxFileBytes = maxBytes;
+    m_onClosed = std::move(onClosed);
+}
+
+bool DataSink::write(const char* data, size_t size) {
+    return write(data, size, std::chrono::system_clock::now());
+}
+
+bool DataSink::write(const char* data, size_t size, std::chrono::system_clock::time_point time,
+                     uint16_t flags) {
+    if (size == 0) {
+        return true;
+    }
+
+    time_t now = std::chrono::system_clock::to_time_t(time);
+    bool full = m_maxFileBytes > 0 && m_fileOffset >= m_maxFileBytes;
+    if (!m_file || now >= m_dayEnd || full) {
+        // 切换前先把旧数据写入原来的文件
+        flush();
+        std::filesystem::path closed = m_file ? m_path : std::filesystem::path();
+        bool opened = openFile(now);
+        if (!closed.empty() && m_onClosed) {
+            m_onClosed(closed);
+        }
+        if (!opened) {
+            return false;
+        }
+    }
+
+    if (m_format == FileFormat::Record) {
+        // 每隔 kRecordIndexInterval 字节为记录起点记一个索引条目
+        uint64_t timestampNs = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count());
+        if (m_fileOffset >= m_nextIndexAt) {
+            m_indexPending.emplace_back(timestampNs, m_fileOffset);
+            m_nextIndexAt = m_fileOffset + kRecordIndexInterval;
+        }
+        char header[kRecordHeaderSize];
+        encodeRecordHeader({ static_cast<uint32_t>(size), flags, timestampNs }, header);
+        append(header, sizeof(header));
+        append(data, size);
+        flushIfDue();
+        return true;
+    }
+
+    if (m_addTimestamp) {
+        char prefix[TimestampFormatter::kMaxLength];
+        append(prefix, m_timestamp.format(time, prefix));
+    }
+
+    append(data, size);
+    if (data[size - 1] != '\n') {
+        append("\n", 1);
+    }
+
+    flushIfDue();
+    return true;
+}
+
+void DataSink::append(const char* data, size_t size) {
+    // 填满一个块就整块写出，保证写盘大小与块对齐
+    while (size > 0) {
+        size_t n = std::min(size, m_blockSize - m_used);
+        std::memcpy(m_block + m_used, data, n);
+        m_used += n;
+        m_fileOffset += n;
+        data += n;
+        size -= n;
+        if (m_used == m_blockSize) {
+            writeBlock();
+        }
+    }
+}
+
+void DataSink::prepareBackend() {
+#ifndef _WIN32
+    std::string port = m_dir.filename().string();
+    int fd = fileno(m_file);
+    // 后端按偏移写入（pwrite / io_uring），追加模式下偏移会被忽略
+    int flags = fcntl(fd, F_GETFL);
+    if (flags >= 0 && (flags & O_APPEND)) {
+        fcntl(fd, F_SETFL, flags & ~O_APPEND);
+    }
+    if (!m_block) {
+        m_block = m_backend->allocate(m_blockSize);
+    }
+    m_used = 0;
+    m_flushed = 0;
+    m_blockStart = m_fileOffset;
+    if (!m_backend->direct()) {
+        return;
+    }
+
+    m_directFd = ::open(m_path.string().c_str(), O_WRONLY | O_DIRECT | O_CLOEXEC);
+    if (m_directFd < 0) {
+        LOG_ERROR(port, std::string("O_DIRECT not supported for data file (") + std::strerror(errno) +
+                  "), using buffered writes: " + m_path.string());
+        return;
+    }
+    // 块从对齐位置开始，文件末尾不足一页的部分先读回块中，写满后随整块一起覆盖
+    m_blockStart = m_fileOffset / kBlockAlignment * kBlockAlignment;
+    size_t tail = static_cast<size_t>(m_fileOffset - m_blockStart);
+    if (tail > 0) {
+        int readFd = ::open(m_path.string().c_str(), O_RDONLY | O_CLOEXEC);
+        ssize_t got = readFd >= 0 ? ::pread(readFd, m_block, tail, static_cast<off_t>(m_blockStart)) : -1;
+        if (readFd >= 0) {
+            ::close(readFd);
+        }
+        if (got != static_cast<ssize_t>(tail)) {
+            LOG_ERROR(port, "Failed to read data file tail, using buffered writes: " + m_path.string());
+            ::close(m_directFd);
+            m_directFd = -1;
+            m_blockStart = m_fileOffset;
+            return;
+        }
+    }
+    m_used = tail;
+    m_flushed = tail;
+#endif
+}
+
+void DataSink::writeBlock() {
+    // 块已写满
+    if (!m_backend) {
+        writeOut(m_block, m_used);
+        m_used = 0;
+        return;
+    }
+    if (m_directFd >= 0) {
+        // 整块对齐，绕过页缓存写出；其中已刷新过的部分被相同的内容覆盖
+        submit(m_block, m_blockSize, m_blockSize, m_blockStart, true);
+    } else {
+        submit(m_block, m_blockSize, m_used, m_blockStart, false);
+    }
+    m_block = m_backend->allocate(m_blockSize);
+    m_blockStart += m_used;
+    m_used = 0;
+    m_flushed = 0;
+}
+
+void DataSink::writeTail() {
+    // 刷新未写满的块
+    if (!m_backend) {
+        writeOut(m_block, m_used);
+        m_used = 0;
+        return;
+    }
+    if (m_directFd < 0) {
+        writeBlock();
+        return;
+    }
+    // O_DIRECT 要求长度对齐，尾部复制一份经页缓存写出，块本身留着继续填充
+    char* tail = m_backend->allocate(m_blockSize);
+    size_t length = m_used - m_flushed;
+    std::memcpy(tail, m_block + m_flushed, length);
+    submit(tail, m_blockSize, length, m_blockStart + m_flushed, false);
+    m_flushed = m_used;
+}
+
+void DataSink::submit(char* block, size_t size, size_t length, uint64_t offset, bool direct) {
+    if (!m_file) {
+        m_backend->release(block, size);
+        return;
+    }
+    int fd = direct ? m_directFd : fileno(m_file);
+    // 直接写出时整块中只有 m_flushed 之后的部分是新数据
+    m_bytesWritten += direct ? length - m_flushed : length;
+    uint64_t ticket = m_backend->write(fd, block, size, length, offset);
+    m_backendWrites.emplace_back(ticket, offset + length);
+    m_lastFlush = std::chrono::steady_clock::now();
+    if (!m_indexPending.empty()) {
+        writeIndex();
+    }
+}
+
+void DataSink::writeOut(const char* data, size_t size) {
+    if (!m_file) {
+        return;
+    }
+    size_t written = std::fwrite(data, 1, size, m_file);
+    if (written != size) {
+        LOG_ERROR(m_dir.filename().string(), "Short write to data file");
+    }
+    m_bytesWritten += written;
+    if (written == size) {
+        m_durable = m_fileOffset;
+    }
+    m_lastFlush = std::chrono::steady_clock::now();
+    if (!m_indexPending.empty()) {
+        writeIndex();
+    }
+}
+
+void DataSink::updateDurable() {
+    // 后端（uring）的写入可能在提交很久之后才完成，而且不按顺序；只有之前的写入都完成后数据才连续有效
+    uint64_t completed = m_backend->completed();
+    while (!m_backendWrites.empty() && m_backendWrites.front().first <= completed) {
+        m_durable = std::max(m_durable, m_backendWrites.front().second);
+        m_backendWrites.pop_front();
+    }
+}
+
+void DataSink::writeIndex() {
+    // 只写出已写入文件的记录的条目，索引总是指向数据文件中已存在的位置
+    if (m_backend) {
+        updateDurable();
+    }
+    size_t count = 0;
+    char entry[kRecordIndexEntrySize];
+    while (count < m_indexPending.size() && m_indexPending[count].second < m_durable) {
+        if (m_indexFile) {
+            encodeRecordIndexEntry(m_indexPending[count].first, m_indexPending[count].second, entry);
+            std::fwrite(entry, 1, sizeof(entry), m_indexFile);
+        }
+        ++count;
+    }
+    if (count > 0 && m_indexFile) {
+        std::fflush(m_indexFile);
+    }
+    m_indexPending.erase(m_indexPending.begin(), m_indexPending.begin() + count);
+}
+
+void DataSink::flushIfDue() {
+    if (m_backend && !m_indexPending.empty()) {
+        writeIndex();  // 上一轮提交的写入可能已完成
+    }
+    if (m_used > m_flushed && std::chrono::steady_clock::now() - m_lastFlush >= m_flushInterval) {
+        flush();
+    }
+}
+
+void DataSink::flush() {
+    if (m_used > m_flushed) {
+        writeTail();
+    }
+    m_lastFlush = std::chrono::steady_clock::now();
+}
+
+void DataSink::close() {
+    flush();
+    closeFile();
+}
+
+void DataSink::closeFile() {
+    if (m_backend) {
+        // 关闭句柄前等后端写完，避免提交队列中的写入落到复用的句柄上
+        if (m_file) {
+            m_backend->wait();
+            if (!m_indexPending.empty()) {
+                writeIndex();
+            }
+        }
+        m_backendWrites.clear();
+#ifndef _WIN32
+        if (m_directFd >= 0) {
+            ::close(m_directFd);
+            m_directFd = -1;
+        }
+#endif
+        if (m_block) {
+            m_backend->release(m_block, m_blockSize);
+            m_block = nullptr;
+        }
+        m_used = 0;
+        m_flushed = 0;
+        m_blockStart = 0;
+    }
+    if (m_file) {
+        std::fclose(m_file);
+        m_file = nullptr;
+    }
+    if (m_indexFile) {
+        std::fclose(m_indexFile);
+        m_indexFile = nullptr;
+    }
+    m_indexPending.clear();
+    m_fileOffset = 0;
+    m_durable = 0;
+    m_nextIndexAt = 0;
+}
+
+bool DataSink::openRecordFile(const std::filesystem::path& path) {
+    auto indexPath = path;
+    indexPath.replace_extension(".idx");
+    std::string port = m_dir.filename().string();
+
+    // 同一天重启时接着已有文件写，先截掉上次异常退出留下的不完整记录
+    m_fileOffset = recoverRecordFile(path, indexPath);
+
+    m_file = std::fopen(path.string().c_str(), "ab");
+    if (!m_file) {
+        LOG_ERROR(port, "Failed to open data file: " + path.string());
+        return false;
+    }
+    std::setvbuf(m_file, nullptr, _IONBF, 0);
+    if (m_fileOffset == 0) {
+        char header[kRecordFileHeaderSize];
+        encodeRecordFileHeader(kRecordMagic, header);
+        if (std::fwrite(header, 1, sizeof(header), m_file) != sizeof(header)) {
+            LOG_ERROR(port, "Failed to write data file header: " + path.string());
+            return false;
+        }
+        m_fileOffset = sizeof(header);
+        m_bytesWritten += sizeof(header);
+    }
+
+    std::error_code ec;
+    uint64_t indexSize = std::filesystem::file_size(indexPath, ec);
+    if (ec) {
+        indexSize = 0;
+    }
+    m_indexFile = std::fopen(indexPath.string().c_str(), "ab");
+    if (!m_indexFile) {
+        // 没有索引也能读取，只是按时间查找需要从头扫描
+        LOG_ERROR(port, "Failed to open index file: " + indexPath.string());
+        return true;
+    }
+    if (indexSize == 0) {
+        char header[kRecordFileHeaderSize];
+        encodeRecordFileHeader(kRecordIndexMagic, header);
+        std::fwrite(header, 1, sizeof(header), m_indexFile);
+        std::fflush(m_indexFile);
+    }
+    return true;
+}
+
+uint64_t DataSink::recoverRecordFile(const std::filesystem::path& path,
+                                     const std::filesystem::path& indexPath) {
+    std::string port = m_dir.filename().string();
+    std::error_code ec;
+    uint64_t size = std::filesystem::file_size(path, ec);
+    if (ec || size == 0) {
+        // 没有数据文件时旧索引已无意义
+        std::filesystem::remove(indexPath, ec);
+        return 0;
+    }
+
+    std::FILE* file = std::fopen(path.string().c_str(), "rb");
+    char header[kRecordFileHeaderSize];
+    bool valid = file && std::fread(header, 1, sizeof(header), file) == sizeof(header) &&
+                 checkRecordFileHeader(kRecordMagic, header);
+    if (!valid) {
+        if (file) {
+            std::fclose(file);
+        }
+        // 不是本程序写的记录文件，保留原文件另起新文件
+        auto badPath = path;
+        badPath += ".bad";
+        LOG_ERROR(port, "Unrecognized data file, renamed to " + badPath.string());
+        std::filesystem::rename(path, badPath, ec);
+        std::filesystem::remove(indexPath, ec);
+        return 0;
+    }
+
+    // 从最后一个落在文件内的索引条目开始检查记录，不需要扫描整个文件
+    uint64_t start = kRecordFileHeaderSize;
+    uint64_t entries = 0;
+    std::FILE* index = std::fopen(indexPath.string().c_str(), "rb");
+    if (index) {
+        char entry[kRecordIndexEntrySize];
+        if (std::fread(header, 1, sizeof(header), index) == sizeof(header) &&
+            checkRecordFileHeader(kRecordIndexMagic, header)) {
+            uint64_t indexSize = std::filesystem::file_size(indexPath, ec);
+            entries = ec ? 0 : (indexSize - kRecordFileHeaderSize) / kRecordIndexEntrySize;
+        }
+        while (entries > 0) {
+            uint64_t timestampNs;
+            uint64_t offset;
+            seekFile(index, kRecordFileHeaderSize + (entries - 1) * kRecordIndexEntrySize);
+            if (std::fread(entry, 1, sizeof(entry), index) == sizeof(entry)) {
+                decodeRecordIndexEntry(entry, timestampNs, offset);
+                if (offset >= kRecordFileHeaderSize && offset < size) {
+                    start = offset;
+                    break;
+                }
+            }
+            --entries;
+        }
+        std::fclose(index);
+    }
+
+    uint64_t end = start;
+    char recordHeader[kRecordHeaderSize];
+    while (seekFile(file, end) == 0 &&
+           std::fread(recordHeader, 1, sizeof(recordHeader), file) == sizeof(recordHeader)) {
+        uint64_t next = end + kRecordHeaderSize + decodeRecordHeader(recordHeader).length;
+        if (next > size) {
+            break;
+        }
+        end = next;
+    }
+    std::fclose(file);
+
+    if (end < size) {
+        LOG_ERROR(port, "Truncating " + std::to_string(size - end) +
+                  " bytes of incomplete record at the end of " + path.string());
+        std::filesystem::resize_file(path, end, ec);
+        if (ec) {
+            // 不能在不完整的记录之后追加，保留原文件另起新文件
+            auto badPath = path;
+            badPath += ".bad";
+            LOG_ERROR(port, "Failed to truncate data file (" + ec.message() + "), renamed to " +
+                      badPath.string());
+            std::filesystem::rename(path, badPath, ec);
+            std::filesystem::remove(indexPath, ec);
+            return 0;
+        }
+    }
+
+    // 最后一个条目指向被截掉的记录时一并删除，下一条记录重新记条目
+    bool keepLast = entries > 0 && start < end;
+    if (entries > 0 && !keepLast) {
+        --entries;
+    }
+    std::filesystem::resize_file(indexPath, entries > 0 ?
+        kRecordFileHeaderSize + entries * kRecordIndexEntrySize : 0, ec);
+    m_nextIndexAt = keepLast ? start + kRecordIndexInterval : 0;
+    return end;
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include "Common.h"
+#include "DiskBackend.h"
+#include "Timestamp.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+// 单个串口的数据文件写入器
+// 保持文件句柄常开，记录先写入对齐的内存块，写满或超过刷新间隔时才落盘；
+// 在日期变化或超过分段大小时切换文件：当天第一个分段为 YYYYMMDD.data，之后为 YYYYMMDD.N.data；
+// Record 格式写 .rec 和稀疏索引 .idx
+// 指定 backend 时块交给后端写出（见 DiskBackend.h），否则用 stdio 同步写出
+class DataSink {
+public:
+    static constexpr size_t kDefaultBlockSize = 64 * 1024;
+    static constexpr size_t kBlockAlignment = 4096;
+
+    DataSink(const std::string& portName, bool addTimestamp,
+             size_t blockSize = kDefaultBlockSize, int flushIntervalMs = 1000,
+             FileFormat format = FileFormat::Text,
+             TimestampPrecision precision = TimestampPrecision::Second,
+             DiskBackend* backend = nullptr);
+    ~DataSink();
+
+    DataSink(const DataSink&) = delete;
+    DataSink& operator=(const DataSink&) = delete;
+
+    // 追加一条记录：文本格式为可选时间戳前缀 + 数据 + 缺失时补换行，
+    // Record 格式为记录头 + 原样数据；flags（RecordFlag）只用于 Record 格式
+    bool write(const char* data, size_t size);
+    bool write(const char* data, size_t size, std::chrono::system_clock::time_point time,
+               uint16_t flags = 0);
+    // 单个分段超过 maxBytes（0 为不限）时切换到同一天的下一个分段
+    // 分段关闭后调用 onClosed：切换分段、跨天，以及首次打开文件时发现的以前的未压缩分段
+    void setRotation(uint64_t maxBytes, std::function<void(const std::filesystem::path&)> onClosed);
+
+    void flushIfDue();  // 超过刷新间隔时落盘
+    void flush();
+    void close();
+
+    const std::filesystem::path& directory() const { return m_dir; }
+    uint64_t bytesWritten() const { return m_bytesWritten; }
+
+private:
+    bool openFile(time_t now);
+    unsigned selectSegment(const std::string& day, const std::string& ext) const;
+    void reportClosedSegments(const std::string& ext) const;
+    bool openRecordFile(const std::filesystem::path& path);
+    uint64_t recoverRecordFile(const std::filesystem::path& path,
+                               const std::filesystem::path& indexPath);
+    void closeFile();
+    void prepareBackend();
+    void append(const char* data, size_t size);
+    void writeBlock();
+    void writeTail();
+    void writeOut(const char* data, size_t size);
+    void submit(char* block, size_t size, size_t length, uint64_t offset, bool direct);
+    void writeIndex();
+    void updateDurable();
+
+    std::filesystem::path m_dir;
+    bool m_addTimestamp;
+    FileFormat m_format;
+    size_t m_blockSize;
+    std::chrono::milliseconds m_flushInterval;
+
+    char* m_block;
+    size_t m_used;
+    std::FILE* m_file;
+    DiskBackend* m_backend;
+    // O_DIRECT：块对应文件中对齐的一段（从 m_blockStart 开始），满块经 m_directFd 写出；
+    // 刷新时只用普通句柄写出块中 m_flushed 之后的部分，块继续填充，写满后整块覆盖
+    int m_directFd;
+    uint64_t m_blockStart;
+    size_t m_flushed;
+    std::filesystem::path m_path;
+    uint64_t m_fileOffset;  // 当前文件的长度，包括块中尚未写出的数据
+    time_t m_dayEnd;  // 当前文件日期的结束时刻（下一个本地零点）
+    std::chrono::steady_clock::time_point m_lastFlush;
+
+    uint64_t m_maxFileBytes;
+    std::function<void(const std::filesystem::path&)> m_onClosed;
+    bool m_scanned;  // 已检查过目录中以前的分段
+
+    TimestampFormatter m_timestamp;
+
+    // Record 格式的稀疏索引：条目在对应数据写入文件后才写入索引文件
+    std::FILE* m_indexFile;
+    std::vector<std::pair<uint64_t, uint64_t>> m_indexPending;  // (时间戳, 记录偏移)
+    // 交给后端尚未确认完成的写入：(写入编号, 完成后文件中连续有效数据的长度)
+    std::deque<std::pair<uint64_t, uint64_t>> m_backendWrites;
+    uint64_t m_durable;  // 文件中已写入的连续数据长度
+    uint64_t m_nextIndexAt;  // 从该偏移起的第一条记录写入下一个索引条目
+
+    uint64_t m_bytesWritten;
+};
@@ -0,0 +1,132 @@
+// 数据文件写入吞吐量对比：旧版 saveToFile（每块打开/关闭文件）与 DataSink
+// 以及每块时间戳的开销：旧版 now + localtime_s + put_time 与 WallClock + TimestampFormatter
+// 用法: DataSinkBench [块数量] [块大小]
+#include "DataSink.h"
+#include "Timestamp.h"
+#include "Common.h"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::string getDateString() {
+    auto now = std::chrono::system_clock::now();
+    auto time = std::chrono::system_clock::to_time_t(now);
+    struct tm timeinfo;
+    localtime_s(&timeinfo, &time);
+
+    std::ostringstream oss;
+    oss << std::put_time(&timeinfo, "%Y%m%d");
+    return oss.str();
+}
+
+// v1.0.2 中 main.cpp 的实现
+void saveToFile(const std::string& portName, bool addTimestamp, const std::vector<char>& buffer) {
+    auto now = std::chrono::system_clock::now();
+    auto time = std::chrono::system_clock::to_time_t(now);
+
+    std::filesystem::path dirPath = "data";
+    dirPath /= portName;
+    std::filesystem::create_directories(dirPath);
+
+    std::string filename = getDateString() + ".data";
+    auto filepath = dirPath / filename;
+
+    std::ofstream file(filepath, std::ios::app);
+
+    if (addTimestamp) {
+        struct tm timeinfo;
+        localtime_s(&timeinfo, &time);
+        file << std::put_time(&timeinfo, "[%Y-%m-%d %H:%M:%S] ");
+    }
+
+    file.write(buffer.data(), buffer.size());
+    if (buffer.back() != '\n') {
+        file << std::endl;
+    }
+}
+
+void report(const char* name, size_t chunks, size_t chunkSize, double seconds) {
+    double mb = static_cast<double>(chunks * chunkSize) / (1024.0 * 1024.0);
+    std::cout << std::left << std::setw(12) << name << std::right
+              << std::setw(12) << std::fixed << std::setprecision(3) << seconds << " s"
+              << std::setw(14) << std::setprecision(1) << chunks / seconds << " chunks/s"
+              << std::setw(12) << std::setprecision(2) << mb / seconds << " MB/s" << std::endl;
+}
+
+// 旧版每个数据块的时间戳前缀
+size_t legacyTimestamp(std::ostringstream& oss) {
+    auto now = std::chrono::system_clock::now();
+    auto time = std::chrono::system_clock::to_time_t(now);
+    struct tm timeinfo;
+    localtime_s(&timeinfo, &time);
+    oss.str("");
+    oss << std::put_time(&timeinfo, "[%Y-%m-%d %H:%M:%S] ");
+    return oss.str().size();
+}
+
+void benchTimestamps(size_t count) {
+    size_t sink = 0;
+    std::ostringstream oss;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i) {
+        sink += legacyTimestamp(oss);
+    }
+    double legacy = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    TimestampFormatter formatter(TimestampPrecision::Micro);
+    char prefix[TimestampFormatter::kMaxLength];
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i) {
+        sink += formatter.format(WallClock::fromSteady(std::chrono::steady_clock::now()), prefix);
+    }
+    double cached = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "Timestamp (s, localtime):   " << legacy * 1e9 / count << " ns/chunk\n"
+              << "Timestamp (us, cached):     " << cached * 1e9 / count << " ns/chunk"
+              << (sink == 0 ? " " : "") << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t chunks = argc > 1 ? std::stoul(argv[1]) : 100000;
+    size_t chunkSize = argc > 2 ? std::stoul(argv[2]) : 64;
+
+    std::vector<char> buffer(chunkSize, 'x');
+    buffer.back() = '\n';
+
+    std::cout << "Writing " << chunks << " chunks of " << chunkSize << " bytes" << std::endl;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < chunks; ++i) {
+        saveToFile("bench_legacy", true, buffer);
+    }
+    double legacy = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    report("saveToFile", chunks, chunkSize, legacy);
+
+    start = std::chrono::steady_clock::now();
+    {
+        DataSink sink("bench_sink", true);
+        for (size_t i = 0; i < chunks; ++i) {
+            sink.write(buffer.data(), buffer.size());
+        }
+    }
+    double sink = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    report("DataSink", chunks, chunkSize, sink);
+
+    std::cout << "Speedup: " << std::setprecision(1) << legacy / sink << "x" << std::endl;
+
+    benchTimestamps(chunks * 10);
+
+    std::filesystem::remove_all(std::filesystem::path("data") / "bench_legacy");
+    std::filesystem::remove_all(std::filesystem::path("data") / "bench_sink");
+    return 0;
+}
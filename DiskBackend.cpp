@@ -0,0 +1,312 @@
+#include "DiskBackend.h"
+#include "Logger.h"
+#include <atomic>
+#include <cstring>
+#include <set>
+#include <map>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <cerrno>
+#endif
+#ifdef __linux__
+#include "IoUring.h"
+#endif
+
+#ifndef _WIN32
+namespace {
+
+char* allocateAligned(size_t size) {
+    return static_cast<char*>(::operator new[](size, std::align_val_t(DiskBackend::kAlignment)));
+}
+
+void releaseAligned(char* block) {
+    ::operator delete[](block, std::align_val_t(DiskBackend::kAlignment));
+}
+
+// 写完为止，返回是否成功
+bool writeAll(int fd, const char* data, size_t length, uint64_t offset, uint64_t& syscalls) {
+    while (length > 0) {
+        ssize_t written = ::pwrite(fd, data, length, static_cast<off_t>(offset));
+        ++syscalls;
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            LOG_ERROR("Disk", std::string("Data file write failed: ") +
+                      (written < 0 ? std::strerror(errno) : "no progress"));
+            return false;
+        }
+        data += written;
+        length -= static_cast<size_t>(written);
+        offset += static_cast<uint64_t>(written);
+    }
+    return true;
+}
+
+// 每块一次 pwrite()
+class SyncBackend : public DiskBackend {
+public:
+    explicit SyncBackend(bool direct) : DiskBackend(direct), m_stats{ 0, 0, 0 }, m_completed(0) {}
+
+    const char* name() const override { return "write"; }
+
+    char* allocate(size_t size) override { return allocateAligned(size); }
+    void release(char* block, size_t) override { releaseAligned(block); }
+
+    uint64_t write(int fd, char* block, size_t, size_t length, uint64_t offset) override {
+        // 关闭分段时可能在其他线程调用（见 DiskWriter::detach），统计用原子操作
+        uint64_t syscalls = 0;
+        writeAll(fd, block, length, offset, syscalls);
+        releaseAligned(block);
+        __atomic_add_fetch(&m_stats.writes, 1, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&m_stats.bytes, length, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&m_stats.syscalls, syscalls, __ATOMIC_RELAXED);
+        // 写完才编号，编号之前的写入都已完成
+        return m_completed.fetch_add(1) + 1;
+    }
+
+    uint64_t completed() const override { return m_completed.load(); }
+
+    Stats stats() const override {
+        return { __atomic_load_n(&m_stats.writes, __ATOMIC_RELAXED),
+                 __atomic_load_n(&m_stats.bytes, __ATOMIC_RELAXED),
+                 __atomic_load_n(&m_stats.syscalls, __ATOMIC_RELAXED) };
+    }
+
+private:
+    Stats m_stats;
+    std::atomic<uint64_t> m_completed;
+};
+
+#ifdef __linux__
+// 共用一个 io_uring：写入只填写 SQE，submit() 时一次 io_uring_enter 提交一轮的所有写入并回收完成的块。
+// 块从一段注册为固定缓冲区的内存中分配，用 IORING_OP_WRITE_FIXED 写出，内核不必每次映射用户页；
+// 注册失败（RLIMIT_MEMLOCK）或内存用完时退回普通内存和 IORING_OP_WRITE，仍然批量提交
+class UringBackend : public DiskBackend {
+public:
+    UringBackend(bool direct, size_t bufferBytes)
+        : DiskBackend(direct), m_arena(nullptr), m_arenaSize(bufferBytes), m_arenaUsed(0),
+          m_arenaFull(false), m_registered(false), m_inFlightCount(0), m_lastTicket(0), m_completed(0),
+          m_stats{ 0, 0, 0 } {}
+
+    ~UringBackend() override {
+        wait();
+        for (auto& sizeClass : m_free) {
+            for (char* block : sizeClass.second) {
+                if (!inArena(block)) {
+                    releaseAligned(block);
+                }
+            }
+        }
+        if (m_arena) {
+            releaseAligned(m_arena);
+        }
+    }
+
+    bool init(unsigned entries) {
+        if (!m_ring.init(entries)) {
+            return false;
+        }
+        m_slots.resize(m_ring.completionEntries());
+        for (uint32_t i = 0; i < m_slots.size(); ++i) {
+            m_freeSlots.push_back(static_cast<uint32_t>(m_slots.size()) - 1 - i);
+        }
+        m_arenaSize = m_arenaSize / kAlignment * kAlignment;
+        if (m_arenaSize > 0) {
+            m_arena = allocateAligned(m_arenaSize);
+            m_registered = m_ring.registerBuffer(m_arena, m_arenaSize);
+            if (!m_registered) {
+                LOG_ERROR("Disk", std::string("Failed to register io_uring buffers (") + std::strerror(errno) +
+                          "), raise RLIMIT_MEMLOCK or lower uringBufferMB");
+            }
+        }
+        return true;
+    }
+
+    const char* name() const override { return "uring"; }
+
+    char* allocate(size_t size) override {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto& blocks = m_free[size];
+        if (!blocks.empty()) {
+            char* block = blocks.back();
+            blocks.pop_back();
+            return block;
+        }
+        if (m_arenaUsed + size <= m_arenaSize) {
+            char* block = m_arena + m_arenaUsed;
+            m_arenaUsed += size;
+            return block;
+        }
+        // 固定缓冲区用完时用普通内存，不等正在写的块回收，否则每块都要一次 io_uring_enter
+        if (!m_arenaFull && m_arenaSize > 0) {
+            m_arenaFull = true;
+            LOG_ERROR("Disk", "io_uring buffers (" + std::to_string(m_arenaSize / 1024) +
+                      " KB) exhausted, using unregistered memory; raise uringBufferMB to at least "
+                      "ports x block size");
+        }
+        return allocateAligned(size);
+    }
+
+    void release(char* block, size_t size) override {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        releaseLocked(block, size);
+    }
+
+    uint64_t write(int fd, char* block, size_t size, size_t length, uint64_t offset) override {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        io_uring_sqe* sqe;
+        while (m_freeSlots.empty() || !(sqe = m_ring.sqe())) {
+            // 在写的请求占满完成队列时等回收一批，避免之后每个写入都要一次 io_uring_enter
+            submitLocked(m_freeSlots.empty() ? static_cast<unsigned>(m_slots.size() / 4) : 0);
+        }
+        uint32_t slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+        uint64_t ticket = ++m_lastTicket;
+        m_slots[slot] = InFlight{ fd, block, size, length, offset, ticket };
+        m_tickets.insert(ticket);
+        ++m_inFlightCount;
+
+        bool fixed = m_registered && inArena(block);
+        sqe->opcode = fixed ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+        sqe->fd = fd;
+        sqe->addr = reinterpret_cast<uint64_t>(block);
+        sqe->len = static_cast<uint32_t>(length);
+        sqe->off = offset;
+        sqe->buf_index = 0;
+        sqe->user_data = slot;
+        ++m_stats.writes;
+        m_stats.bytes += length;
+        return ticket;
+    }
+
+    uint64_t completed() const override { return m_completed.load(); }
+
+    void submit() override {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        submitLocked(0);
+    }
+
+    void wait() override {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        while (m_inFlightCount > 0) {
+            // 一次等待所有在写的请求，缓冲写入在内核工作线程中逐个完成，每次只等一个会多出很多次系统调用
+            submitLocked(static_cast<unsigned>(m_inFlightCount));
+        }
+    }
+
+    Stats stats() const override {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_stats;
+    }
+
+private:
+    struct InFlight {
+        int fd;
+        char* block;
+        size_t size;
+        size_t length;
+        uint64_t offset;
+        uint64_t ticket;
+    };
+
+    bool inArena(const char* block) const {
+        return m_arena && block >= m_arena && block < m_arena + m_arenaSize;
+    }
+
+    void releaseLocked(char* block, size_t size) {
+        if (inArena(block) || m_free[size].size() < 64) {
+            m_free[size].push_back(block);
+        } else {
+            releaseAligned(block);
+        }
+    }
+
+    void submitLocked(unsigned waitFor) {
+        if (m_ring.pending() > 0 || waitFor > 0) {
+            ++m_stats.syscalls;
+        }
+        int result = m_ring.submit(waitFor);
+        if (result < 0 && result != -EBUSY && result != -EAGAIN) {
+            LOG_ERROR("Disk", std::string("io_uring_enter failed: ") + std::strerror(-result));
+        }
+        m_ring.reap([this](uint64_t data, int res) { complete(static_cast<uint32_t>(data), res); });
+    }
+
+    void complete(uint32_t slot, int res) {
+        InFlight done = m_slots[slot];
+        m_freeSlots.push_back(slot);
+        --m_inFlightCount;
+
+        // 出错或只写了一部分时同步补写剩余部分
+        size_t written = res > 0 ? static_cast<size_t>(res) : 0;
+        if (res < 0) {
+            LOG_ERROR("Disk", std::string("io_uring write failed, retrying with pwrite: ") + std::strerror(-res));
+        }
+        if (written < done.length) {
+            writeAll(done.fd, done.block + written, done.length - written, done.offset + written,
+                     m_stats.syscalls);
+        }
+        releaseLocked(done.block, done.size);
+
+        m_tickets.erase(done.ticket);
+        m_completed.store(m_tickets.empty() ? m_lastTicket : *m_tickets.begin() - 1);
+    }
+
+    mutable std::mutex m_mutex;  // 写盘线程之外，关闭通道时也会写出剩余数据
+    IoUring m_ring;
+    char* m_arena;
+    size_t m_arenaSize;
+    size_t m_arenaUsed;
+    bool m_arenaFull;  // 已记录过固定缓冲区不够用
+    bool m_registered;
+    std::map<size_t, std::vector<char*>> m_free;  // 按块大小的空闲块
+    std::vector<InFlight> m_slots;
+    std::vector<uint32_t> m_freeSlots;
+    size_t m_inFlightCount;
+    uint64_t m_lastTicket;
+    std::set<uint64_t> m_tickets;  // 未完成的写入编号
+    std::atomic<uint64_t> m_completed;
+    Stats m_stats;
+};
+#endif
+
+} // namespace
+#endif
+
+std::unique_ptr<DiskBackend> DiskBackend::create(const std::string& kind, bool direct,
+                                                 unsigned entries, size_t bufferBytes) {
+#ifdef _WIN32
+    (void)entries;
+    (void)bufferBytes;
+    if (kind != "write" || direct) {
+        LOG_ERROR("Disk", "diskBackend \"uring\" and directIo are not supported on Windows");
+    }
+    return nullptr;
+#else
+    if (kind == "uring") {
+#ifdef __linux__
+        std::unique_ptr<UringBackend> uring(new UringBackend(direct, bufferBytes));
+        if (uring->init(entries)) {
+            return uring;
+        }
+        LOG_ERROR("Disk", std::string("io_uring unavailable (") + std::strerror(errno) +
+                  "), using write()");
+#else
+        (void)entries;
+        (void)bufferBytes;
+        LOG_ERROR("Disk", "io_uring is only available on Linux, using write()");
+#endif
+    } else if (kind != "write") {
+        LOG_ERROR("Disk", "Unknown diskBackend \"" + kind + "\", using write()");
+    }
+    if (!direct) {
+        return nullptr;
+    }
+    return std::unique_ptr<DiskBackend>(new SyncBackend(direct));
+#endif
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// 数据文件块的写出方式，由写盘线程的所有串口共用（见 DataSink）
+//   write：每块一次 pwrite() 系统调用
+//   uring：所有串口共用一个 io_uring 提交队列，写盘线程每轮批量提交一次，块来自注册的固定缓冲区
+// 未配置时 DataSink 使用原来的 stdio 写出，不经过后端
+// direct 时整块对齐的写入使用 O_DIRECT 打开的第二个文件句柄，不经过页缓存
+class DiskBackend {
+public:
+    static constexpr size_t kAlignment = 4096;
+
+    struct Stats {
+        uint64_t writes;    // 写入的块数
+        uint64_t bytes;
+        uint64_t syscalls;  // pwrite 或 io_uring_enter 的次数
+    };
+
+    virtual ~DiskBackend() = default;
+
+    // kind 为 "uring" 时无法创建 io_uring 则退回 write；kind 为 "write" 且不使用 direct 时返回空
+    static std::unique_ptr<DiskBackend> create(const std::string& kind, bool direct,
+                                               unsigned entries, size_t bufferBytes);
+
+    virtual const char* name() const = 0;
+    bool direct() const { return m_direct; }
+
+    // 分配一个按 kAlignment 对齐的块，size 为 kAlignment 的倍数
+    virtual char* allocate(size_t size) = 0;
+    virtual void release(char* block, size_t size) = 0;
+    // 把 block 的前 length 字节写到 fd 的 offset 处；块交给后端，写完后回收
+    // 返回写入的编号，编号不大于 completed() 时数据已写入文件
+    virtual uint64_t write(int fd, char* block, size_t size, size_t length, uint64_t offset) = 0;
+    // 编号不大于返回值的写入都已完成（uring 的写入可能乱序完成，只算连续完成的部分）
+    virtual uint64_t completed() const = 0;
+    // 写盘线程每轮结束时调用：提交积累的写入并回收已完成的块
+    virtual void submit() {}
+    // 等待所有已提交的写入完成，关闭文件前调用
+    virtual void wait() {}
+
+    virtual Stats stats() const = 0;
+
+protected:
+    explicit DiskBackend(bool direct) : m_direct(direct) {}
+
+    bool m_direct;
+};
@@ -0,0 +1,191 @@
+// 写盘后端对比：write（不使用后端，stdio 每块一次 write）、uring（共用一个 io_uring 批量提交），
+// 以及 O_DIRECT 下的 write（每块一次 pwrite）和 uring
+// 模拟写盘线程：每轮给每个串口写一个数据块，轮末提交一次；结束后检查每个文件的长度和内容，不一致时退出码为 1
+// 用法: DiskBench [每种配置的数据量MB] [数据块大小] [块大小KB]
+#include "DataSink.h"
+#include "DiskBackend.h"
+#include <sys/resource.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Mode {
+    const char* name;
+    const char* backend;  // 空为不使用后端
+    bool direct;
+};
+
+const Mode kModes[] = {
+    { "write", nullptr, false },
+    { "write+direct", "write", true },
+    { "uring", "uring", false },
+    { "uring+direct", "uring", true },
+};
+
+const size_t kPortCounts[] = { 10, 100, 500 };
+
+double cpuSeconds() {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+           (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+std::string portName(size_t index) {
+    return "bench_disk_" + std::to_string(index);
+}
+
+char patternByte(size_t port) {
+    return static_cast<char>('a' + port % 26);
+}
+
+// 每个串口的所有数据文件拼起来应是 expected 字节的 pattern，每块以换行结尾
+bool verify(size_t ports, uint64_t expected, size_t chunkSize) {
+    std::vector<char> buffer(1 << 16);
+    for (size_t i = 0; i < ports; ++i) {
+        uint64_t total = 0;
+        bool ok = true;
+        for (const auto& entry : std::filesystem::directory_iterator(std::filesystem::path("data") / portName(i))) {
+            std::ifstream file(entry.path(), std::ios::binary);
+            while (ok && file) {
+                file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+                for (std::streamsize k = 0; k < file.gcount(); ++k, ++total) {
+                    char want = total % chunkSize == chunkSize - 1 ? '\n' : patternByte(i);
+                    if (buffer[static_cast<size_t>(k)] != want) {
+                        ok = false;
+                        break;
+                    }
+                }
+            }
+        }
+        if (!ok || total != expected) {
+            std::cerr << portName(i) << ": " << total << " bytes, expected " << expected
+                      << (ok ? "" : ", content mismatch") << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool run(const Mode& mode, size_t ports, uint64_t totalBytes, size_t chunkSize, size_t blockSize) {
+    for (size_t i = 0; i < ports; ++i) {
+        std::filesystem::remove_all(std::filesystem::path("data") / portName(i));
+    }
+
+    std::unique_ptr<DiskBackend> backend;
+    if (mode.backend) {
+        backend = DiskBackend::create(mode.backend, mode.direct, 256, 16 * 1024 * 1024);
+        if (!backend || std::string(backend->name()) != mode.backend) {
+            std::cout << std::left << std::setw(14) << mode.name << std::right << std::setw(6) << ports
+                      << "   unavailable" << std::endl;
+            return true;
+        }
+    }
+
+    std::vector<std::vector<char>> chunks(ports, std::vector<char>(chunkSize));
+    for (size_t i = 0; i < ports; ++i) {
+        std::fill(chunks[i].begin(), chunks[i].end(), patternByte(i));
+        chunks[i].back() = '\n';
+    }
+    uint64_t rounds = totalBytes / (chunkSize * ports);
+    if (rounds == 0) {
+        rounds = 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    double cpuStart = cpuSeconds();
+    {
+        std::vector<std::unique_ptr<DataSink>> sinks;
+        for (size_t i = 0; i < ports; ++i) {
+            sinks.emplace_back(new DataSink(portName(i), false, blockSize, 100, FileFormat::Text,
+                                            TimestampPrecision::Second, backend.get()));
+        }
+        for (uint64_t round = 0; round < rounds; ++round) {
+            for (size_t i = 0; i < ports; ++i) {
+                sinks[i]->write(chunks[i].data(), chunkSize);
+            }
+            if (backend) {
+                backend->submit();
+            }
+        }
+        // 与 DiskWriter::stop() 相同：先刷新所有串口，一起等待写完后再关闭
+        for (auto& sink : sinks) {
+            sink->flush();
+        }
+        if (backend) {
+            backend->wait();
+        }
+        for (auto& sink : sinks) {
+            sink->close();
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double cpu = cpuSeconds() - cpuStart;
+
+    uint64_t perPort = rounds * chunkSize;
+    double mb = static_cast<double>(perPort * ports) / (1024.0 * 1024.0);
+    std::cout << std::left << std::setw(14) << mode.name << std::right << std::setw(6) << ports
+              << std::fixed << std::setprecision(1)
+              << std::setw(10) << mb / seconds << " MB/s"
+              << std::setw(9) << std::setprecision(3) << cpu << " s CPU";
+    if (backend) {
+        DiskBackend::Stats stats = backend->stats();
+        std::cout << std::setw(10) << stats.syscalls << " syscalls"
+                  << std::setw(10) << stats.writes << " writes";
+    }
+    std::cout << std::endl;
+
+    bool ok = verify(ports, perPort, chunkSize);
+    for (size_t i = 0; i < ports; ++i) {
+        std::filesystem::remove_all(std::filesystem::path("data") / portName(i));
+    }
+    return ok;
+}
+
+// 十进制正整数，其他输入（包括 --help）返回 false
+bool parseArg(const char* text, size_t& value) {
+    char* end = nullptr;
+    unsigned long parsed = std::strtoul(text, &end, 10);
+    if (end == text || *end != '\0' || text[0] == '-' || parsed == 0) {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t args[] = { 64, 256, 64 };  // 数据量MB、数据块大小、块大小KB
+    for (int i = 1; i < argc; ++i) {
+        if (i > 3 || !parseArg(argv[i], args[i - 1])) {
+            std::cerr << "Usage: DiskBench [MB per run (64)] [chunk size (256)] [block KB (64)]" << std::endl;
+            return 2;
+        }
+    }
+    uint64_t totalMB = args[0];
+    size_t chunkSize = args[1];
+    size_t blockKB = args[2];
+    if (chunkSize < 2) {
+        chunkSize = 2;
+    }
+
+    std::cout << "Writing " << totalMB << " MB per run in " << chunkSize << "-byte chunks, "
+              << blockKB << " KB blocks" << std::endl;
+    bool ok = true;
+    for (size_t ports : kPortCounts) {
+        for (const Mode& mode : kModes) {
+            ok = run(mode, ports, totalMB * 1024 * 1024, chunkSize, blockKB * 1024) && ok;
+        }
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,167 @@
+#include "DiskWriter.h"
+#include "Logger.h"
+#include "Record.h"
+#include "Timestamp.h"
+#include <algorithm>
+
+namespace {
+
+// 每个通道每轮最多写入的块数，避免繁忙串口饿死其他串口
+constexpr size_t kBatchPerChannel = 256;
+// 无数据时的最长休眠时间，用于按 flushInterval 刷新尾部数据
+constexpr std::chrono::milliseconds kIdleWait(100);
+
+} // namespace
+
+DiskWriter::Channel::Channel(const PortConfig& config, size_t capacity,
+                             std::shared_ptr<PortMetrics> metrics, DiskBackend* backend)
+    : queue(capacity),
+      sink(config.name, config.addTimestamp, config.writeBufferSize, config.flushInterval,
+           config.fileFormat, config.timestampPrecision, backend),
+      drops(0), shed(0), nextSequence(0), metrics(std::move(metrics)) {}
+
+DiskWriter::DiskWriter(std::unique_ptr<DiskBackend> backend)
+    : m_backend(std::move(backend)), m_running(false), m_pending(0) {}
+
+DiskWriter::~DiskWriter() {
+    stop();
+}
+
+void DiskWriter::start() {
+    m_compressor.start();
+    m_running = true;
+    m_thread = std::thread(&DiskWriter::run, this);
+}
+
+void DiskWriter::stop() {
+    if (!m_running.exchange(false)) {
+        return;
+    }
+    m_signal.notify();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+
+    std::lock_guard<std::mutex> lock(m_channelsMutex);
+    for (auto& channel : m_channels) {
+        drain(*channel, SIZE_MAX);
+        channel->sink.flush();
+    }
+    if (m_backend) {
+        // 所有通道的剩余数据一起提交，关闭时不必逐个等待
+        m_backend->wait();
+    }
+    for (auto& channel : m_channels) {
+        channel->sink.close();
+    }
+    m_channels.clear();
+    m_compressor.stop();
+}
+
+std::shared_ptr<DiskWriter::Channel> DiskWriter::attach(const PortConfig& config,
+                                                        std::shared_ptr<PortMetrics> metrics) {
+    auto channel = std::make_shared<Channel>(config, static_cast<size_t>(config.queueCapacity),
+                                             std::move(metrics), m_backend.get());
+
+    std::function<void(const std::filesystem::path&)> onClosed;
+    if (config.compression != Codec::None && !Compressor::available(config.compression)) {
+        LOG_ERROR(config.name, "Compression codec not available in this build, segments are kept uncompressed");
+    } else if (config.compression != Codec::None) {
+        channel->compression = std::make_shared<CompressionStats>();
+        Compressor::Job job{ {}, config.compression, config.compressionLevel,
+                             static_cast<size_t>((std::max)(config.compressionBlockKB, 4)) * 1024,
+                             channel->compression };
+        onClosed = [this, job](const std::filesystem::path& path) {
+            Compressor::Job closed = job;
+            closed.path = path;
+            m_compressor.submit(std::move(closed));
+        };
+    }
+    channel->sink.setRotation(static_cast<uint64_t>((std::max)(config.maxFileMB, 0)) * 1024 * 1024,
+                              std::move(onClosed));
+    std::lock_guard<std::mutex> lock(m_channelsMutex);
+    m_channels.push_back(channel);
+    return channel;
+}
+
+void DiskWriter::detach(const std::shared_ptr<Channel>& channel) {
+    {
+        std::lock_guard<std::mutex> lock(m_channelsMutex);
+        auto it = std::find(m_channels.begin(), m_channels.end(), channel);
+        if (it == m_channels.end()) {
+            return;
+        }
+        m_channels.erase(it);
+    }
+
+    // 写盘线程已不再访问该通道，在当前线程写完剩余数据
+    m_pending -= drain(*channel, SIZE_MAX);
+    channel->sink.close();
+}
+
+bool DiskWriter::submit(Channel& channel, ChunkRef&& chunk) {
+    // 先计数再入队，保证写盘线程减计数时不会下溢
+    m_pending.fetch_add(1, std::memory_order_relaxed);
+    if (!channel.queue.push(std::move(chunk))) {
+        m_pending.fetch_sub(1, std::memory_order_relaxed);
+        channel.drops.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    m_signal.notify();
+    return true;
+}
+
+size_t DiskWriter::drain(Channel& channel, size_t limit) {
+    size_t count = 0;
+    ChunkRef chunk;
+    while (count < limit && channel.queue.pop(chunk)) {
+        ++count;
+        if (channel.shed.load(std::memory_order_relaxed) > 0) {
+            // 超出内存预算丢弃最旧的数据块（已由采集器计数），下一条记录带 Gap 标记
+            channel.shed.fetch_sub(1, std::memory_order_relaxed);
+            chunk.reset();
+            continue;
+        }
+        uint16_t flags = 0;
+        if (chunk.sequence() != channel.nextSequence) {
+            flags |= RecordFlag::Gap;
+        }
+        if (chunk.size() == chunk.capacity()) {
+            flags |= RecordFlag::Full;
+        }
+        channel.nextSequence = chunk.sequence() + 1;
+        channel.sink.write(chunk.data(), chunk.size(), chunk.time(), flags);
+        if (channel.metrics) {
+            channel.metrics->diskLatency.record(
+                WallClock::fromSteady(std::chrono::steady_clock::now()) - chunk.time());
+        }
+        chunk.reset();  // 尽快归还到串口的数据块池
+    }
+    return count;
+}
+
+void DiskWriter::run() {
+    while (m_running) {
+        size_t written = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_channelsMutex);
+            for (auto& channel : m_channels) {
+                written += drain(*channel, kBatchPerChannel);
+                channel->sink.flushIfDue();
+            }
+        }
+        if (m_backend) {
+            // 本轮所有通道的写入一次提交
+            m_backend->submit();
+        }
+
+        if (written > 0) {
+            m_pending.fetch_sub(written, std::memory_order_relaxed);
+            continue;
+        }
+
+        m_signal.waitFor([this] {
+            return !m_running || m_pending.load(std::memory_order_relaxed) > 0;
+        }, kIdleWait);
+    }
+}
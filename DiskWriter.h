@@ -0,0 +1,63 @@
+#pragma once
+#include "Chunk.h"
+#include "Compressor.h"
+#include "DataSink.h"
+#include "DiskBackend.h"
+#include "Metrics.h"
+#include "SerialPort.h"
+#include "SpscRing.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 写盘阶段：一个线程负责所有串口的数据文件
+// 读取线程只把数据块放入各自的无锁队列，不会因磁盘变慢而阻塞；
+// 关闭的分段交给后台压缩线程，写盘线程不做压缩；
+// 配置了写盘后端时所有通道共用该后端，每轮处理完所有通道后提交一次
+class DiskWriter {
+public:
+    // 一个串口到写盘线程的通道
+    struct Channel {
+        Channel(const PortConfig& config, size_t capacity, std::shared_ptr<PortMetrics> metrics,
+                DiskBackend* backend);
+
+        SpscRing<ChunkRef> queue;
+        DataSink sink;
+        std::atomic<uint64_t> drops;
+        std::atomic<uint64_t> shed;  // 超出内存预算时（dropOldest）写盘线程待丢弃的最旧数据块数
+        uint64_t nextSequence;  // 写盘线程据此发现被丢弃的数据块，标记到下一条记录
+        std::shared_ptr<CompressionStats> compression;  // 未启用压缩时为空
+        std::shared_ptr<PortMetrics> metrics;
+    };
+
+    explicit DiskWriter(std::unique_ptr<DiskBackend> backend = nullptr);
+    ~DiskWriter();
+
+    void start();
+    void stop();
+
+    std::shared_ptr<Channel> attach(const PortConfig& config, std::shared_ptr<PortMetrics> metrics);
+    // 写完通道中剩余的数据并关闭文件；调用前生产者必须已停止
+    void detach(const std::shared_ptr<Channel>& channel);
+
+    // 读取线程调用，队列满时丢弃并计数，不阻塞
+    bool submit(Channel& channel, ChunkRef&& chunk);
+
+    // 未使用后端（stdio 写出）时为空
+    const DiskBackend* backend() const { return m_backend.get(); }
+
+private:
+    void run();
+    static size_t drain(Channel& channel, size_t limit);
+
+    std::unique_ptr<DiskBackend> m_backend;  // 在通道之前声明，最后销毁
+    std::atomic<bool> m_running;
+    std::atomic<size_t> m_pending;
+    std::thread m_thread;
+    std::mutex m_channelsMutex;
+    std::vector<std::shared_ptr<Channel>> m_channels;
+    WakeSignal m_signal;
+    Compressor m_compressor;
+};
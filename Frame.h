@@ -0,0 +1,63 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// 多路复用 TCP 上行的帧格式，所有字段为小端：
+//   偏移  类型     字段
+//    0    uint8    magic      固定为 0xA5
+//    1    uint8    type       FrameType
+//    2    uint16   portId     串口编号（配置中的 tcpForward.portId）
+//    4    uint32   length     负载字节数
+//    8    uint64   sequence   串口内的数据块序号，采集端丢弃的数据块表现为序号跳跃
+//   16    uint64   timestamp  读取时刻，Unix 纪元起的纳秒数
+//   24             负载
+constexpr uint8_t kFrameMagic = 0xA5;
+constexpr size_t kFrameHeaderSize = 24;
+
+enum class FrameType : uint8_t {
+    Data = 0,      // 串口数据
+    PortName = 1,  // 负载为串口名称，每次连接后先为所有串口各发送一次
+};
+
+struct FrameHeader {
+    FrameType type;
+    uint16_t portId;
+    uint32_t length;
+    uint64_t sequence;
+    uint64_t timestampNs;
+};
+
+inline void encodeFrameHeader(const FrameHeader& header, char* out) {
+    auto put = [out](size_t offset, uint64_t value, size_t bytes) {
+        for (size_t i = 0; i < bytes; ++i) {
+            out[offset + i] = static_cast<char>(value >> (8 * i));
+        }
+    };
+    put(0, kFrameMagic, 1);
+    put(1, static_cast<uint8_t>(header.type), 1);
+    put(2, header.portId, 2);
+    put(4, header.length, 4);
+    put(8, header.sequence, 8);
+    put(16, header.timestampNs, 8);
+}
+
+// magic 或 type 不合法时返回 false
+inline bool decodeFrameHeader(const char* in, FrameHeader& header) {
+    auto get = [in](size_t offset, size_t bytes) {
+        uint64_t value = 0;
+        for (size_t i = 0; i < bytes; ++i) {
+            value |= static_cast<uint64_t>(static_cast<uint8_t>(in[offset + i])) << (8 * i);
+        }
+        return value;
+    };
+    uint8_t type = static_cast<uint8_t>(get(1, 1));
+    if (get(0, 1) != kFrameMagic || type > static_cast<uint8_t>(FrameType::PortName)) {
+        return false;
+    }
+    header.type = static_cast<FrameType>(type);
+    header.portId = static_cast<uint16_t>(get(2, 2));
+    header.length = static_cast<uint32_t>(get(4, 4));
+    header.sequence = get(8, 8);
+    header.timestampNs = get(16, 8);
+    return true;
+}
@@ -0,0 +1,57 @@
+#include "FrameDecoder.h"
+#include <algorithm>
+
+FrameDecoder::FrameDecoder(size_t maxPayload)
+    : m_maxPayload(maxPayload), m_header(), m_hasHeader(false) {}
+
+void FrameDecoder::reset() {
+    m_buffer.clear();
+    m_hasHeader = false;
+}
+
+bool FrameDecoder::feed(const char* data, size_t size, const Handler& handler) {
+    const char* end = data + size;
+
+    // 先补全上次剩下的不完整帧
+    while (!m_buffer.empty()) {
+        size_t need = m_hasHeader ? kFrameHeaderSize + m_header.length : kFrameHeaderSize;
+        size_t take = std::min(need - m_buffer.size(), static_cast<size_t>(end - data));
+        m_buffer.insert(m_buffer.end(), data, data + take);
+        data += take;
+        if (m_buffer.size() < need) {
+            return true;
+        }
+
+        if (!m_hasHeader) {
+            if (!decodeFrameHeader(m_buffer.data(), m_header) || m_header.length > m_maxPayload) {
+                return false;
+            }
+            m_hasHeader = true;
+            continue;
+        }
+        handler(m_header, m_buffer.data() + kFrameHeaderSize);
+        reset();
+    }
+
+    // 输入中的完整帧直接交给 handler
+    FrameHeader header;
+    while (end - data >= static_cast<ptrdiff_t>(kFrameHeaderSize)) {
+        if (!decodeFrameHeader(data, header) || header.length > m_maxPayload) {
+            return false;
+        }
+        if (static_cast<size_t>(end - data) < kFrameHeaderSize + header.length) {
+            break;
+        }
+        handler(header, data + kFrameHeaderSize);
+        data += kFrameHeaderSize + header.length;
+    }
+
+    if (data < end) {
+        m_buffer.assign(data, end);
+        if (m_buffer.size() >= kFrameHeaderSize) {
+            decodeFrameHeader(m_buffer.data(), m_header);
+            m_hasHeader = true;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include "Frame.h"
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+// 多路复用上行的流式解码器：输入可以在任意位置切分，
+// 完整的帧尽量直接从输入中解析，只有跨越两次输入的帧才复制到内部缓冲区
+class FrameDecoder {
+public:
+    using Handler = std::function<void(const FrameHeader& header, const char* payload)>;
+
+    explicit FrameDecoder(size_t maxPayload = 1 << 20);
+
+    // 每解析出一个完整帧调用一次 handler；遇到格式错误返回 false，之后需要 reset()
+    bool feed(const char* data, size_t size, const Handler& handler);
+    void reset();
+
+    size_t buffered() const { return m_buffer.size(); }
+
+private:
+    size_t m_maxPayload;
+    std::vector<char> m_buffer;  // 不完整的帧
+    FrameHeader m_header;        // m_buffer 中已解析的帧头
+    bool m_hasHeader;
+};
@@ -0,0 +1,169 @@
+// 多路复用上行的测试接收端：解码帧并检查每个串口的序号是否连续
+// 用法: FrameReceiver [监听端口] [运行秒数]
+// 运行秒数为 0 时一直运行，Ctrl+C 退出；存在序号缺失或格式错误时返回 1
+#include "FrameDecoder.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+volatile std::sig_atomic_t g_stop = 0;
+
+void onSignal(int) {
+    g_stop = 1;
+}
+
+struct PortState {
+    std::string name;
+    uint64_t frames = 0;
+    uint64_t bytes = 0;
+    bool started = false;
+    uint64_t nextSequence = 0;
+    uint64_t missing = 0;     // 序号跳过的数据块数（采集端丢弃）
+    uint64_t duplicates = 0;  // 序号回退的数据块数（存储转发重发或采集端重启）
+    double latencyMaxMs = 0.0;
+};
+
+struct Connection {
+    int fd;
+    FrameDecoder decoder;
+};
+
+uint64_t nowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+void onFrame(std::map<uint16_t, PortState>& ports, const FrameHeader& header, const char* payload) {
+    PortState& port = ports[header.portId];
+    if (header.type == FrameType::PortName) {
+        port.name.assign(payload, header.length);
+        return;
+    }
+
+    port.frames++;
+    port.bytes += header.length;
+    if (port.started && header.sequence > port.nextSequence) {
+        port.missing += header.sequence - port.nextSequence;
+    } else if (port.started && header.sequence < port.nextSequence) {
+        port.duplicates++;
+    }
+    port.started = true;
+    port.nextSequence = std::max(port.nextSequence, header.sequence + 1);
+
+    uint64_t now = nowNs();
+    if (now > header.timestampNs) {
+        port.latencyMaxMs = std::max(port.latencyMaxMs, (now - header.timestampNs) / 1e6);
+    }
+}
+
+void report(const std::map<uint16_t, PortState>& ports, uint64_t errors) {
+    std::cout << std::setw(6) << "Id" << std::setw(16) << "Port" << std::setw(12) << "Frames"
+              << std::setw(14) << "Bytes" << std::setw(10) << "Missing" << std::setw(10) << "Dup"
+              << std::setw(14) << "MaxLat(ms)" << std::endl;
+    for (const auto& entry : ports) {
+        const PortState& port = entry.second;
+        std::cout << std::setw(6) << entry.first << std::setw(16) << port.name
+                  << std::setw(12) << port.frames << std::setw(14) << port.bytes
+                  << std::setw(10) << port.missing << std::setw(10) << port.duplicates
+                  << std::setw(14) << std::fixed << std::setprecision(2) << port.latencyMaxMs
+                  << std::endl;
+    }
+    if (errors > 0) {
+        std::cout << errors << " connection(s) closed on malformed frames" << std::endl;
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int listenPort = argc > 1 ? std::atoi(argv[1]) : 8080;
+    int seconds = argc > 2 ? std::atoi(argv[2]) : 0;
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    int reuse = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(listenPort));
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        listen(listener, 64) != 0) {
+        std::cerr << "Failed to listen on port " << listenPort << ": " << std::strerror(errno)
+                  << std::endl;
+        return 1;
+    }
+    std::cout << "Listening on port " << listenPort << std::endl;
+
+    std::map<uint16_t, PortState> ports;
+    std::vector<std::unique_ptr<Connection>> connections;
+    std::vector<char> buffer(256 * 1024);
+    uint64_t errors = 0;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(seconds);
+
+    while (!g_stop && (seconds == 0 || std::chrono::steady_clock::now() < deadline)) {
+        std::vector<pollfd> fds;
+        fds.push_back({ listener, POLLIN, 0 });
+        for (const auto& connection : connections) {
+            fds.push_back({ connection->fd, POLLIN, 0 });
+        }
+        if (poll(fds.data(), fds.size(), 200) <= 0) {
+            continue;
+        }
+
+        if (fds[0].revents & POLLIN) {
+            int fd = accept(listener, nullptr, nullptr);
+            if (fd >= 0) {
+                connections.push_back(std::make_unique<Connection>(Connection{ fd, FrameDecoder() }));
+            }
+        }
+
+        for (size_t i = 1; i < fds.size(); ++i) {
+            if (!(fds[i].revents & (POLLIN | POLLHUP | POLLERR))) {
+                continue;
+            }
+            Connection& connection = *connections[i - 1];
+            ssize_t n = recv(connection.fd, buffer.data(), buffer.size(), 0);
+            bool ok = n > 0 && connection.decoder.feed(buffer.data(), static_cast<size_t>(n),
+                [&ports](const FrameHeader& header, const char* payload) {
+                    onFrame(ports, header, payload);
+                });
+            if (n > 0 && !ok) {
+                errors++;
+            }
+            if (!ok) {
+                close(connection.fd);
+                connection.fd = -1;
+            }
+        }
+        connections.erase(std::remove_if(connections.begin(), connections.end(),
+            [](const std::unique_ptr<Connection>& connection) { return connection->fd < 0; }),
+            connections.end());
+    }
+
+    for (const auto& connection : connections) {
+        close(connection->fd);
+    }
+    close(listener);
+
+    report(ports, errors);
+    bool continuous = std::all_of(ports.begin(), ports.end(),
+        [](const std::pair<const uint16_t, PortState>& entry) { return entry.second.missing == 0; });
+    return continuous && errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,156 @@
+#include "Framer.h"
+#include <algorithm>
+#include <cstring>
+
+Framer::Framer(const FramingConfig& config, size_t maxFrame)
+    : m_config(config), m_maxFrame(std::max<size_t>(maxFrame, 1)), m_header(0), m_scanned(0),
+      m_errors(0) {
+    if (m_config.delimiter.empty()) {
+        m_config.delimiter = "\n";
+    }
+    if (m_config.lengthSize != 1 && m_config.lengthSize != 2 && m_config.lengthSize != 4) {
+        m_config.lengthSize = 2;
+    }
+    m_config.lengthOffset = std::max(m_config.lengthOffset, 0);
+    m_header = static_cast<size_t>(m_config.lengthOffset + m_config.lengthSize);
+    if (m_config.frameSize <= 0 || static_cast<size_t>(m_config.frameSize) > m_maxFrame) {
+        m_config.frameSize = static_cast<int>(m_maxFrame);
+    }
+}
+
+size_t Framer::next(const char* data, size_t size) {
+    switch (m_config.mode) {
+        case FramingMode::Delimiter:
+            return findDelimiter(data, size);
+        case FramingMode::Length:
+            return findLength(data, size);
+        case FramingMode::Fixed:
+            return size >= static_cast<size_t>(m_config.frameSize) ?
+                static_cast<size_t>(m_config.frameSize) : 0;
+        default:
+            // IdleGap 由调用方按时间结束帧，这里只负责按容量切分
+            return size >= m_maxFrame ? m_maxFrame : 0;
+    }
+}
+
+void Framer::consume(size_t length) {
+    m_scanned = m_scanned > length ? m_scanned - length : 0;
+}
+
+size_t Framer::findDelimiter(const char* data, size_t size) {
+    // 用 memchr 找分隔符的最后一个字节再向前比较：memchr 在各平台的 C 库中都有 SIMD 实现，
+    // 多字节分隔符（如 \r\n）被读取分开时，前面的字节仍在缓冲区中可以回看
+    const std::string& delimiter = m_config.delimiter;
+    size_t tail = delimiter.size() - 1;
+    char last = delimiter.back();
+    size_t pos = std::max(m_scanned, tail);
+    size_t limit = std::min(size, m_maxFrame);
+    while (pos < limit) {
+        const void* hit = std::memchr(data + pos, last, limit - pos);
+        if (!hit) {
+            break;
+        }
+        pos = static_cast<size_t>(static_cast<const char*>(hit) - data);
+        if (tail == 0 || std::memcmp(data + pos - tail, delimiter.data(), tail) == 0) {
+            m_scanned = pos + 1;
+            return pos + 1;
+        }
+        ++pos;
+    }
+    m_scanned = limit;
+    return size >= m_maxFrame ? m_maxFrame : 0;
+}
+
+bool Framer::frameLength(const char* data, size_t& length) const {
+    const auto* field = reinterpret_cast<const unsigned char*>(data + m_config.lengthOffset);
+    uint64_t value = 0;
+    for (int i = 0; i < m_config.lengthSize; ++i) {
+        int shift = m_config.lengthBigEndian ? 8 * (m_config.lengthSize - 1 - i) : 8 * i;
+        value |= static_cast<uint64_t>(field[i]) << shift;
+    }
+    int64_t total = static_cast<int64_t>(m_header + value) + m_config.lengthAdjust;
+    if (total < static_cast<int64_t>(m_header) || total <= 0 ||
+        static_cast<uint64_t>(total) > m_maxFrame) {
+        return false;
+    }
+    length = static_cast<size_t>(total);
+    return true;
+}
+
+size_t Framer::findLength(const char* data, size_t size) {
+    // 长度不合法时逐字节向后寻找下一个合法的帧头，跳过的字节作为一帧输出，不丢弃数据
+    size_t skip = 0;
+    while (skip < m_maxFrame && size - skip >= m_header) {
+        size_t length;
+        if (frameLength(data + skip, length)) {
+            if (skip > 0) {
+                return skip;
+            }
+            return size >= length ? length : 0;
+        }
+        if (skip == 0) {
+            ++m_errors;
+        }
+        ++skip;
+    }
+    return skip;
+}
+
+FrameAssembler::FrameAssembler(const FramingConfig& config, ChunkPool& pool)
+    : m_framer(config, pool.chunkSize()), m_pool(pool), m_pending(0) {}
+
+char* FrameAssembler::readBuffer(size_t& capacity) {
+    if (!m_chunk) {
+        m_chunk = m_pool.acquire();
+    }
+    capacity = m_chunk.capacity() - m_pending;
+    return m_chunk.data() + m_pending;
+}
+
+void FrameAssembler::commit(size_t bytes, bool gapBefore, std::vector<ChunkRef>& frames) {
+    if (bytes == 0) {
+        return;
+    }
+    size_t size = m_pending + bytes;
+    size_t start = 0;
+    if (gapBefore && m_pending > 0 && m_framer.mode() == FramingMode::IdleGap) {
+        emit(0, m_pending, frames);
+        start = m_pending;
+        m_framer.reset();
+    }
+
+    size_t length;
+    while (start < size && (length = m_framer.next(m_chunk.data() + start, size - start)) > 0) {
+        if (start == 0 && length == size) {
+            // 整块正好是一帧，直接交给下游
+            m_chunk.setSize(length);
+            frames.push_back(std::move(m_chunk));
+        } else {
+            emit(start, length, frames);
+        }
+        m_framer.consume(length);
+        start += length;
+    }
+
+    m_pending = size - start;
+    if (start > 0 && m_pending > 0) {
+        std::memmove(m_chunk.data(), m_chunk.data() + start, m_pending);
+    }
+}
+
+void FrameAssembler::flush(std::vector<ChunkRef>& frames) {
+    if (m_pending == 0) {
+        return;
+    }
+    m_chunk.setSize(m_pending);
+    frames.push_back(std::move(m_chunk));
+    m_pending = 0;
+    m_framer.reset();
+}
+
+void FrameAssembler::emit(size_t start, size_t length, std::vector<ChunkRef>& frames) {
+    ChunkRef frame = m_pool.acquire();
+    std::memcpy(frame.data(), m_chunk.data() + start, length);
+    frame.setSize(length);
+    frames.push_back(std::move(frame));
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include "Chunk.h"
+#include "Common.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 在串口字节流中查找帧边界
+// 跨多次读取增量进行：记住已检查过的位置，新数据到达时只扫描新字节
+class Framer {
+public:
+    // maxFrame 为数据块容量，任何帧都不会超过它
+    Framer(const FramingConfig& config, size_t maxFrame);
+
+    // data[0, size) 为当前帧起点之后已收到的字节，返回第一个完整帧的长度，不完整时返回 0
+    // 到达 maxFrame 仍未结束的帧被强制切分；Length 模式下长度不合法的字节作为一帧单独输出
+    size_t next(const char* data, size_t size);
+    // 输出了长度为 length 的帧，下一次 next() 从帧之后开始
+    void consume(size_t length);
+    void reset() { m_scanned = 0; }
+
+    FramingMode mode() const { return m_config.mode; }
+    size_t maxFrame() const { return m_maxFrame; }
+    uint64_t errors() const { return m_errors; }  // Length 模式下长度不合法的次数
+
+private:
+    size_t findDelimiter(const char* data, size_t size);
+    size_t findLength(const char* data, size_t size);
+    bool frameLength(const char* data, size_t& length) const;
+
+    FramingConfig m_config;
+    size_t m_maxFrame;
+    size_t m_header;   // Length：长度字段结束的位置
+    size_t m_scanned;  // 当前帧起点之后已检查过的字节数
+    uint64_t m_errors;
+};
+
+// 把读取到的字节切成帧，每帧一个数据块
+// 直接读入数据块中未完成的帧之后：读取只包含一个完整帧时原样输出，不复制；
+// 其余帧各复制一次，剩下的不完整帧移到块首，每个字节最多复制一次
+class FrameAssembler {
+public:
+    FrameAssembler(const FramingConfig& config, ChunkPool& pool);
+
+    // 下一次读取的目标位置和可用空间
+    char* readBuffer(size_t& capacity);
+    // 读入 bytes 字节后调用，完整的帧追加到 frames；gapBefore 表示这些字节之前线路静默过，
+    // IdleGap 模式下未完成的帧先结束
+    void commit(size_t bytes, bool gapBefore, std::vector<ChunkRef>& frames);
+    // 把未完成的帧作为一帧输出（IdleGap 模式静默超时）
+    void flush(std::vector<ChunkRef>& frames);
+
+    size_t pending() const { return m_pending; }
+    const Framer& framer() const { return m_framer; }
+
+private:
+    void emit(size_t start, size_t length, std::vector<ChunkRef>& frames);
+
+    Framer m_framer;
+    ChunkPool& m_pool;
+    ChunkRef m_chunk;  // 未完成的帧在块首，长度为 m_pending
+    size_t m_pending;
+};
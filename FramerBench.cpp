@@ -0,0 +1,137 @@
+// 分帧吞吐量测试：按 1024 字节一次读取的方式把生成的数据交给 FrameAssembler
+// 用法: FramerBench [数据量MB]
+#include "Framer.h"
+#include "Chunk.h"
+#include "Common.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr size_t kReadSize = 1024;
+constexpr size_t kMaxFrame = 4096;
+
+FramingConfig makeConfig(FramingMode mode, const std::string& delimiter = "\n") {
+    return { mode, delimiter, 0, 2, true, 0, 64, 0, static_cast<int>(kMaxFrame) };
+}
+
+// 可打印字符组成的行，行长 20-120
+std::vector<char> makeLines(size_t bytes, const std::string& delimiter) {
+    std::mt19937 rng(1);
+    std::vector<char> data;
+    data.reserve(bytes + 256);
+    while (data.size() < bytes) {
+        size_t length = 20 + rng() % 100;
+        for (size_t i = 0; i < length; ++i) {
+            data.push_back(static_cast<char>(' ' + rng() % 95));
+        }
+        data.insert(data.end(), delimiter.begin(), delimiter.end());
+    }
+    return data;
+}
+
+// 2 字节大端长度 + 16-200 字节负载
+std::vector<char> makeLengthFrames(size_t bytes) {
+    std::mt19937 rng(2);
+    std::vector<char> data;
+    data.reserve(bytes + 256);
+    while (data.size() < bytes) {
+        size_t length = 16 + rng() % 185;
+        data.push_back(static_cast<char>(length >> 8));
+        data.push_back(static_cast<char>(length & 0xFF));
+        for (size_t i = 0; i < length; ++i) {
+            data.push_back(static_cast<char>(rng()));
+        }
+    }
+    return data;
+}
+
+std::vector<char> makeBinary(size_t bytes) {
+    std::mt19937 rng(3);
+    std::vector<char> data(bytes);
+    for (auto& c : data) {
+        c = static_cast<char>(rng());
+    }
+    return data;
+}
+
+void report(const char* name, size_t bytes, uint64_t frames, double seconds) {
+    std::cout << std::left << std::setw(24) << name << std::right
+              << std::setw(10) << std::fixed << std::setprecision(3) << seconds << " s"
+              << std::setw(12) << frames << " frames"
+              << std::setw(10) << std::setprecision(2) << bytes / seconds / 1e9 << " GB/s" << std::endl;
+}
+
+// 与串口读取相同：每次读入最多 kReadSize 字节后提交
+void run(const char* name, const FramingConfig& config, const std::vector<char>& data) {
+    std::unique_ptr<ChunkPool, ChunkPool::Retire> pool(new ChunkPool(kMaxFrame));
+    FrameAssembler assembler(config, *pool);
+    std::vector<ChunkRef> frames;
+    uint64_t count = 0;
+    uint64_t framedBytes = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    size_t offset = 0;
+    while (offset < data.size()) {
+        size_t capacity;
+        char* buffer = assembler.readBuffer(capacity);
+        size_t size = std::min(std::min(capacity, kReadSize), data.size() - offset);
+        std::memcpy(buffer, data.data() + offset, size);
+        offset += size;
+        assembler.commit(size, false, frames);
+        count += frames.size();
+        for (const auto& frame : frames) {
+            framedBytes += frame.size();
+        }
+        frames.clear();
+    }
+    assembler.flush(frames);
+    count += frames.size();
+    for (const auto& frame : frames) {
+        framedBytes += frame.size();
+    }
+    frames.clear();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (framedBytes != data.size()) {
+        std::cerr << name << ": framed " << framedBytes << " of " << data.size() << " bytes" << std::endl;
+    }
+    report(name, data.size(), count, seconds);
+}
+
+// 对照：只统计换行数，不分帧也不复制，作为扫描速度的上限
+void runByteLoop(const std::vector<char>& data) {
+    auto start = std::chrono::steady_clock::now();
+    uint64_t count = 0;
+    for (char c : data) {
+        count += c == '\n';
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    report("count \\n (scan only)", data.size(), count, seconds);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t megabytes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 256;
+    size_t bytes = megabytes * 1024 * 1024;
+
+    auto lines = makeLines(bytes, "\n");
+    runByteLoop(lines);
+    run("delimiter \\n", makeConfig(FramingMode::Delimiter), lines);
+    run("delimiter \\r\\n", makeConfig(FramingMode::Delimiter, "\r\n"), makeLines(bytes, "\r\n"));
+    run("length (u16 BE)", makeConfig(FramingMode::Length), makeLengthFrames(bytes));
+
+    auto binary = makeBinary(bytes);
+    run("fixed 64", makeConfig(FramingMode::Fixed), binary);
+    run("idleGap (max frame cut)", makeConfig(FramingMode::IdleGap), binary);
+    return 0;
+}
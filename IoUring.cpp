@@ -0,0 +1,135 @@
+#include "IoUring.h"
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+namespace {
+
+int ioUringSetup(unsigned entries, io_uring_params* params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int ioUringEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+int ioUringRegister(int fd, unsigned opcode, const void* arg, unsigned count) {
+    return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, count));
+}
+
+template <typename T>
+T* at(void* base, uint32_t offset) {
+    return reinterpret_cast<T*>(static_cast<char*>(base) + offset);
+}
+
+} // namespace
+
+IoUring::IoUring()
+    : m_fd(-1), m_sqRing(MAP_FAILED), m_sqRingSize(0), m_cqRing(MAP_FAILED), m_cqRingSize(0),
+      m_sqes(nullptr), m_sqesSize(0), m_sqHead(nullptr), m_sqTail(nullptr), m_sqArray(nullptr),
+      m_sqMask(0), m_sqEntries(0), m_sqLocalTail(0), m_sqSubmitted(0),
+      m_cqHead(nullptr), m_cqTail(nullptr), m_cqes(nullptr), m_cqMask(0) {
+}
+
+IoUring::~IoUring() {
+    if (m_sqes) {
+        munmap(m_sqes, m_sqesSize);
+    }
+    if (m_cqRing != MAP_FAILED && m_cqRing != m_sqRing) {
+        munmap(m_cqRing, m_cqRingSize);
+    }
+    if (m_sqRing != MAP_FAILED) {
+        munmap(m_sqRing, m_sqRingSize);
+    }
+    if (m_fd >= 0) {
+        ::close(m_fd);
+    }
+}
+
+bool IoUring::init(unsigned entries) {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    m_fd = ioUringSetup(entries, &params);
+    if (m_fd < 0) {
+        return false;
+    }
+
+    m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    // 5.4 起提交和完成队列可以一次映射
+    bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single) {
+        m_sqRingSize = m_cqRingSize = (m_sqRingSize > m_cqRingSize ? m_sqRingSize : m_cqRingSize);
+    }
+    m_sqRing = mmap(nullptr, m_sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                    m_fd, IORING_OFF_SQ_RING);
+    if (m_sqRing == MAP_FAILED) {
+        return false;
+    }
+    m_cqRing = single ? m_sqRing :
+        mmap(nullptr, m_cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+             m_fd, IORING_OFF_CQ_RING);
+    if (m_cqRing == MAP_FAILED) {
+        return false;
+    }
+    m_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      m_fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        return false;
+    }
+    m_sqes = static_cast<io_uring_sqe*>(sqes);
+
+    m_sqHead = at<unsigned>(m_sqRing, params.sq_off.head);
+    m_sqTail = at<unsigned>(m_sqRing, params.sq_off.tail);
+    m_sqArray = at<unsigned>(m_sqRing, params.sq_off.array);
+    m_sqMask = *at<unsigned>(m_sqRing, params.sq_off.ring_mask);
+    m_sqEntries = params.sq_entries;
+    m_sqLocalTail = m_sqSubmitted = *m_sqTail;
+
+    m_cqHead = at<unsigned>(m_cqRing, params.cq_off.head);
+    m_cqTail = at<unsigned>(m_cqRing, params.cq_off.tail);
+    m_cqes = at<io_uring_cqe>(m_cqRing, params.cq_off.cqes);
+    m_cqMask = *at<unsigned>(m_cqRing, params.cq_off.ring_mask);
+    return true;
+}
+
+bool IoUring::registerBuffer(void* base, size_t size) {
+    iovec iov = { base, size };
+    return ioUringRegister(m_fd, IORING_REGISTER_BUFFERS, &iov, 1) == 0;
+}
+
+io_uring_sqe* IoUring::sqe() {
+    unsigned head = __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE);
+    if (m_sqLocalTail - head >= m_sqEntries) {
+        return nullptr;
+    }
+    unsigned index = m_sqLocalTail & m_sqMask;
+    io_uring_sqe* entry = &m_sqes[index];
+    std::memset(entry, 0, sizeof(*entry));
+    m_sqArray[index] = index;
+    ++m_sqLocalTail;
+    return entry;
+}
+
+int IoUring::submit(unsigned waitFor) {
+    unsigned toSubmit = m_sqLocalTail - m_sqSubmitted;
+    if (toSubmit == 0 && waitFor == 0) {
+        return 0;
+    }
+    __atomic_store_n(m_sqTail, m_sqLocalTail, __ATOMIC_RELEASE);
+    int result;
+    do {
+        result = ioUringEnter(m_fd, toSubmit, waitFor, waitFor > 0 ? IORING_ENTER_GETEVENTS : 0);
+    } while (result < 0 && errno == EINTR);
+    if (result < 0) {
+        return -errno;
+    }
+    m_sqSubmitted += static_cast<unsigned>(result);
+    return result;
+}
+#endif
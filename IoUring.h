@@ -0,0 +1,71 @@
+#pragma once
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <cstddef>
+#include <cstdint>
+
+// io_uring 的最小封装，直接使用系统调用，不依赖 liburing
+// 只在一个线程中使用：取 SQE、填写、submit() 提交，reap() 取完成事件
+class IoUring {
+public:
+    IoUring();
+    ~IoUring();
+
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    // 内核不支持或被 seccomp 禁止时返回 false，errno 为原因
+    bool init(unsigned entries);
+    // 注册一段固定缓冲区（索引 0），之后可用 IORING_OP_WRITE_FIXED 写出其中的数据
+    bool registerBuffer(void* base, size_t size);
+
+    // 提交队列已满时返回空，需先 submit()
+    io_uring_sqe* sqe();
+    // 提交已填写的 SQE，并等待至少 waitFor 个完成事件；返回负的 errno 表示失败
+    int submit(unsigned waitFor = 0);
+
+    // 逐个处理完成事件，返回处理的个数
+    template <typename Handler>
+    unsigned reap(Handler handler) {
+        unsigned head = *m_cqHead;
+        unsigned tail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+        unsigned count = 0;
+        while (head != tail) {
+            const io_uring_cqe& cqe = m_cqes[head & m_cqMask];
+            handler(cqe.user_data, cqe.res);
+            ++head;
+            ++count;
+        }
+        __atomic_store_n(m_cqHead, head, __ATOMIC_RELEASE);
+        return count;
+    }
+
+    unsigned entries() const { return m_sqEntries; }
+    // 完成队列的大小（通常为提交队列的两倍），同时在写的请求不应超过它
+    unsigned completionEntries() const { return m_cqMask + 1; }
+    // 已填写但未提交的 SQE 个数
+    unsigned pending() const { return m_sqLocalTail - m_sqSubmitted; }
+
+private:
+    int m_fd;
+    void* m_sqRing;
+    size_t m_sqRingSize;
+    void* m_cqRing;
+    size_t m_cqRingSize;
+    io_uring_sqe* m_sqes;
+    size_t m_sqesSize;
+
+    unsigned* m_sqHead;
+    unsigned* m_sqTail;
+    unsigned* m_sqArray;
+    unsigned m_sqMask;
+    unsigned m_sqEntries;
+    unsigned m_sqLocalTail;  // 已填写但未提交的 SQE 之后的位置
+    unsigned m_sqSubmitted;  // 已交给内核的位置
+
+    unsigned* m_cqHead;
+    unsigned* m_cqTail;
+    io_uring_cqe* m_cqes;
+    unsigned m_cqMask;
+};
+#endif
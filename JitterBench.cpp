@@ -0,0 +1,487 @@
+// 串口读取延迟抖动测试：用 openpty 创建虚拟串口，写入线程按固定间隔向每个串口写入 8 字节的发送时刻，
+// 每个串口一个读取线程（与采集器的 poll 读取线程相同）用 poll + read 接收，记录从写入到读出的延迟。
+// 同时运行 CPU、内存、磁盘、网络负载，对比默认调度与 CPU 绑定、SCHED_FIFO、内存锁定下的延迟分布。
+// 用法: JitterBench [选项]，--help 查看选项；设置调度失败时返回 1
+#include "Metrics.h"
+#include "Scheduling.h"
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <pty.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Options {
+    int ports = 4;
+    double seconds = 5.0;
+    int intervalUs = 1000;
+    SchedulingConfig readers{ {}, 0 };  // 读取线程
+    SchedulingConfig bulk{ {}, 0 };     // 负载线程
+    bool lockMemory = false;
+    std::vector<std::string> loads{ "cpu", "disk", "net", "memory" };
+    int loadThreads = 0;  // 0 为 CPU 数
+    bool compare = false;
+    int baud = 0;         // 非 0 时报告超过 FIFO 填满时间的比例
+    int fifoBytes = 16;
+};
+
+uint64_t steadyNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void usage() {
+    std::cout <<
+        "Usage: JitterBench [options]\n"
+        "  --ports N          virtual serial ports, one reader thread each (default 4)\n"
+        "  --seconds S        duration of each run (default 5)\n"
+        "  --interval-us N    write 8 bytes to every port each N microseconds (default 1000)\n"
+        "  --cpus LIST        pin reader threads to these CPUs, e.g. 2,3\n"
+        "  --priority P       SCHED_FIFO priority 1-99 for reader threads\n"
+        "  --bulk-cpus LIST   pin load threads to these CPUs\n"
+        "  --lock-memory      mlockall() before the run\n"
+        "  --load LIST        cpu,disk,net,memory or none (default all)\n"
+        "  --load-threads N   threads per load kind (default number of CPUs)\n"
+        "  --compare          run once with default scheduling, then with the options above\n"
+        "  --baud B           report reads later than the time to fill the UART FIFO at B baud\n"
+        "  --fifo BYTES       UART receive FIFO size for --baud (default 16)\n";
+}
+
+std::vector<std::string> split(const std::string& text) {
+    std::vector<std::string> items;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+std::vector<int> parseCpus(const std::string& text) {
+    std::vector<int> cpus;
+    for (const std::string& item : split(text)) {
+        cpus.push_back(std::atoi(item.c_str()));
+    }
+    return cpus;
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto next = [&]() -> const char* { return i + 1 < argc ? argv[++i] : nullptr; };
+        const char* value = nullptr;
+        if (arg == "--lock-memory") {
+            options.lockMemory = true;
+        } else if (arg == "--compare") {
+            options.compare = true;
+        } else if (arg == "--help" || arg == "-h") {
+            return false;
+        } else if ((value = next()) == nullptr) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            return false;
+        } else if (arg == "--ports") {
+            options.ports = std::max(std::atoi(value), 1);
+        } else if (arg == "--seconds") {
+            options.seconds = std::atof(value);
+        } else if (arg == "--interval-us") {
+            options.intervalUs = std::max(std::atoi(value), 10);
+        } else if (arg == "--cpus") {
+            options.readers.cpus = parseCpus(value);
+        } else if (arg == "--priority") {
+            options.readers.priority = std::atoi(value);
+        } else if (arg == "--bulk-cpus") {
+            options.bulk.cpus = parseCpus(value);
+        } else if (arg == "--load") {
+            options.loads = split(value);
+            options.loads.erase(std::remove(options.loads.begin(), options.loads.end(), "none"),
+                                options.loads.end());
+        } else if (arg == "--load-threads") {
+            options.loadThreads = std::atoi(value);
+        } else if (arg == "--baud") {
+            options.baud = std::atoi(value);
+        } else if (arg == "--fifo") {
+            options.fifoBytes = std::max(std::atoi(value), 1);
+        } else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return false;
+        }
+    }
+    for (const std::string& load : options.loads) {
+        if (load != "cpu" && load != "disk" && load != "net" && load != "memory") {
+            std::cerr << "Unknown load " << load << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------- 负载
+
+class Load {
+public:
+    Load(const std::vector<std::string>& kinds, int threads, const SchedulingConfig& scheduling)
+        : m_kinds(kinds), m_threads(threads), m_scheduling(scheduling), m_running(false),
+          m_listenFd(-1), m_ok(true) {}
+
+    ~Load() { stop(); }
+
+    bool start() {
+        m_running = true;
+        for (const std::string& kind : m_kinds) {
+            for (int i = 0; i < m_threads; ++i) {
+                if (kind == "cpu") {
+                    spawn([this] { cpuLoad(); });
+                } else if (kind == "memory") {
+                    spawn([this] { memoryLoad(); });
+                } else if (kind == "disk") {
+                    spawn([this, i] { diskLoad(i); });
+                } else if (kind == "net" && !startNet()) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    void stop() {
+        m_running = false;
+        if (m_listenFd >= 0) {
+            ::shutdown(m_listenFd, SHUT_RDWR);
+        }
+        for (std::thread& thread : m_workers) {
+            thread.join();
+        }
+        m_workers.clear();
+        if (m_listenFd >= 0) {
+            ::close(m_listenFd);
+            m_listenFd = -1;
+        }
+    }
+
+    bool ok() const { return m_ok; }
+
+private:
+    void spawn(std::function<void()> body) {
+        m_workers.emplace_back([this, body] {
+            if (!applyScheduling(m_scheduling, "Load")) {
+                m_ok = false;
+            }
+            body();
+        });
+    }
+
+    void cpuLoad() {
+        volatile double x = 1.0;
+        while (m_running) {
+            for (int i = 0; i < 100000; ++i) {
+                x = x * 1.0000001 + 0.5;
+            }
+        }
+    }
+
+    // 反复复制超出缓存的内存，占用内存带宽
+    void memoryLoad() {
+        constexpr size_t kBytes = 64 * 1024 * 1024;
+        std::vector<char> from(kBytes, 1);
+        std::vector<char> to(kBytes);
+        while (m_running) {
+            std::memcpy(to.data(), from.data(), kBytes);
+            std::swap(from, to);
+        }
+    }
+
+    // 追加写入临时文件并 fdatasync，到 256 MB 后截断重来
+    void diskLoad(int index) {
+        char path[] = "jitterbench_XXXXXX";
+        int fd = ::mkstemp(path);
+        if (fd < 0) {
+            std::cerr << "mkstemp failed: " << std::strerror(errno) << std::endl;
+            return;
+        }
+        ::unlink(path);
+        std::vector<char> block(1024 * 1024, static_cast<char>('a' + index % 26));
+        off_t size = 0;
+        while (m_running) {
+            if (::write(fd, block.data(), block.size()) < 0) {
+                break;
+            }
+            size += static_cast<off_t>(block.size());
+            ::fdatasync(fd);
+            if (size >= 256 * 1024 * 1024) {
+                ::ftruncate(fd, 0);
+                ::lseek(fd, 0, SEEK_SET);
+                size = 0;
+            }
+        }
+        ::close(fd);
+    }
+
+    // 回环 TCP：一个线程发送，一个线程接收
+    bool startNet() {
+        if (m_listenFd < 0) {
+            m_listenFd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            sockaddr_in address = {};
+            address.sin_family = AF_INET;
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            socklen_t length = sizeof(address);
+            if (m_listenFd < 0 || ::bind(m_listenFd, reinterpret_cast<sockaddr*>(&address), length) != 0 ||
+                ::listen(m_listenFd, 64) != 0 ||
+                ::getsockname(m_listenFd, reinterpret_cast<sockaddr*>(&m_netAddress), &length) != 0) {
+                std::cerr << "Loopback listen failed: " << std::strerror(errno) << std::endl;
+                return false;
+            }
+        }
+        spawn([this] {
+            int fd = ::accept(m_listenFd, nullptr, nullptr);
+            std::vector<char> buffer(64 * 1024);
+            while (fd >= 0 && m_running && ::read(fd, buffer.data(), buffer.size()) > 0) {}
+            if (fd >= 0) {
+                ::close(fd);
+            }
+        });
+        spawn([this] {
+            int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            if (::connect(fd, reinterpret_cast<sockaddr*>(&m_netAddress), sizeof(m_netAddress)) != 0) {
+                ::close(fd);
+                return;
+            }
+            std::vector<char> buffer(64 * 1024, 'n');
+            while (m_running && ::write(fd, buffer.data(), buffer.size()) > 0) {}
+            ::close(fd);
+        });
+        return true;
+    }
+
+    std::vector<std::string> m_kinds;
+    int m_threads;
+    SchedulingConfig m_scheduling;
+    std::atomic<bool> m_running;
+    std::vector<std::thread> m_workers;
+    int m_listenFd;
+    sockaddr_in m_netAddress = {};
+    std::atomic<bool> m_ok;
+};
+
+// ---------------------------------------------------------------- 测量
+
+struct Port {
+    int master = -1;
+    int slave = -1;
+    std::thread reader;
+};
+
+struct Result {
+    Histogram latency;
+    std::atomic<uint64_t> maxNs{ 0 };
+    std::atomic<uint64_t> writes{ 0 };
+    std::atomic<bool> ok{ true };
+};
+
+void recordMax(std::atomic<uint64_t>& maxNs, uint64_t value) {
+    uint64_t current = maxNs.load(std::memory_order_relaxed);
+    while (value > current && !maxNs.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+}
+
+void readLoop(Port& port, const SchedulingConfig& scheduling, const std::atomic<bool>& running, Result& result) {
+    if (!applyScheduling(scheduling, "Reader")) {
+        result.ok = false;
+    }
+    prefaultStack();
+    pollfd pfd = {};
+    pfd.fd = port.slave;
+    pfd.events = POLLIN;
+    char buffer[4096];
+    size_t pending = 0;  // 上次读取剩下的不完整时刻
+    while (running) {
+        if (::poll(&pfd, 1, 100) <= 0) {
+            continue;
+        }
+        ssize_t count = ::read(port.slave, buffer + pending, sizeof(buffer) - pending);
+        if (count <= 0) {
+            continue;
+        }
+        uint64_t now = steadyNs();
+        size_t total = pending + static_cast<size_t>(count);
+        size_t offset = 0;
+        for (; offset + sizeof(uint64_t) <= total; offset += sizeof(uint64_t)) {
+            uint64_t sent;
+            std::memcpy(&sent, buffer + offset, sizeof(sent));
+            uint64_t latency = now > sent ? now - sent : 0;
+            result.latency.record(latency);
+            recordMax(result.maxNs, latency);
+        }
+        pending = total - offset;
+        std::memmove(buffer, buffer + offset, pending);
+    }
+}
+
+// 按绝对时刻唤醒，写入不受上一轮耗时影响；错过的轮次直接跳过
+void writeLoop(std::vector<std::unique_ptr<Port>>& ports, int intervalUs, const std::atomic<bool>& running,
+               Result& result) {
+    timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    const long intervalNs = static_cast<long>(intervalUs) * 1000;
+    while (running) {
+        deadline.tv_nsec += intervalNs;
+        while (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_nsec -= 1000000000L;
+            ++deadline.tv_sec;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr);
+        for (auto& port : ports) {
+            uint64_t now = steadyNs();
+            if (::write(port->master, &now, sizeof(now)) == static_cast<ssize_t>(sizeof(now))) {
+                ++result.writes;
+            }
+        }
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (now.tv_sec > deadline.tv_sec + 1) {
+            deadline = now;
+        }
+    }
+}
+
+std::string formatUs(uint64_t ns) {
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(1) << ns / 1000.0;
+    return text.str();
+}
+
+bool run(const std::string& title, const Options& options, const SchedulingConfig& readers,
+         const SchedulingConfig& bulk, bool lockMemory) {
+    std::cout << "== " << title << ": readers " << describeScheduling(readers) << ", load "
+              << describeScheduling(bulk) << (lockMemory ? ", memory locked" : "") << std::endl;
+    if (lockMemory && !lockProcessMemory()) {
+        std::cerr << "mlockall failed: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    std::vector<std::unique_ptr<Port>> ports;
+    for (int i = 0; i < options.ports; ++i) {
+        std::unique_ptr<Port> port(new Port());
+        if (openpty(&port->master, &port->slave, nullptr, nullptr, nullptr) != 0) {
+            std::cerr << "openpty failed: " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        termios tio;
+        tcgetattr(port->slave, &tio);
+        cfmakeraw(&tio);
+        tcsetattr(port->slave, TCSANOW, &tio);
+        ports.push_back(std::move(port));
+    }
+
+    int loadThreads = options.loadThreads > 0 ? options.loadThreads
+                                              : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    Load load(options.loads, loadThreads, bulk);
+    Result result;
+    std::atomic<bool> running(true);
+    bool ok = load.start();
+    for (auto& port : ports) {
+        Port* raw = port.get();
+        port->reader = std::thread([raw, &readers, &running, &result] { readLoop(*raw, readers, running, result); });
+    }
+    std::thread writer([&] { writeLoop(ports, options.intervalUs, running, result); });
+
+    std::this_thread::sleep_for(std::chrono::duration<double>(options.seconds));
+    running = false;
+    writer.join();
+    for (auto& port : ports) {
+        port->reader.join();
+        ::close(port->master);
+        ::close(port->slave);
+    }
+    load.stop();
+    if (lockMemory) {
+        ::munlockall();
+    }
+    ok = ok && load.ok() && result.ok;
+
+    if (!load.ok() || !result.ok) {
+        std::cerr << "Failed to apply scheduling, see the error/ log (SCHED_FIFO needs CAP_SYS_NICE or RLIMIT_RTPRIO)"
+                  << std::endl;
+    }
+
+    // 分位数取所在桶的上界，不超过实际最大值
+    const Histogram& latency = result.latency;
+    uint64_t maxNs = result.maxNs;
+    auto percentile = [&](double quantile) { return formatUs(std::min(latency.percentileNs(quantile), maxNs)); };
+    std::cout << "  " << latency.count() << " reads of " << result.writes << " writes, latency us:"
+              << "  p50 " << percentile(0.5) << "  p99 " << percentile(0.99)
+              << "  p99.9 " << percentile(0.999) << "  p99.99 " << percentile(0.9999)
+              << "  max " << formatUs(maxNs) << std::endl;
+
+    // 按 2 的幂分桶的分布，省略计数为 0 的桶
+    uint64_t below = 0;
+    for (int bit = 10; bit <= 32 && below < latency.count(); ++bit) {
+        uint64_t upTo = latency.countBelow(uint64_t(1) << bit);
+        if (upTo > below) {
+            double share = 100.0 * static_cast<double>(upTo - below) / static_cast<double>(latency.count());
+            std::cout << "  < " << std::setw(9) << formatUs(uint64_t(1) << bit) << " us "
+                      << std::setw(10) << (upTo - below) << "  " << std::fixed << std::setprecision(3)
+                      << std::setw(7) << share << "%  " << std::string(static_cast<size_t>(share / 2.0 + 0.99), '#')
+                      << std::endl;
+        }
+        below = upTo;
+    }
+
+    if (options.baud > 0) {
+        // 每字节 10 位（起始位、8 个数据位、停止位）
+        uint64_t fifoNs = static_cast<uint64_t>(options.fifoBytes * 10.0 * 1e9 / options.baud);
+        uint64_t late = latency.count() - latency.countBelow(fifoNs);
+        std::cout << "  FIFO of " << options.fifoBytes << " bytes at " << options.baud << " baud fills in "
+                  << formatUs(fifoNs) << " us; " << late << " reads later ("
+                  << std::setprecision(4) << 100.0 * static_cast<double>(late) /
+                     static_cast<double>(std::max<uint64_t>(latency.count(), 1))
+                  << "%, approximate at bucket resolution)" << std::endl;
+    }
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        usage();
+        return 1;
+    }
+    captureDefaultAffinity();
+
+    std::cout << options.ports << " ports, 8 bytes every " << options.intervalUs << " us, "
+              << options.seconds << " s per run, load: ";
+    for (size_t i = 0; i < options.loads.size(); ++i) {
+        std::cout << (i > 0 ? "," : "") << options.loads[i];
+    }
+    std::cout << (options.loads.empty() ? "none" : "") << std::endl;
+
+    bool ok = true;
+    if (options.compare) {
+        ok = run("default", options, SchedulingConfig{ {}, 0 }, SchedulingConfig{ {}, 0 }, false) && ok;
+    }
+    ok = run(options.compare ? "configured" : "run", options, options.readers, options.bulk,
+             options.lockMemory) && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,762 @@
+// 端到端性能测试：用 openpty 创建虚拟串口，按设定的流量写入数据，
+// 启动采集器读取这些串口并转发到本地 TCP 接收端，统计吞吐、延迟分位数、CPU 占用和数据丢失
+// 用法: LoadBench [选项]，--help 查看选项；丢失比例超过 --max-loss 时返回 1
+//
+// 每条消息带有串口号、序号和写入时刻，接收端按串口重组数据流后据此计算端到端延迟和丢失：
+//   文本:   #<串口>,<序号>,<写入纳秒>,<填充>\n
+//   二进制: B5 5B | uint16 串口 | uint32 总长度 | uint64 序号 | uint64 写入纳秒 | 随机字节（小端）
+#include "FrameDecoder.h"
+#include "Metrics.h"
+#include "RecordReader.h"
+#include <nlohmann/json.hpp>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <pty.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using json = nlohmann::json;
+
+namespace {
+
+constexpr uint8_t kMagic0 = 0xB5;
+constexpr uint8_t kMagic1 = 0x5B;
+constexpr size_t kBinaryHeader = 24;
+constexpr size_t kTextHeaderMax = 64;  // "#65535,<20 位>,<20 位>,\n" 加余量
+
+struct Options {
+    int ports = 4;
+    double rate = 11520;  // 每个串口每秒字节数，0 为不限速
+    size_t minSize = 64;
+    size_t maxSize = 256;
+    bool binary = false;
+    int burst = 0;        // 每次连续写入的消息数，0 为均匀发送
+    double seconds = 10;
+    double drainSeconds = 5;
+    bool multiplex = true;
+    std::string collector = "./SerialPortCollector";
+    std::string workdir;
+    json portJson = json::object();
+    json collectorJson = json::object();
+    double maxLoss = 0.0;
+    bool keep = false;
+    bool jsonOutput = false;
+};
+
+uint64_t nowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+void usage() {
+    std::cout <<
+        "Usage: LoadBench [options]\n"
+        "  --ports N          number of virtual serial ports (default 4)\n"
+        "  --rate B/s         bytes per second per port, 0 = unlimited (default 11520)\n"
+        "  --size MIN[-MAX]   message size range in bytes (default 64-256, text lines at least 64)\n"
+        "  --binary           binary messages instead of text lines\n"
+        "  --burst N          write N messages back to back, then pause (default 0)\n"
+        "  --seconds S        traffic duration (default 10)\n"
+        "  --drain S          max wait for the tail after traffic stops (default 5)\n"
+        "  --direct           one TCP connection per port instead of multiplex\n"
+        "  --port-json JSON   extra settings merged into every port, e.g. '{\"readMode\":\"poll\"}'\n"
+        "  --collector-json JSON  collector section, e.g. '{\"diskBackend\":\"uring\"}'\n"
+        "  --collector PATH   collector executable (default ./SerialPortCollector)\n"
+        "  --workdir DIR      working directory for the collector (default: temporary)\n"
+        "  --max-loss F       fail if more than this fraction of messages is lost (default 0)\n"
+        "  --keep             keep the working directory\n"
+        "  --json             print a JSON summary as the last line\n";
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto next = [&]() -> const char* { return i + 1 < argc ? argv[++i] : nullptr; };
+        const char* value = nullptr;
+        if (arg == "--binary") {
+            options.binary = true;
+        } else if (arg == "--direct") {
+            options.multiplex = false;
+        } else if (arg == "--keep") {
+            options.keep = true;
+        } else if (arg == "--json") {
+            options.jsonOutput = true;
+        } else if (arg == "--help" || arg == "-h") {
+            return false;
+        } else if ((value = next()) == nullptr) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            return false;
+        } else if (arg == "--ports") {
+            options.ports = std::atoi(value);
+        } else if (arg == "--rate") {
+            options.rate = std::atof(value);
+        } else if (arg == "--size") {
+            std::string range = value;
+            size_t dash = range.find('-');
+            options.minSize = std::stoul(range.substr(0, dash));
+            options.maxSize = dash == std::string::npos ? options.minSize : std::stoul(range.substr(dash + 1));
+        } else if (arg == "--burst") {
+            options.burst = std::atoi(value);
+        } else if (arg == "--seconds") {
+            options.seconds = std::atof(value);
+        } else if (arg == "--drain") {
+            options.drainSeconds = std::atof(value);
+        } else if (arg == "--port-json") {
+            options.portJson = json::parse(value, nullptr, false);
+            if (!options.portJson.is_object()) {
+                std::cerr << "--port-json must be a JSON object" << std::endl;
+                return false;
+            }
+        } else if (arg == "--collector-json") {
+            options.collectorJson = json::parse(value, nullptr, false);
+            if (!options.collectorJson.is_object()) {
+                std::cerr << "--collector-json must be a JSON object" << std::endl;
+                return false;
+            }
+        } else if (arg == "--collector") {
+            options.collector = value;
+        } else if (arg == "--workdir") {
+            options.workdir = value;
+        } else if (arg == "--max-loss") {
+            options.maxLoss = std::atof(value);
+        } else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return false;
+        }
+    }
+    size_t minSize = options.binary ? kBinaryHeader : kTextHeaderMax;
+    options.minSize = std::max(options.minSize, minSize);
+    options.maxSize = std::max(options.maxSize, options.minSize);
+    return options.ports > 0 && options.ports < 65535 && options.seconds > 0;
+}
+
+// ---------------------------------------------------------------- 发送端
+
+struct SendPort {
+    int master = -1;
+    int slave = -1;   // 保持打开，否则采集器重新打开前主端会读到挂断
+    std::string device;
+    std::string pending;
+    size_t offset = 0;
+    uint64_t sequence = 0;
+    std::atomic<uint64_t> bytes{ 0 };
+    std::atomic<uint64_t> messages{ 0 };
+};
+
+void appendMessage(const Options& options, uint16_t port, SendPort& state, size_t size, std::mt19937& random) {
+    uint64_t sequence = state.sequence++;
+    uint64_t stamp = nowNs();
+    std::string& out = state.pending;
+    size_t start = out.size();
+    if (options.binary) {
+        out.resize(start + size);
+        char* p = &out[start];
+        auto put = [p](size_t offset, uint64_t value, size_t bytes) {
+            for (size_t i = 0; i < bytes; ++i) {
+                p[offset + i] = static_cast<char>(value >> (8 * i));
+            }
+        };
+        put(0, kMagic0, 1);
+        put(1, kMagic1, 1);
+        put(2, port, 2);
+        put(4, size, 4);
+        put(8, sequence, 8);
+        put(16, stamp, 8);
+        for (size_t i = kBinaryHeader; i < size; ++i) {
+            p[i] = static_cast<char>(random());
+        }
+    } else {
+        char header[kTextHeaderMax];
+        int length = std::snprintf(header, sizeof(header), "#%u,%llu,%llu,", static_cast<unsigned>(port),
+                                   static_cast<unsigned long long>(sequence),
+                                   static_cast<unsigned long long>(stamp));
+        out.append(header, static_cast<size_t>(length));
+        for (size_t i = static_cast<size_t>(length); i + 1 < size; ++i) {
+            out += static_cast<char>('a' + (sequence + i) % 26);
+        }
+        out += '\n';
+    }
+    state.bytes.fetch_add(size, std::memory_order_relaxed);
+    state.messages.fetch_add(1, std::memory_order_relaxed);
+}
+
+// 返回 false 表示主端暂时写不进去
+bool flushPending(SendPort& port) {
+    while (port.offset < port.pending.size()) {
+        ssize_t n = ::write(port.master, port.pending.data() + port.offset, port.pending.size() - port.offset);
+        if (n < 0) {
+            return false;
+        }
+        port.offset += static_cast<size_t>(n);
+    }
+    port.pending.clear();
+    port.offset = 0;
+    return true;
+}
+
+// 按令牌桶控制速率：到时间的字节数足够一条（或一组）消息时才生成
+void generate(const Options& options, std::vector<std::unique_ptr<SendPort>>& ports,
+              std::chrono::steady_clock::time_point deadline) {
+    std::mt19937 random(12345);
+    std::uniform_int_distribution<size_t> sizes(options.minSize, options.maxSize);
+    double groupBytes = (options.minSize + options.maxSize) / 2.0 * std::max(options.burst, 1);
+    auto start = std::chrono::steady_clock::now();
+
+    while (std::chrono::steady_clock::now() < deadline) {
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        bool progressed = false;
+        bool blocked = false;
+        for (size_t i = 0; i < ports.size(); ++i) {
+            SendPort& port = *ports[i];
+            if (port.pending.empty()) {
+                double due = options.rate * elapsed - static_cast<double>(port.bytes.load(std::memory_order_relaxed));
+                if (options.rate > 0 && due < (options.burst > 0 ? groupBytes : 0.0)) {
+                    continue;
+                }
+                for (int n = 0; n < std::max(options.burst, 1); ++n) {
+                    appendMessage(options, static_cast<uint16_t>(i), port, sizes(random), random);
+                }
+            }
+            size_t before = port.offset;
+            if (!flushPending(port)) {
+                blocked = true;
+            }
+            progressed = progressed || port.offset != before || port.pending.empty();
+        }
+        if (!progressed) {
+            if (blocked) {
+                std::vector<pollfd> fds;
+                for (const auto& port : ports) {
+                    if (!port->pending.empty()) {
+                        fds.push_back({ port->master, POLLOUT, 0 });
+                    }
+                }
+                poll(fds.data(), fds.size(), 1);
+            } else {
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+            }
+        }
+    }
+
+    // 写完已生成的消息，保证发送统计与实际写入一致
+    auto flushDeadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    for (auto& port : ports) {
+        while (!flushPending(*port) && std::chrono::steady_clock::now() < flushDeadline) {
+            pollfd fd = { port->master, POLLOUT, 0 };
+            poll(&fd, 1, 10);
+        }
+    }
+}
+
+// ---------------------------------------------------------------- 接收端
+
+struct ReceivePort {
+    uint64_t bytes = 0;
+    uint64_t messages = 0;
+    uint64_t nextSequence = 0;
+    uint64_t missing = 0;
+    uint64_t duplicates = 0;
+    Histogram latency;  // 写入虚拟串口到 TCP 接收端
+};
+
+struct Receiver {
+    const Options& options;
+    const std::vector<std::unique_ptr<SendPort>>& sent;
+    uint64_t startNs;  // 早于此刻或晚于收到时刻的写入时刻同样说明解析错位
+    std::vector<std::unique_ptr<ReceivePort>> ports;
+    Histogram uplinkLatency;  // 采集器读取到 TCP 接收端，仅多路复用
+    uint64_t corrupt = 0;     // 无法解析的片段（通常是采集端丢弃数据块导致消息被截断），以及序号不可能的消息
+    uint64_t joinedLines = 0; // 丢失了行尾换行符的文本消息
+    std::atomic<uint64_t> totalBytes{ 0 };    // 解析出的消息字节数，用于判断数据是否到齐
+    std::atomic<int> connections{ 0 };
+
+    Receiver(const Options& options, const std::vector<std::unique_ptr<SendPort>>& sent)
+        : options(options), sent(sent), startNs(nowNs()) {
+        for (int i = 0; i < options.ports; ++i) {
+            ports.push_back(std::make_unique<ReceivePort>());
+        }
+    }
+
+    void onMessage(uint64_t port, uint64_t sequence, uint64_t stampNs, size_t size, uint64_t now) {
+        if (port >= ports.size()) {
+            corrupt++;
+            return;
+        }
+        // 消息在写入虚拟串口前已计数，序号不小于已发送的消息数说明头部解析错位（例如文本过滤丢掉了
+        // 帧的一部分，序号读进了时间戳的字节），不能用它推进 nextSequence，否则之后的消息全部算作重复
+        if (sequence >= sent[port]->messages.load(std::memory_order_relaxed) || stampNs < startNs ||
+            stampNs > now) {
+            corrupt++;
+            return;
+        }
+        ReceivePort& state = *ports[port];
+        totalBytes.fetch_add(size, std::memory_order_relaxed);
+        state.bytes += size;
+        state.messages++;
+        if (sequence > state.nextSequence) {
+            state.missing += sequence - state.nextSequence;
+        } else if (sequence < state.nextSequence) {
+            state.duplicates++;
+        }
+        state.nextSequence = std::max(state.nextSequence, sequence + 1);
+        state.latency.record(now > stampNs ? now - stampNs : 0);
+    }
+
+    void parseLine(const std::string& buffer, size_t pos, size_t size, uint64_t now) {
+        unsigned port;
+        unsigned long long sequence, stamp;
+        if (buffer[pos] == '#' &&
+            std::sscanf(buffer.c_str() + pos, "#%u,%llu,%llu,", &port, &sequence, &stamp) == 3) {
+            onMessage(port, sequence, stamp, size, now);
+        } else {
+            corrupt++;
+        }
+    }
+
+    // 从一个串口的数据流中取出完整消息，剩余部分留在 buffer 中
+    void parse(std::string& buffer, uint64_t now) {
+        size_t pos = 0;
+        if (!options.binary) {
+            size_t end;
+            while ((end = buffer.find('\n', pos)) != std::string::npos) {
+                // 填充中没有 '#'，一行中出现多个 '#' 说明中间的换行丢了：
+                // 采集器的文本过滤会丢弃只含空白的数据块，单独读到的换行符就这样丢失
+                size_t next;
+                while ((next = buffer.find('#', pos + 1)) < end) {
+                    parseLine(buffer, pos, next - pos, now);
+                    joinedLines++;
+                    pos = next;
+                }
+                parseLine(buffer, pos, end + 1 - pos, now);
+                pos = end + 1;
+            }
+        } else {
+            auto get = [&buffer](size_t offset, size_t bytes) {
+                uint64_t value = 0;
+                for (size_t i = 0; i < bytes; ++i) {
+                    value |= static_cast<uint64_t>(static_cast<uint8_t>(buffer[offset + i])) << (8 * i);
+                }
+                return value;
+            };
+            while (buffer.size() - pos >= kBinaryHeader) {
+                uint64_t size = get(pos + 4, 4);
+                if (static_cast<uint8_t>(buffer[pos]) != kMagic0 ||
+                    static_cast<uint8_t>(buffer[pos + 1]) != kMagic1 ||
+                    size < kBinaryHeader || size > options.maxSize) {
+                    // 重新同步到下一个 magic
+                    corrupt++;
+                    size_t next = buffer.find(static_cast<char>(kMagic0), pos + 1);
+                    pos = next == std::string::npos ? buffer.size() : next;
+                    continue;
+                }
+                if (buffer.size() - pos < size) {
+                    break;
+                }
+                onMessage(get(pos + 2, 2), get(pos + 8, 8), get(pos + 16, 8), size, now);
+                pos += size;
+            }
+        }
+        buffer.erase(0, pos);
+    }
+
+    void run(int listener, const std::atomic<bool>& running) {
+        struct Connection {
+            int fd;
+            FrameDecoder decoder;
+            std::string stream;                    // 直连时整条连接是一个串口的数据流
+            std::map<uint16_t, std::string> streams;  // 多路复用时按 portId 分开
+        };
+        std::vector<std::unique_ptr<Connection>> connectionList;
+        std::vector<char> buffer(256 * 1024);
+
+        while (running) {
+            std::vector<pollfd> fds;
+            fds.push_back({ listener, POLLIN, 0 });
+            for (const auto& connection : connectionList) {
+                fds.push_back({ connection->fd, POLLIN, 0 });
+            }
+            if (poll(fds.data(), fds.size(), 50) <= 0) {
+                continue;
+            }
+            if (fds[0].revents & POLLIN) {
+                int fd = accept(listener, nullptr, nullptr);
+                if (fd >= 0) {
+                    connectionList.push_back(std::make_unique<Connection>(Connection{ fd, FrameDecoder(), {}, {} }));
+                    connections++;
+                }
+            }
+            for (size_t i = 1; i < fds.size(); ++i) {
+                if (!(fds[i].revents & (POLLIN | POLLHUP | POLLERR))) {
+                    continue;
+                }
+                Connection& connection = *connectionList[i - 1];
+                ssize_t n = recv(connection.fd, buffer.data(), buffer.size(), 0);
+                if (n <= 0) {
+                    close(connection.fd);
+                    connection.fd = -1;
+                    continue;
+                }
+                uint64_t now = nowNs();
+                if (!options.multiplex) {
+                    connection.stream.append(buffer.data(), static_cast<size_t>(n));
+                    parse(connection.stream, now);
+                    continue;
+                }
+                bool ok = connection.decoder.feed(buffer.data(), static_cast<size_t>(n),
+                    [&](const FrameHeader& header, const char* payload) {
+                        if (header.type != FrameType::Data) {
+                            return;
+                        }
+                        uplinkLatency.record(now > header.timestampNs ? now - header.timestampNs : 0);
+                        std::string& stream = connection.streams[header.portId];
+                        stream.append(payload, header.length);
+                        parse(stream, now);
+                    });
+                if (!ok) {
+                    corrupt++;
+                    close(connection.fd);
+                    connection.fd = -1;
+                }
+            }
+            connectionList.erase(std::remove_if(connectionList.begin(), connectionList.end(),
+                [](const std::unique_ptr<Connection>& connection) { return connection->fd < 0; }),
+                connectionList.end());
+        }
+        for (const auto& connection : connectionList) {
+            close(connection->fd);
+        }
+    }
+};
+
+// ---------------------------------------------------------------- 采集器进程
+
+// /proc/<pid>/stat 中的 utime + stime（秒）
+double processCpuSeconds(pid_t pid) {
+    std::ifstream file("/proc/" + std::to_string(pid) + "/stat");
+    std::string stat((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    size_t end = stat.rfind(')');
+    if (end == std::string::npos) {
+        return 0.0;
+    }
+    std::istringstream fields(stat.substr(end + 2));
+    std::string field;
+    unsigned long long utime = 0, stime = 0;
+    // ')' 之后从第 3 个字段（state）开始，utime/stime 是第 14、15 个字段
+    for (int index = 3; index <= 15 && fields >> field; ++index) {
+        if (index == 14) {
+            utime = std::stoull(field);
+        } else if (index == 15) {
+            stime = std::stoull(field);
+        }
+    }
+    return static_cast<double>(utime + stime) / sysconf(_SC_CLK_TCK);
+}
+
+pid_t spawnCollector(const std::string& executable, const std::string& workdir) {
+    pid_t pid = fork();
+    if (pid == 0) {
+        // 状态显示输出到 /dev/null，错误日志仍写在工作目录下
+        int devnull = ::open("/dev/null", O_WRONLY);
+        dup2(devnull, STDOUT_FILENO);
+        if (chdir(workdir.c_str()) != 0) {
+            _exit(127);
+        }
+        execl(executable.c_str(), executable.c_str(), static_cast<char*>(nullptr));
+        _exit(127);
+    }
+    return pid;
+}
+
+// 串口数据目录中保存的数据量：Record 格式为记录负载的总字节数（与写入的字节一一对应），
+// 其他格式为文件大小（文本格式在不以换行结尾的数据块后补换行，只能作为下限检查）
+uint64_t diskBytes(const std::filesystem::path& dir, bool record) {
+    std::error_code ec;
+    uint64_t total = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+        if (!entry.is_regular_file(ec)) {
+            continue;
+        }
+        if (!record) {
+            total += entry.file_size(ec);
+            continue;
+        }
+        RecordReader reader;
+        if (entry.path().extension() != ".rec" || !reader.open(entry.path().string())) {
+            continue;
+        }
+        uint64_t offset = reader.begin();
+        RecordReader::Record rec;
+        while (reader.next(offset, rec)) {
+            total += rec.size;
+        }
+    }
+    return total;
+}
+
+std::string formatMs(uint64_t ns) {
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(2) << ns / 1e6;
+    return oss.str();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        usage();
+        return 2;
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    std::string collector = std::filesystem::absolute(options.collector).string();
+    if (access(collector.c_str(), X_OK) != 0) {
+        std::cerr << "Collector not found: " << collector << std::endl;
+        return 2;
+    }
+    if (options.workdir.empty()) {
+        char pattern[] = "/tmp/loadbench.XXXXXX";
+        if (mkdtemp(pattern) == nullptr) {
+            std::cerr << "Failed to create working directory" << std::endl;
+            return 2;
+        }
+        options.workdir = pattern;
+    }
+    std::filesystem::path workdir = std::filesystem::absolute(options.workdir);
+    std::filesystem::create_directories(workdir);
+
+    // TCP 接收端，端口由系统分配
+    int listener = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addrLen = sizeof(addr);
+    if (bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(listener, 64) != 0 ||
+        getsockname(listener, reinterpret_cast<sockaddr*>(&addr), &addrLen) != 0) {
+        std::cerr << "Failed to listen: " << std::strerror(errno) << std::endl;
+        return 2;
+    }
+    int tcpPort = ntohs(addr.sin_port);
+
+    // 虚拟串口，从端设为原始模式，通过工作目录下的符号链接交给采集器
+    std::vector<std::unique_ptr<SendPort>> sendPorts;
+    json config;
+    config["ports"] = json::array();
+    if (!options.collectorJson.empty()) {
+        config["collector"] = options.collectorJson;
+    }
+    for (int i = 0; i < options.ports; ++i) {
+        auto port = std::make_unique<SendPort>();
+        if (openpty(&port->master, &port->slave, nullptr, nullptr, nullptr) != 0) {
+            std::cerr << "openpty failed: " << std::strerror(errno) << std::endl;
+            return 2;
+        }
+        termios tio;
+        tcgetattr(port->slave, &tio);
+        cfmakeraw(&tio);
+        tcsetattr(port->slave, TCSANOW, &tio);
+        fcntl(port->master, F_SETFL, fcntl(port->master, F_GETFL) | O_NONBLOCK);
+        fcntl(port->master, F_SETFD, FD_CLOEXEC);
+        fcntl(port->slave, F_SETFD, FD_CLOEXEC);
+        port->device = "bench" + std::to_string(i);
+        std::error_code ec;
+        std::filesystem::remove(workdir / port->device, ec);
+        std::filesystem::create_symlink(ttyname(port->slave), workdir / port->device);
+
+        json portJson = {
+            { "name", port->device }, { "baudRate", 115200 }, { "dataBits", 8 }, { "stopBits", 1 },
+            { "parity", "none" }, { "addTimestamp", false }, { "timeout", 3600 },
+            { "tcpForward", { { "enabled", true }, { "server", "127.0.0.1" }, { "port", tcpPort },
+                              { "reconnectInterval", 1 }, { "multiplex", options.multiplex },
+                              { "portId", i } } },
+        };
+        portJson.merge_patch(options.portJson);
+        config["ports"].push_back(portJson);
+        sendPorts.push_back(std::move(port));
+    }
+    std::ofstream(workdir / "config.json") << config.dump(2);
+    json firstPort = config["ports"][0];
+    bool recordFiles = firstPort.value("fileFormat", "text") == "record";
+    bool checkDisk = firstPort.value("compression", "none") == "none" &&
+                     (recordFiles || !firstPort.value("addTimestamp", false));
+
+    Receiver receiver(options, sendPorts);
+    std::atomic<bool> receiving(true);
+    std::thread receiveThread([&] { receiver.run(listener, receiving); });
+
+    pid_t pid = spawnCollector(collector, workdir.string());
+    int expectedConnections = options.multiplex ? 1 : options.ports;
+    auto waitDeadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (receiver.connections < expectedConnections && std::chrono::steady_clock::now() < waitDeadline &&
+           waitpid(pid, nullptr, WNOHANG) == 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    if (receiver.connections < expectedConnections) {
+        std::cerr << "Collector did not connect (see " << workdir.string() << ")" << std::endl;
+        kill(pid, SIGTERM);
+        waitpid(pid, nullptr, 0);
+        receiving = false;
+        receiveThread.join();
+        return 2;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));  // 等待所有串口打开
+
+    double cpuStart = processCpuSeconds(pid);
+    auto start = std::chrono::steady_clock::now();
+    std::thread sendThread(generate, std::cref(options), std::ref(sendPorts),
+                           start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                               std::chrono::duration<double>(options.seconds)));
+    sendThread.join();
+    auto sendEnd = std::chrono::steady_clock::now();
+
+    // 等待剩余数据到达：接收字节数 500ms 不再变化或超时
+    uint64_t sentTotal = 0;
+    for (const auto& port : sendPorts) {
+        sentTotal += port->bytes;
+    }
+    auto drainDeadline = sendEnd + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(options.drainSeconds));
+    uint64_t lastReceived = receiver.totalBytes;
+    auto lastChange = std::chrono::steady_clock::now();
+    while (std::chrono::steady_clock::now() < drainDeadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        uint64_t received = receiver.totalBytes;
+        if (received != lastReceived) {
+            lastReceived = received;
+            lastChange = std::chrono::steady_clock::now();
+        } else if (received >= sentTotal || std::chrono::steady_clock::now() - lastChange > std::chrono::milliseconds(500)) {
+            break;
+        }
+    }
+    double cpuSeconds = processCpuSeconds(pid) - cpuStart;
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double sendSeconds = std::chrono::duration<double>(sendEnd - start).count();
+
+    // 采集器应在收到 SIGTERM 后刷新数据并退出，超时则强制结束并判为失败
+    kill(pid, SIGTERM);
+    int status = 0;
+    auto exitDeadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (waitpid(pid, &status, WNOHANG) == 0) {
+        if (std::chrono::steady_clock::now() >= exitDeadline) {
+            std::cerr << "Collector did not exit after SIGTERM" << std::endl;
+            kill(pid, SIGKILL);
+            waitpid(pid, &status, 0);
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    receiving = false;
+    receiveThread.join();
+    close(listener);
+    for (auto& port : sendPorts) {
+        close(port->master);
+        close(port->slave);
+    }
+
+    // 汇总
+    std::cout << std::setw(8) << "Port" << std::setw(12) << "Sent(B)" << std::setw(12) << "Recv(B)"
+              << std::setw(12) << "Disk(B)" << std::setw(10) << "Msgs" << std::setw(8) << "Lost"
+              << std::setw(6) << "Dup" << std::setw(10) << "p50(ms)" << std::setw(10) << "p99(ms)"
+              << std::setw(10) << "p999(ms)" << std::endl;
+    Histogram total;
+    uint64_t sentMessages = 0, lostMessages = 0, receivedBytes = 0, diskShort = 0;
+    json portsJson = json::array();
+    for (size_t i = 0; i < sendPorts.size(); ++i) {
+        const SendPort& sent = *sendPorts[i];
+        const ReceivePort& received = *receiver.ports[i];
+        uint64_t unique = received.messages - received.duplicates;
+        uint64_t lost = sent.messages > unique ? sent.messages - unique : 0;
+        uint64_t disk = diskBytes(workdir / "data" / sent.device, recordFiles);
+        if (checkDisk && disk < sent.bytes) {
+            diskShort += sent.bytes - disk;
+        }
+        sentMessages += sent.messages;
+        lostMessages += lost;
+        receivedBytes += received.bytes;
+        total.merge(received.latency);
+        std::cout << std::setw(8) << sent.device << std::setw(12) << sent.bytes.load()
+                  << std::setw(12) << received.bytes << std::setw(12) << disk
+                  << std::setw(10) << received.messages << std::setw(8) << lost
+                  << std::setw(6) << received.duplicates
+                  << std::setw(10) << formatMs(received.latency.percentileNs(0.5))
+                  << std::setw(10) << formatMs(received.latency.percentileNs(0.99))
+                  << std::setw(10) << formatMs(received.latency.percentileNs(0.999)) << std::endl;
+        portsJson.push_back({ { "port", sent.device }, { "sentBytes", sent.bytes.load() },
+                              { "receivedBytes", received.bytes }, { "diskBytes", disk },
+                              { "messages", received.messages }, { "lost", lost },
+                              { "duplicates", received.duplicates },
+                              { "p99Ms", received.latency.percentileNs(0.99) / 1e6 } });
+    }
+
+    double lossFraction = sentMessages > 0 ? static_cast<double>(lostMessages + receiver.corrupt) / sentMessages : 0.0;
+    double throughput = receivedBytes / sendSeconds;
+    double cpuPercent = cpuSeconds / wallSeconds * 100.0;
+    std::cout << std::fixed << std::setprecision(2)
+              << "Throughput:  " << throughput / 1e6 << " MB/s (" << throughput / options.ports
+              << " B/s per port) over " << sendSeconds << " s\n"
+              << "Latency:     write->sink p50 " << formatMs(total.percentileNs(0.5))
+              << " p99 " << formatMs(total.percentileNs(0.99))
+              << " p999 " << formatMs(total.percentileNs(0.999))
+              << " max " << formatMs(total.percentileNs(1.0)) << " ms\n";
+    if (options.multiplex) {
+        std::cout << "             read->sink  p50 " << formatMs(receiver.uplinkLatency.percentileNs(0.5))
+                  << " p99 " << formatMs(receiver.uplinkLatency.percentileNs(0.99))
+                  << " max " << formatMs(receiver.uplinkLatency.percentileNs(1.0)) << " ms\n";
+    }
+    std::cout << "CPU:         " << cpuPercent << "% total, " << cpuPercent / options.ports << "% per port, "
+              << (receivedBytes > 0 ? cpuSeconds * 1e3 / (receivedBytes / 1048576.0) : 0.0) << " ms/MB\n"
+              << "Loss:        " << lostMessages << " of " << sentMessages << " messages lost, "
+              << receiver.corrupt << " corrupt";
+    if (receiver.joinedLines > 0) {
+        std::cout << ", " << receiver.joinedLines << " line breaks dropped";
+    }
+    if (checkDisk) {
+        std::cout << ", " << diskShort << " bytes missing on disk";
+    }
+    std::cout << std::endl;
+
+    bool failed = lossFraction > options.maxLoss || (options.maxLoss == 0.0 && diskShort > 0) ||
+                  !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+    if (options.jsonOutput) {
+        json summary = {
+            { "ports", portsJson }, { "throughputBytesPerSec", throughput },
+            { "latencyP50Ms", total.percentileNs(0.5) / 1e6 }, { "latencyP99Ms", total.percentileNs(0.99) / 1e6 },
+            { "latencyP999Ms", total.percentileNs(0.999) / 1e6 }, { "cpuPercent", cpuPercent },
+            { "lostMessages", lostMessages }, { "corrupt", receiver.corrupt },
+            { "joinedLines", receiver.joinedLines }, { "diskShortBytes", diskShort },
+            { "passed", !failed },
+        };
+        std::cout << summary.dump() << std::endl;
+    }
+
+    if (failed) {
+        std::cerr << "FAILED (working directory kept: " << workdir.string() << ")" << std::endl;
+        return 1;
+    }
+    if (!options.keep) {
+        std::error_code ec;
+        std::filesystem::remove_all(workdir, ec);
+    }
+    return 0;
+}
@@ -0,0 +1,177 @@
+#include "Logger.h"
+#include <algorithm>
+#include <filesystem>
+#include <functional>
+#include <vector>
+
+namespace {
+
+constexpr size_t kQueueCapacity = 4096;
+// 写日志线程批量处理的间隔，调用方不通知写日志线程
+constexpr auto kBatchInterval = std::chrono::milliseconds(100);
+// 相同的消息在该时间内只写第一条，限速丢弃的汇总也按该间隔写入
+constexpr auto kRepeatWindow = std::chrono::seconds(10);
+// 每个串口平均每 200ms 一条，允许 50 条的突发
+constexpr int64_t kIntervalNs = 200000000;
+constexpr int64_t kBurstNs = 50 * kIntervalNs;
+
+std::string repeatKey(const std::string& port, const std::string& message) {
+    std::string key;
+    key.reserve(port.size() + 1 + message.size());
+    key += port;
+    key += '\n';
+    key += message;
+    return key;
+}
+
+} // namespace
+
+Logger::Logger()
+    : m_queue(kQueueCapacity), m_dropped(0), m_running(true), m_reportedDrops(0) {
+    m_thread = std::thread(&Logger::run, this);
+}
+
+Logger::~Logger() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+    }
+    m_stopped.notify_all();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+size_t Logger::rateSlot(const std::string& port) {
+    return std::hash<std::string>{}(port) & (kRateSlots - 1);
+}
+
+void Logger::logError(const std::string& portName, const std::string& message) {
+    // 在入队前限速，串口反复出错时不会占满队列挤掉其他串口的日志
+    RateSlot& rate = m_rate[rateSlot(portName)];
+    int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    int64_t allowed = rate.allowedNs.load(std::memory_order_relaxed);
+    for (;;) {
+        int64_t base = (std::max)(allowed, now);
+        if (base - now > kBurstNs) {
+            rate.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if (rate.allowedNs.compare_exchange_weak(allowed, base + kIntervalNs,
+                                                 std::memory_order_relaxed)) {
+            break;
+        }
+    }
+
+    if (!m_queue.push(Record{ Clock::now(), portName, message })) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void Logger::run() {
+    std::vector<Record> batch;
+    for (;;) {
+        // 先读退出标志再取队列，退出前入队的记录都会写入
+        bool stopping = !m_running.load();
+        Record record;
+        while (m_queue.pop(record)) {
+            batch.push_back(std::move(record));
+        }
+        for (const auto& item : batch) {
+            accept(item);
+        }
+        batch.clear();
+
+        auto now = Clock::now();
+        uint64_t dropped = m_dropped.load(std::memory_order_relaxed);
+        if (dropped != m_reportedDrops) {
+            write(now, "Logger", std::to_string(dropped - m_reportedDrops) +
+                  " messages dropped, log queue full");
+            m_reportedDrops = dropped;
+        }
+        sweep(now, stopping);
+        if (m_file.is_open()) {
+            m_file.flush();
+        }
+        if (stopping) {
+            break;
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_stopped.wait_for(lock, kBatchInterval, [this] { return !m_running.load(); });
+    }
+}
+
+void Logger::accept(const Record& record) {
+    m_slotReports[rateSlot(record.port)].port = record.port;
+
+    // 窗口内重复的消息只计数
+    std::string key = repeatKey(record.port, record.message);
+    auto repeat = m_repeats.find(key);
+    if (repeat == m_repeats.end()) {
+        m_repeats.emplace(std::move(key), Repeat{ record.time, 0 });
+    } else if (record.time - repeat->second.first < kRepeatWindow) {
+        ++repeat->second.suppressed;
+        return;
+    } else {
+        if (repeat->second.suppressed > 0) {
+            write(record.time, record.port, record.message + " (repeated " +
+                  std::to_string(repeat->second.suppressed) + " more times)");
+        }
+        repeat->second = Repeat{ record.time, 0 };
+    }
+    write(record.time, record.port, record.message);
+}
+
+void Logger::sweep(Clock::time_point now, bool force) {
+    for (auto it = m_repeats.begin(); it != m_repeats.end();) {
+        if (!force && now - it->second.first < kRepeatWindow) {
+            ++it;
+            continue;
+        }
+        if (it->second.suppressed > 0) {
+            size_t split = it->first.find('\n');
+            write(now, it->first.substr(0, split), it->first.substr(split + 1) + " (repeated " +
+                  std::to_string(it->second.suppressed) + " more times)");
+        }
+        it = m_repeats.erase(it);
+    }
+
+    for (size_t i = 0; i < kRateSlots; ++i) {
+        SlotReport& report = m_slotReports[i];
+        if (m_rate[i].dropped.load(std::memory_order_relaxed) == 0 ||
+            (!force && now - report.reported < kRepeatWindow)) {
+            continue;
+        }
+        uint64_t dropped = m_rate[i].dropped.exchange(0, std::memory_order_relaxed);
+        write(now, report.port.empty() ? "Logger" : report.port,
+              std::to_string(dropped) + " messages dropped by the log rate limit");
+        report.reported = now;
+    }
+}
+
+void Logger::write(Clock::time_point time, const std::string& port, const std::string& message) {
+    char prefix[TimestampFormatter::kMaxLength];
+    size_t length = m_formatter.format(time, prefix);
+
+    // "[2024-01-18 12:34:56] " 中的日期决定日志文件
+    std::string date(prefix + 1, 10);
+    date.erase(7, 1);
+    date.erase(4, 1);
+    if (date != m_fileDate || !m_file.is_open()) {
+        m_file.close();
+        std::error_code ec;
+        std::filesystem::path dirPath = "error";
+        std::filesystem::create_directories(dirPath, ec);
+        m_file.clear();
+        m_file.open(dirPath / (date + ".log"), std::ios::app);
+        m_fileDate = date;
+        if (!m_file.is_open()) {
+            return;
+        }
+    }
+
+    m_file.write(prefix, static_cast<std::streamsize>(length));
+    m_file << port << ": " << message << '\n';
+}
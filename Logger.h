@@ -1,12 +1,21 @@
 #pragma once
-#include <string>
-#include <mutex>
-#include <filesystem>
-#include <fstream>
+#include <atomic>
 #include <chrono>
-#include <iomanip>
-#include <sstream>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include "Common.h"
+#include "MpscRing.h"
+#include "Timestamp.h"
 
+// 错误日志，写入 error/YYYYMMDD.log
+// logError() 只做无锁的限速检查并把记录放入无锁队列，不加锁、不做文件操作，
+// 超出串口的速率或队列满时丢弃并计数；后台线程批量写入保持打开的日志文件，
+// 相同的消息在一段时间内只写一次，被合并或丢弃的条数随后写入一条汇总
 class Logger {
 public:
     static Logger& getInstance() {
@@ -14,31 +23,60 @@ public:
         return instance;
     }
 
-    void logError(const std::string& portName, const std::string& message) {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        
-        auto now = std::chrono::system_clock::now();
-        auto time = std::chrono::system_clock::to_time_t(now);
-        struct tm timeinfo;
-        localtime_s(&timeinfo, &time);
-
-        std::filesystem::path dirPath = "error";
-        std::filesystem::create_directories(dirPath);
-
-        std::ostringstream filename;
-        filename << std::put_time(&timeinfo, "%Y%m%d") << ".log";
-        auto filepath = dirPath / filename.str();
-
-        std::ofstream file(filepath, std::ios::app);
-        if (file.is_open()) {
-            file << "[" << std::put_time(&timeinfo, "%Y-%m-%d %H:%M:%S") << "] "
-                 << portName << ": " << message << std::endl;
-        }
-    }
+    void logError(const std::string& portName, const std::string& message);
+
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
 
 private:
-    Logger() = default;
-    std::mutex m_mutex;
+    using Clock = std::chrono::system_clock;
+
+    struct Record {
+        Clock::time_point time;
+        std::string port;
+        std::string message;
+    };
+
+    // 按串口名哈希分槽的限速状态（GCRA），不同串口落在同一槽时共用额度
+    struct RateSlot {
+        std::atomic<int64_t> allowedNs{ 0 };  // 理论到达时间，超前当前时间一个突发量后开始丢弃
+        std::atomic<uint64_t> dropped{ 0 };
+    };
+    static constexpr size_t kRateSlots = 256;
+
+    // 以下状态只在写日志线程中访问
+    struct Repeat {
+        Clock::time_point first;  // 本轮合并窗口的开始
+        uint64_t suppressed;
+    };
+    struct SlotReport {
+        std::string port;  // 最近一条写入该槽的串口名
+        Clock::time_point reported;
+    };
+
+    Logger();
+    ~Logger();
+
+    void run();
+    void accept(const Record& record);
+    void sweep(Clock::time_point now, bool force);
+    static size_t rateSlot(const std::string& port);
+    void write(Clock::time_point time, const std::string& port, const std::string& message);
+
+    MpscRing<Record> m_queue;
+    RateSlot m_rate[kRateSlots];
+    std::atomic<uint64_t> m_dropped;
+    std::atomic<bool> m_running;
+    std::mutex m_mutex;  // 只用于退出时唤醒写日志线程
+    std::condition_variable m_stopped;
+    std::thread m_thread;
+
+    std::unordered_map<std::string, Repeat> m_repeats;  // 串口名 + 消息
+    SlotReport m_slotReports[kRateSlots];
+    uint64_t m_reportedDrops;
+    TimestampFormatter m_formatter;
+    std::ofstream m_file;
+    std::string m_fileDate;  // 当前打开的日志文件对应的日期
 };
 
-#define LOG_ERROR(port, msg) Logger::getInstance().logError(port, msg) 
\ No newline at end of file
+#define LOG_ERROR(port, msg) Logger::getInstance().logError(port, msg)
@@ -0,0 +1,25 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+
+// 所有串口的数据块内存的全局预算，各串口的数据块池取出和归还数据块时记账（见 ChunkPool）
+// 每个串口另有自己的预算（PortConfig::memoryBudgetKB），超出任一预算时按串口的 memoryPolicy 处理
+class MemoryBudget {
+public:
+    // limit 为 0 时只统计不限制
+    explicit MemoryBudget(size_t limit = 0) : m_limit(limit), m_used(0) {}
+
+    MemoryBudget(const MemoryBudget&) = delete;
+    MemoryBudget& operator=(const MemoryBudget&) = delete;
+
+    void charge(size_t bytes) { m_used.fetch_add(bytes, std::memory_order_relaxed); }
+    void credit(size_t bytes) { m_used.fetch_sub(bytes, std::memory_order_relaxed); }
+
+    size_t used() const { return m_used.load(std::memory_order_relaxed); }
+    size_t limit() const { return m_limit; }
+    bool exceeded() const { return m_limit > 0 && used() > m_limit; }
+
+private:
+    size_t m_limit;
+    std::atomic<size_t> m_used;
+};
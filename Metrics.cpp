@@ -0,0 +1,164 @@
+#include "Metrics.h"
+#include <cstdio>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace {
+
+int highestBit(uint64_t value) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return static_cast<int>(index);
+#else
+    return 63 - __builtin_clzll(value);
+#endif
+}
+
+constexpr int kExportMinBits = 10;
+constexpr int kExportMaxBits = 35;
+
+} // namespace
+
+size_t Histogram::bucketIndex(uint64_t valueNs) {
+    if (valueNs < kSubBuckets) {
+        return static_cast<size_t>(valueNs);
+    }
+    if (valueNs >> kMaxBits) {
+        return kBuckets - 1;
+    }
+    int bit = highestBit(valueNs);
+    int shift = bit - kSubBucketBits;
+    return static_cast<size_t>(shift + 1) * kSubBuckets +
+           static_cast<size_t>((valueNs >> shift) & (kSubBuckets - 1));
+}
+
+uint64_t Histogram::bucketUpperNs(size_t index) {
+    if (index < kSubBuckets) {
+        return index + 1;
+    }
+    int shift = static_cast<int>(index / kSubBuckets) - 1;
+    uint64_t lower = static_cast<uint64_t>(kSubBuckets + index % kSubBuckets) << shift;
+    return lower + (uint64_t(1) << shift);
+}
+
+void Histogram::record(uint64_t valueNs) {
+    m_counts[bucketIndex(valueNs)].fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(valueNs, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Histogram::merge(const Histogram& other) {
+    for (size_t i = 0; i < kBuckets; ++i) {
+        m_counts[i].fetch_add(other.bucketCount(i), std::memory_order_relaxed);
+    }
+    m_sum.fetch_add(other.sumNs(), std::memory_order_relaxed);
+    m_count.fetch_add(other.count(), std::memory_order_relaxed);
+}
+
+uint64_t Histogram::countBelow(uint64_t valueNs) const {
+    size_t end = valueNs >> kMaxBits ? kBuckets : bucketIndex(valueNs);
+    uint64_t total = 0;
+    for (size_t i = 0; i < end; ++i) {
+        total += bucketCount(i);
+    }
+    return total;
+}
+
+uint64_t Histogram::percentileNs(double quantile) const {
+    uint64_t counts[kBuckets];
+    uint64_t total = 0;
+    for (size_t i = 0; i < kBuckets; ++i) {
+        counts[i] = bucketCount(i);
+        total += counts[i];
+    }
+    if (total == 0) {
+        return 0;
+    }
+    auto rank = static_cast<uint64_t>(quantile * static_cast<double>(total - 1)) + 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets; ++i) {
+        seen += counts[i];
+        if (seen >= rank) {
+            return bucketUpperNs(i);
+        }
+    }
+    return bucketUpperNs(kBuckets - 1);
+}
+
+void PrometheusText::family(const char* name, const char* type, const char* help) {
+    m_text += "# HELP ";
+    m_text += name;
+    m_text += ' ';
+    m_text += help;
+    m_text += "\n# TYPE ";
+    m_text += name;
+    m_text += ' ';
+    m_text += type;
+    m_text += '\n';
+}
+
+void PrometheusText::sample(const char* name, const std::string& labels, double value) {
+    char number[32];
+    std::snprintf(number, sizeof(number), "%.9g", value);
+    m_text += name;
+    if (!labels.empty()) {
+        m_text += '{' + labels + '}';
+    }
+    m_text += ' ';
+    m_text += number;
+    m_text += '\n';
+}
+
+void PrometheusText::sample(const char* name, const std::string& labels, uint64_t value) {
+    m_text += name;
+    if (!labels.empty()) {
+        m_text += '{' + labels + '}';
+    }
+    m_text += ' ';
+    m_text += std::to_string(value);
+    m_text += '\n';
+}
+
+void PrometheusText::histogram(const char* name, const std::string& labels, const Histogram& histogram) {
+    // 细分桶在 2 的幂处对齐，按 2 的幂汇总的累计计数是准确的（le 按小于计，恰好等于边界的整数纳秒计入下一个桶）
+    std::string bucket = std::string(name) + "_bucket";
+    std::string prefix = labels.empty() ? std::string() : labels + ",";
+    uint64_t cumulative = 0;
+    size_t index = 0;
+    for (int bits = kExportMinBits; bits <= kExportMaxBits; ++bits) {
+        size_t end = Histogram::bucketIndex(uint64_t(1) << bits);
+        for (; index < end; ++index) {
+            cumulative += histogram.bucketCount(index);
+        }
+        char le[32];
+        std::snprintf(le, sizeof(le), "%.9g", static_cast<double>(uint64_t(1) << bits) / 1e9);
+        sample(bucket.c_str(), prefix + label("le", le), cumulative);
+    }
+    for (; index < Histogram::kBuckets; ++index) {
+        cumulative += histogram.bucketCount(index);
+    }
+    sample(bucket.c_str(), prefix + label("le", "+Inf"), cumulative);
+    sample((std::string(name) + "_sum").c_str(), labels, histogram.sumNs() / 1e9);
+    // _count 与 +Inf 桶一致，各桶不是同一时刻读取的，不用 count()
+    sample((std::string(name) + "_count").c_str(), labels, cumulative);
+}
+
+std::string PrometheusText::label(const char* key, const std::string& value) {
+    std::string text = key;
+    text += "=\"";
+    for (char c : value) {
+        if (c == '\\' || c == '"') {
+            text += '\\';
+            text += c;
+        } else if (c == '\n') {
+            text += "\\n";
+        } else {
+            text += c;
+        }
+    }
+    text += '"';
+    return text;
+}
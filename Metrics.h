@@ -0,0 +1,80 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// 无锁计数器，独占一个缓存行：不同线程更新同一串口的不同计数器时不会互相使缓存失效
+struct alignas(64) Counter {
+    std::atomic<uint64_t> value{ 0 };
+
+    void add(uint64_t n = 1) { value.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t load() const { return value.load(std::memory_order_relaxed); }
+};
+
+// HDR 风格的延迟直方图（纳秒）：每个 2 的幂区间再线性分为 16 个子桶，相对误差不超过 1/16
+// 记录只是一次原子加，可以在任意线程进行；读取时各桶之间不是同一时刻的快照
+class Histogram {
+public:
+    static constexpr int kSubBucketBits = 4;
+    static constexpr size_t kSubBuckets = size_t(1) << kSubBucketBits;
+    static constexpr int kMaxBits = 40;  // 超过约 18 分钟的值计入最后一个桶
+    static constexpr size_t kBuckets = (kMaxBits - kSubBucketBits + 1) * kSubBuckets;
+
+    void record(uint64_t valueNs);
+    void record(std::chrono::nanoseconds value) {
+        record(value.count() > 0 ? static_cast<uint64_t>(value.count()) : 0);
+    }
+
+    void merge(const Histogram& other);
+
+    uint64_t count() const { return m_count.load(std::memory_order_relaxed); }
+    uint64_t sumNs() const { return m_sum.load(std::memory_order_relaxed); }
+    uint64_t bucketCount(size_t index) const { return m_counts[index].load(std::memory_order_relaxed); }
+    // 小于 valueNs 的记录数，valueNs 为 2 的幂时准确
+    uint64_t countBelow(uint64_t valueNs) const;
+    // 分位数（0-1）所在桶的上界
+    uint64_t percentileNs(double quantile) const;
+
+    static size_t bucketIndex(uint64_t valueNs);
+    static uint64_t bucketUpperNs(size_t index);  // 桶内值 < 上界
+
+private:
+    std::atomic<uint64_t> m_counts[kBuckets] = {};
+    alignas(64) std::atomic<uint64_t> m_count{ 0 };
+    std::atomic<uint64_t> m_sum{ 0 };
+};
+
+// 单个串口的运行指标，采集、写盘、TCP 发送线程各自更新，状态显示和统计接口只读
+struct PortMetrics {
+    Counter bytesRead;
+    Counter chunksRead;
+    Counter readErrors;
+    Counter framingErrors;
+    Counter tcpBytes;  // 直接发送的字节数；存储转发回放的数据不计入
+    Counter budgetDrops;      // 超出内存预算按 memoryPolicy 丢弃的数据块，队列满的丢弃另计
+    Counter budgetBlockedUs;  // memoryPolicy 为 block 时读取线程等待的时间
+    std::atomic<int64_t> lastDataNs{ 0 };  // 最近一次读到数据的 steady_clock 时刻，0 为从未收到
+
+    Histogram readLatency;  // 首字节到达到 read() 返回（估计值）
+    Histogram diskLatency;  // read() 返回到写入数据文件缓冲
+    Histogram tcpLatency;   // read() 返回到交给内核发送
+};
+
+// Prometheus 文本格式（0.0.4）的输出
+// 同一指标的所有样本必须连续：先 family() 写说明和类型，再逐个串口写样本
+class PrometheusText {
+public:
+    void family(const char* name, const char* type, const char* help);
+    void sample(const char* name, const std::string& labels, double value);
+    void sample(const char* name, const std::string& labels, uint64_t value);
+    // 以秒为单位输出 _bucket/_sum/_count，桶边界为 2^10 ~ 2^35 纳秒（约 1us ~ 34s）
+    void histogram(const char* name, const std::string& labels, const Histogram& histogram);
+
+    static std::string label(const char* key, const std::string& value);
+    const std::string& str() const { return m_text; }
+
+private:
+    std::string m_text;
+};
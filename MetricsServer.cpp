@@ -0,0 +1,256 @@
+#include "MetricsServer.h"
+#include "Logger.h"
+#include <cstring>
+#include <vector>
+
+#ifdef _WIN32
+    #include <winsock2.h>
+    #include <ws2tcpip.h>
+    #pragma comment(lib, "ws2_32.lib")
+#else
+    #include <sys/socket.h>
+    #include <sys/un.h>
+    #include <sys/eventfd.h>
+    #include <netinet/in.h>
+    #include <arpa/inet.h>
+    #include <poll.h>
+    #include <unistd.h>
+    #include <errno.h>
+    #define SOCKET_ERROR (-1)
+    #define INVALID_SOCKET (-1)
+#endif
+
+namespace {
+
+// 读取请求头的上限和超时，统计接口不需要处理大请求
+constexpr size_t kMaxRequest = 8192;
+constexpr int kRequestTimeoutMs = 1000;
+
+#ifdef _WIN32
+inline int closeSocket(SOCKET s) { return closesocket(s); }
+inline int pollSockets(WSAPOLLFD* fds, ULONG count, int timeout) { return WSAPoll(fds, count, timeout); }
+using PollFd = WSAPOLLFD;
+#else
+inline int closeSocket(int s) { return ::close(s); }
+inline int pollSockets(pollfd* fds, nfds_t count, int timeout) { return ::poll(fds, count, timeout); }
+using PollFd = pollfd;
+#endif
+
+#ifdef _WIN32
+bool sendAll(SOCKET s, const char* data, size_t size) {
+#else
+bool sendAll(int s, const char* data, size_t size) {
+#endif
+    while (size > 0) {
+#ifdef _WIN32
+        int sent = ::send(s, data, static_cast<int>(size), 0);
+#else
+        ssize_t sent = ::send(s, data, size, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+#endif
+        if (sent <= 0) {
+            return false;
+        }
+        data += sent;
+        size -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+} // namespace
+
+MetricsServer::MetricsServer(Render render)
+    : m_render(std::move(render)), m_running(false),
+      m_tcpSocket(INVALID_SOCKET), m_unixSocket(INVALID_SOCKET) {
+#ifdef _WIN32
+    WSADATA wsaData;
+    WSAStartup(MAKEWORD(2, 2), &wsaData);
+#else
+    m_wakeFd = -1;
+#endif
+}
+
+MetricsServer::~MetricsServer() {
+    stop();
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+bool MetricsServer::start(const std::string& address, int port, const std::string& socketPath) {
+    if (port > 0) {
+        m_tcpSocket = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(port));
+        int reuse = 1;
+        if (m_tcpSocket == INVALID_SOCKET ||
+            setsockopt(m_tcpSocket, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse),
+                       sizeof(reuse)) == SOCKET_ERROR ||
+            inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1 ||
+            ::bind(m_tcpSocket, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == SOCKET_ERROR ||
+            ::listen(m_tcpSocket, 16) == SOCKET_ERROR) {
+            LOG_ERROR("Metrics", "Failed to listen on " + address + ":" + std::to_string(port));
+            closeAll();
+            return false;
+        }
+    }
+
+#ifndef _WIN32
+    if (!socketPath.empty()) {
+        sockaddr_un addr = {};
+        addr.sun_family = AF_UNIX;
+        if (socketPath.size() >= sizeof(addr.sun_path)) {
+            LOG_ERROR("Metrics", "Unix socket path too long: " + socketPath);
+            closeAll();
+            return false;
+        }
+        std::memcpy(addr.sun_path, socketPath.c_str(), socketPath.size() + 1);
+        // 上次异常退出留下的套接字文件会导致 bind 失败
+        ::unlink(socketPath.c_str());
+        m_unixSocket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (m_unixSocket == INVALID_SOCKET ||
+            ::bind(m_unixSocket, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+            ::listen(m_unixSocket, 16) != 0) {
+            LOG_ERROR("Metrics", "Failed to listen on " + socketPath);
+            closeAll();
+            return false;
+        }
+        m_socketPath = socketPath;
+    }
+    m_wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (m_wakeFd < 0) {
+        closeAll();
+        return false;
+    }
+#else
+    (void)socketPath;
+#endif
+
+    if (m_tcpSocket == INVALID_SOCKET && m_unixSocket == INVALID_SOCKET) {
+        closeAll();
+        return false;
+    }
+    m_running = true;
+    m_thread = std::thread(&MetricsServer::run, this);
+    return true;
+}
+
+void MetricsServer::stop() {
+    if (m_running.exchange(false)) {
+#ifndef _WIN32
+        uint64_t one = 1;
+        ssize_t ignored = ::write(m_wakeFd, &one, sizeof(one));
+        (void)ignored;
+#endif
+        if (m_thread.joinable()) {
+            m_thread.join();
+        }
+    }
+    closeAll();
+}
+
+void MetricsServer::closeAll() {
+    if (m_tcpSocket != INVALID_SOCKET) {
+        closeSocket(m_tcpSocket);
+        m_tcpSocket = INVALID_SOCKET;
+    }
+    if (m_unixSocket != INVALID_SOCKET) {
+        closeSocket(m_unixSocket);
+        m_unixSocket = INVALID_SOCKET;
+    }
+#ifndef _WIN32
+    if (!m_socketPath.empty()) {
+        ::unlink(m_socketPath.c_str());
+        m_socketPath.clear();
+    }
+    if (m_wakeFd >= 0) {
+        ::close(m_wakeFd);
+        m_wakeFd = -1;
+    }
+#endif
+}
+
+void MetricsServer::run() {
+    std::vector<PollFd> fds;
+    for (Socket s : { m_tcpSocket, m_unixSocket }) {
+        if (s != INVALID_SOCKET) {
+            PollFd fd = {};
+            fd.fd = s;
+            fd.events = POLLIN;
+            fds.push_back(fd);
+        }
+    }
+#ifndef _WIN32
+    PollFd wake = {};
+    wake.fd = m_wakeFd;
+    wake.events = POLLIN;
+    fds.push_back(wake);
+    const int timeout = -1;
+#else
+    const int timeout = 500;  // Windows 下没有唤醒描述符，定期检查是否停止
+#endif
+
+    while (m_running) {
+        int ready = pollSockets(fds.data(), static_cast<decltype(fds.size())>(fds.size()), timeout);
+        if (ready <= 0) {
+            continue;
+        }
+        for (const auto& fd : fds) {
+            if (!m_running) {
+                break;
+            }
+            bool listener = fd.fd == m_tcpSocket || fd.fd == m_unixSocket;
+            if (!listener || !(fd.revents & POLLIN)) {
+                continue;
+            }
+            Socket client = ::accept(fd.fd, nullptr, nullptr);
+            if (client != INVALID_SOCKET) {
+                serve(client);
+                closeSocket(client);
+            }
+        }
+    }
+}
+
+void MetricsServer::serve(Socket client) {
+    // 读到请求头结束为止，只看请求行
+    std::string request;
+    char buffer[1024];
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < kMaxRequest) {
+        PollFd fd = {};
+        fd.fd = client;
+        fd.events = POLLIN;
+        if (pollSockets(&fd, 1, kRequestTimeoutMs) <= 0) {
+            return;
+        }
+        int received = static_cast<int>(::recv(client, buffer, sizeof(buffer), 0));
+        if (received <= 0) {
+            return;
+        }
+        request.append(buffer, static_cast<size_t>(received));
+    }
+
+    std::string status = "200 OK";
+    std::string body;
+    size_t end = request.find("\r\n");
+    std::string line = request.substr(0, end);
+    if (line.rfind("GET ", 0) != 0) {
+        status = "405 Method Not Allowed";
+    } else {
+        std::string path = line.substr(4, line.find(' ', 4) - 4);
+        if (path == "/metrics" || path == "/") {
+            body = m_render();
+        } else {
+            status = "404 Not Found";
+        }
+    }
+
+    std::string response = "HTTP/1.1 " + status + "\r\n"
+                            "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                            "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                            "Connection: close\r\n\r\n" + body;
+    sendAll(client, response.data(), response.size());
+}
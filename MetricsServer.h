@@ -0,0 +1,45 @@
+#pragma once
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+
+// 本地统计接口：用 HTTP 返回 Prometheus 文本格式的指标，可监听 TCP 端口和 Unix 套接字
+// 请求在一个线程中逐个处理，每次请求时调用 render 生成内容
+//   curl http://127.0.0.1:9100/metrics
+//   curl --unix-socket /run/collector.sock http://localhost/metrics
+class MetricsServer {
+public:
+    using Render = std::function<std::string()>;
+
+    explicit MetricsServer(Render render);
+    ~MetricsServer();
+
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    // port 为 0 时不监听 TCP；socketPath 为空时不监听 Unix 套接字（仅 POSIX）
+    bool start(const std::string& address, int port, const std::string& socketPath);
+    void stop();
+
+private:
+#ifdef _WIN32
+    using Socket = unsigned long long;
+#else
+    using Socket = int;
+#endif
+
+    void run();
+    void serve(Socket client);
+    void closeAll();
+
+    Render m_render;
+    std::atomic<bool> m_running;
+    std::thread m_thread;
+    Socket m_tcpSocket;
+    Socket m_unixSocket;
+    std::string m_socketPath;
+#ifndef _WIN32
+    int m_wakeFd;
+#endif
+};
@@ -0,0 +1,76 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// 有界无锁多生产者/单消费者环形队列（每个槽位带序号，Vyukov 的有界队列）
+// push() 可在任意线程调用，队列满时立即返回 false；pop() 只能在一个线程调用
+template <typename T>
+class MpscRing {
+public:
+    explicit MpscRing(size_t capacity) : m_head(0), m_tail(0) {
+        size_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        m_slots.reset(new Slot[size]);
+        for (size_t i = 0; i < size; ++i) {
+            m_slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        m_mask = size - 1;
+    }
+
+    MpscRing(const MpscRing&) = delete;
+    MpscRing& operator=(const MpscRing&) = delete;
+
+    bool push(T&& item) {
+        size_t pos = m_tail.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;) {
+            slot = &m_slots[pos & m_mask];
+            size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                // 槽位空闲，抢占该位置；失败时 pos 更新为最新的尾部
+                if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;  // 消费者还没取走一圈前的数据
+            } else {
+                pos = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+        slot->value = std::move(item);
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 抢到位置但尚未写完的生产者会让 pop() 暂时返回 false，之后的数据等它写完再取出
+    bool pop(T& item) {
+        Slot& slot = m_slots[m_head & m_mask];
+        if (slot.sequence.load(std::memory_order_acquire) != m_head + 1) {
+            return false;
+        }
+        item = std::move(slot.value);
+        slot.sequence.store(m_head + m_mask + 1, std::memory_order_release);
+        ++m_head;
+        return true;
+    }
+
+    size_t capacity() const { return m_mask + 1; }
+
+private:
+    static constexpr size_t kCacheLine = 64;
+
+    struct Slot {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Slot[]> m_slots;
+    size_t m_mask;
+    alignas(kCacheLine) size_t m_head;
+    alignas(kCacheLine) std::atomic<size_t> m_tail;
+};
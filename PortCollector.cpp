@@ -0,0 +1,576 @@
+#include "PortCollector.h"
+#include "Reactor.h"
+#include "Logger.h"
+#include "Scheduling.h"
+#include "ByteClass.h"
+#include "Timestamp.h"
+#include "Record.h"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace {
+
+// 单次可读事件内最多读取的次数，避免一个繁忙串口占满 Reactor 线程
+constexpr int kMaxReadsPerEvent = 16;
+// 停止丢弃数据超过该时间后才记录恢复，避免在预算边界上反复记录
+constexpr auto kDropQuietTime = std::chrono::seconds(1);
+// memoryPolicy 为 block 时检查预算的间隔
+constexpr auto kBudgetPollInterval = std::chrono::milliseconds(1);
+
+const char* policyName(MemoryPolicy policy) {
+    switch (policy) {
+        case MemoryPolicy::DropOldest: return "dropOldest";
+        case MemoryPolicy::Block:      return "block";
+        case MemoryPolicy::Spill:      return "spill";
+        default:                       return "dropNewest";
+    }
+}
+
+// 分帧时每帧一个数据块，块容量即最大帧长
+size_t chunkSizeFor(const FramingConfig& framing) {
+    if (framing.mode == FramingMode::None) {
+        return ChunkPool::kDefaultChunkSize;
+    }
+    size_t size = static_cast<size_t>(std::max(framing.maxFrameSize, 1));
+    if (framing.mode == FramingMode::Fixed) {
+        size = std::max(size, static_cast<size_t>(std::max(framing.frameSize, 0)));
+    } else if (framing.mode == FramingMode::Length) {
+        size = std::max(size, static_cast<size_t>(std::max(framing.lengthOffset, 0) + 4));
+    }
+    return size;
+}
+
+} // namespace
+
+PortCollector::PortCollector(const PortConfig& config, DiskWriter& diskWriter, Uplinks& uplinks,
+                             MemoryBudget* memory)
+    : m_config(config), m_port(config),
+      m_pool(new ChunkPool(chunkSizeFor(config.framing), ChunkPool::kDefaultSlabChunks, memory)),
+      m_diskWriter(diskWriter), m_uplinks(uplinks), m_sequence(0), m_lastReadBytes(0),
+      m_idleGapUs(0.0), m_idleTimerFd(-1), m_framingErrorReported(false), m_binaryReported(false),
+      m_lastReadFailed(false), m_metrics(std::make_shared<PortMetrics>()), m_memory(memory),
+      m_memoryLimit(static_cast<size_t>(std::max(config.memoryBudgetKB, 0)) * 1024),
+      m_dropping(false), m_dropsBefore(0), m_running(false), m_reactor(nullptr) {
+    auto now = std::chrono::steady_clock::now();
+    if (config.framing.mode != FramingMode::None) {
+        m_assembler.reset(new FrameAssembler(config.framing, *m_pool));
+    }
+    if (config.framing.mode == FramingMode::IdleGap) {
+        // 默认按 Modbus RTU 的 3.5 个字符时间；高于 19200 波特时使用固定的 1750us
+        if (config.framing.idleGapUs > 0) {
+            m_idleGapUs = config.framing.idleGapUs;
+        } else if (config.baudRate > 19200) {
+            m_idleGapUs = 1750.0;
+        } else {
+            m_idleGapUs = m_port.wireTimeUs(7) / 2.0;
+        }
+    }
+    m_lastDataRead = now;
+    m_lastReadReturn = now;
+    m_lastDrop = now;
+}
+
+PortCollector::~PortCollector() {
+    stop();
+}
+
+bool PortCollector::open() {
+    if (!m_port.open()) {
+        LOG_ERROR(m_config.name, "Failed to open port");
+        return false;
+    }
+    if (m_config.memoryPolicy == MemoryPolicy::Spill &&
+        !(m_config.tcpForward.enabled && m_config.tcpForward.storeAndForward)) {
+        LOG_ERROR(m_config.name, "memoryPolicy \"spill\" needs tcpForward.storeAndForward, using dropNewest");
+    }
+
+    m_diskChannel = m_diskWriter.attach(m_config, m_metrics);
+
+    // 接入 TCP 转发连接，multiplex 的串口共用连接
+    if (m_config.tcpForward.enabled) {
+        m_tcpSource = m_uplinks.attach(m_config, m_metrics);
+        LOG_ERROR(m_config.name, "TCP forwarding enabled -> " +
+                  m_config.tcpForward.server + ":" +
+                  std::to_string(m_config.tcpForward.port));
+    }
+    return true;
+}
+
+bool PortCollector::start(ReactorPool* reactors) {
+    // 热加载时可能已经提前打开
+    if (!m_port.isOpen() && !open()) {
+        return false;
+    }
+
+    // 热加载时旧采集器已停止并关闭共享内存，新采集器接着写入同一个环
+    if (m_config.sharedMemory.enabled && !m_shm) {
+        const SharedMemoryConfig& shm = m_config.sharedMemory;
+        size_t minimum = 8 * shmRecordSize(static_cast<uint32_t>(m_pool->chunkSize()));
+        m_shm.reset(new ShmPublisher());
+        if (!m_shm->open(shm.name.empty() ? ShmPublisher::defaultName(m_config.name) : shm.name,
+                         std::max(static_cast<size_t>(std::max(shm.sizeKB, 0)) * 1024, minimum), m_config.name)) {
+            m_shm.reset();
+        }
+    }
+
+    m_running = true;
+    m_lastReadReturn = std::chrono::steady_clock::now();
+
+    ReadMode mode = m_config.readMode;
+    if (mode == ReadMode::Event && m_config.memoryPolicy == MemoryPolicy::Block) {
+        mode = ReadMode::Poll;  // 等待预算时不能占用其他串口共用的 Reactor 线程
+    }
+    const SchedulingConfig& scheduling = m_config.scheduling;
+    if (mode == ReadMode::Event && (!scheduling.cpus.empty() || scheduling.priority > 0)) {
+        mode = ReadMode::Poll;  // 独立的读取线程，绑定和优先级不影响其他串口
+    }
+#ifndef _WIN32
+    if (mode == ReadMode::Event && reactors) {
+        Reactor& reactor = reactors->next();
+        if (reactor.add(m_port.getFd(), [this](uint32_t events) { return onReadable(events); })) {
+            m_reactor = &reactor;
+            // 静默定时器与串口在同一个 Reactor 线程上处理，不需要加锁
+            if (m_idleGapUs > 0.0) {
+                m_idleTimerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+                if (m_idleTimerFd < 0 || !reactor.add(m_idleTimerFd, [this](uint32_t) {
+                        uint64_t expirations;
+                        while (::read(m_idleTimerFd, &expirations, sizeof(expirations)) > 0) {}
+                        checkIdle();
+                        return true;
+                    })) {
+                    LOG_ERROR(m_config.name, "Failed to create idle gap timer");
+                }
+            }
+            return true;
+        }
+    }
+#else
+    (void)reactors;
+    if (mode == ReadMode::Poll) {
+        mode = ReadMode::Legacy;  // Windows 串口句柄不支持 poll()
+    }
+#endif
+
+    switch (mode) {
+        case ReadMode::Blocking:
+            m_readThread = std::thread(&PortCollector::runBlocking, this);
+            break;
+        case ReadMode::Poll:
+            m_readThread = std::thread(&PortCollector::runPoll, this);
+            break;
+        default:
+            // Event 模式无法注册时也退回旧版轮询
+            m_readThread = std::thread(&PortCollector::runLegacy, this);
+            break;
+    }
+    return true;
+}
+
+void PortCollector::stop() {
+    m_running = false;
+#ifndef _WIN32
+    if (m_reactor) {
+        m_reactor->remove(m_port.getFd());
+        if (m_idleTimerFd >= 0) {
+            m_reactor->remove(m_idleTimerFd);
+        }
+        m_reactor = nullptr;
+    }
+    if (m_idleTimerFd >= 0) {
+        ::close(m_idleTimerFd);
+        m_idleTimerFd = -1;
+    }
+#endif
+    if (m_readThread.joinable()) {
+        m_port.interruptRead();
+        m_readThread.join();
+    }
+    // 未结束的帧照常保存
+    if (m_assembler) {
+        m_assembler->flush(m_frames);
+        auto time = WallClock::fromSteady(m_lastDataRead);
+        for (auto& frame : m_frames) {
+            dispatch(std::move(frame), time);
+        }
+        m_frames.clear();
+    }
+    if (m_dropping) {
+        m_dropping = false;
+        LOG_ERROR(m_config.name, "Stopped dropping data, " + std::to_string(drops() - m_dropsBefore) +
+                  " chunks dropped");
+    }
+    m_shm.reset();
+    if (m_diskChannel) {
+        m_diskWriter.detach(m_diskChannel);
+        m_diskChannel.reset();
+    }
+    if (m_tcpSource) {
+        m_uplinks.detach(m_tcpSource);
+        m_tcpSource.reset();
+    }
+    m_chunk.reset();
+    m_port.close();
+}
+
+QueueStats PortCollector::tcpQueueStats() const {
+    if (!m_tcpSource) {
+        return { 0, 0, 0, 0 };
+    }
+    return TcpClient::queueStats(*m_tcpSource);
+}
+
+const CompressionStats* PortCollector::compressionStats() const {
+    return m_diskChannel ? m_diskChannel->compression.get() : nullptr;
+}
+
+uint64_t PortCollector::tcpConnects() const {
+    return m_tcpSource ? m_tcpSource->client.connects() : 0;
+}
+
+uint64_t PortCollector::spooledBytes() const {
+    return m_tcpSource ? m_tcpSource->client.spooledBytes() : 0;
+}
+
+uint64_t PortCollector::drops() const {
+    return diskQueueStats().drops + tcpQueueStats().drops + m_metrics->budgetDrops.load();
+}
+
+QueueStats PortCollector::diskQueueStats() const {
+    if (!m_diskChannel) {
+        return { 0, 0, 0, 0 };
+    }
+    return { m_diskChannel->queue.size(), m_diskChannel->queue.highWater(),
+             m_diskChannel->queue.capacity(),
+             m_diskChannel->drops.load(std::memory_order_relaxed) };
+}
+
+bool PortCollector::readChunk(double& sinceLastReadUs) {
+    size_t bytesRead = 0;
+    bool result;
+    if (m_assembler) {
+        // 接在未完成的帧之后读入
+        size_t capacity;
+        char* buffer = m_assembler->readBuffer(capacity);
+        result = m_port.read(buffer, capacity, bytesRead);
+    } else {
+        // 上次没有读到数据时复用同一个数据块
+        if (!m_chunk) {
+            m_chunk = m_pool->acquire();
+        }
+        result = m_port.read(m_chunk.data(), m_chunk.capacity(), bytesRead);
+        m_chunk.setSize(bytesRead);
+    }
+    m_lastReadBytes = bytesRead;
+    auto now = std::chrono::steady_clock::now();
+    sinceLastReadUs = std::chrono::duration<double, std::micro>(now - m_lastReadReturn).count();
+    m_lastReadReturn = now;
+    return result;
+}
+
+void PortCollector::reportReadError() {
+    m_metrics->readErrors.add();
+    if (!m_lastReadFailed) {
+        LOG_ERROR(m_config.name, "Read failed - Further errors will be suppressed");
+        m_lastReadFailed = true;
+    }
+}
+
+bool PortCollector::onReadable(uint32_t events) {
+    for (int i = 0; i < kMaxReadsPerEvent; ++i) {
+        double sinceUs;
+        if (!readChunk(sinceUs)) {
+            reportReadError();
+            return false;
+        }
+        if (m_lastReadBytes == 0) {
+            break;
+        }
+        // 事件驱动：数据到达即被唤醒，延迟约为本块的线路传输时间
+        handleChunk(std::min(m_port.wireTimeUs(m_lastReadBytes), sinceUs));
+    }
+    armIdleTimer();
+
+#ifndef _WIN32
+    // 设备被拔出时 epoll 会持续报告 HUP/ERR，此时停止监听
+    if (m_lastReadBytes == 0 && (events & (EPOLLHUP | EPOLLERR))) {
+        LOG_ERROR(m_config.name, "Port hung up, stop collecting");
+        return false;
+    }
+#else
+    (void)events;
+#endif
+    return true;
+}
+
+void PortCollector::setupReadThread() {
+    // 没有配置时恢复进程初始的 CPU 集合，不继承 bulkScheduling 的绑定
+    applyScheduling(m_config.scheduling, m_config.name);
+    prefaultStack();
+}
+
+void PortCollector::runBlocking() {
+    setupReadThread();
+    // 不足 VMIN 字节时驱动会在最后一个字节后再等待 VTIME
+    double vtimeUs = m_config.vtime * 100000.0;
+    while (m_running) {
+        double sinceUs;
+        if (!readChunk(sinceUs)) {
+            reportReadError();
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+            continue;
+        }
+        if (m_lastReadBytes == 0) {
+            // VTIME 超时返回，线路已静默
+            checkIdle();
+            continue;
+        }
+        double holdUs = m_lastReadBytes < static_cast<size_t>(m_config.vmin) ? vtimeUs : 0.0;
+        handleChunk(std::min(m_port.wireTimeUs(m_lastReadBytes) + holdUs, sinceUs));
+    }
+}
+
+void PortCollector::runPoll() {
+#ifndef _WIN32
+    setupReadThread();
+    pollfd pfd = {};
+    pfd.fd = m_port.getFd();
+    pfd.events = POLLIN;
+    while (m_running) {
+        // 有未结束的帧时按静默时间醒来
+        int timeout = m_config.pollTimeout;
+        if (m_assembler && m_assembler->pending() > 0 && m_idleGapUs > 0.0) {
+            timeout = static_cast<int>(std::ceil(m_idleGapUs / 1000.0));
+        }
+        int ready = ::poll(&pfd, 1, timeout);
+        if (ready < 0 && errno != EINTR) {
+            reportReadError();
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+            continue;
+        }
+        if (ready > 0 && !onReadable(static_cast<uint32_t>(pfd.revents))) {
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+        }
+        checkIdle();
+    }
+#endif
+}
+
+void PortCollector::runLegacy() {
+    setupReadThread();
+    while (m_running) {
+        double sinceUs;
+        bool readResult = readChunk(sinceUs);
+        checkIdle();
+        if (readResult && m_lastReadBytes > 0) {
+            // 数据可能在上次读取后的任意时刻到达，按最坏情况计算
+            handleChunk(sinceUs);
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        } else {
+            if (!readResult) {
+                reportReadError();
+            }
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+        }
+    }
+}
+
+void PortCollector::handleChunk(double latencyUs) {
+    size_t size = m_lastReadBytes;
+    // 文本格式丢弃只有空白的数据块；二进制记录原样保存，其中的空白字节也是数据
+    if (!m_assembler && !acceptText(m_chunk.data(), size)) {
+        return;  // 数据块留给下一次读取复用
+    }
+
+    // 统计只做原子加，状态显示和统计接口在其他线程读取
+    auto arrival = std::chrono::steady_clock::now();
+    m_metrics->bytesRead.add(size);
+    m_metrics->chunksRead.add();
+    m_metrics->lastDataNs.store(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        arrival.time_since_epoch()).count(), std::memory_order_relaxed);
+    m_metrics->readLatency.record(static_cast<uint64_t>(latencyUs * 1000.0));
+
+    // 时间戳取读取返回的时刻
+    auto now = WallClock::fromSteady(m_lastReadReturn);
+    if (m_assembler) {
+        // 本次读到的字节在线路上开始之前已经静默了足够久，前面未结束的帧到此为止
+        double silentUs = std::chrono::duration<double, std::micro>(arrival - m_lastDataRead).count() -
+                          m_port.wireTimeUs(size);
+        bool gapBefore = m_idleGapUs > 0.0 && silentUs >= m_idleGapUs;
+        m_lastDataRead = arrival;
+
+        m_assembler->commit(size, gapBefore, m_frames);
+        for (auto& frame : m_frames) {
+            if (!acceptText(frame.data(), frame.size())) {
+                continue;
+            }
+            dispatch(std::move(frame), now);
+        }
+        m_frames.clear();
+
+        // 只有采集线程更新这个计数器，按差值补齐即可
+        uint64_t framingErrors = m_assembler->framer().errors();
+        if (framingErrors > m_metrics->framingErrors.load()) {
+            m_metrics->framingErrors.add(framingErrors - m_metrics->framingErrors.load());
+        }
+        if (!m_framingErrorReported && framingErrors > 0) {
+            LOG_ERROR(m_config.name, "Invalid frame length, resynchronizing - Further errors will be suppressed");
+            m_framingErrorReported = true;
+        }
+    } else {
+        dispatch(std::move(m_chunk), now);
+    }
+}
+
+bool PortCollector::acceptText(const char* data, size_t size) {
+    if (m_config.fileFormat != FileFormat::Text) {
+        return true;
+    }
+    ByteClass bytes = classifyBytes(data, size);
+    if (!bytes.printable && !m_binaryReported) {
+        LOG_ERROR(m_config.name, "Binary data on a text format port, consider fileFormat \"record\"");
+        m_binaryReported = true;
+    }
+    return !bytes.allWhitespace;
+}
+
+void PortCollector::dispatch(ChunkRef&& chunk, std::chrono::system_clock::time_point time) {
+    chunk.setTime(time);
+    chunk.setSequence(m_sequence++);
+
+    // 共享内存在读取线程中直接写入，不受队列和内存预算影响
+    if (m_shm) {
+        m_shm->publish(chunk.data(), chunk.size(), time,
+                       chunk.size() == chunk.capacity() ? RecordFlag::Full : 0);
+    }
+
+    // 超出预算时按 memoryPolicy 决定本块交给哪些阶段
+    bool toTcp = m_tcpSource != nullptr;
+    bool toDisk = m_diskChannel != nullptr;
+    uint64_t dropped = 0;
+    std::string reason;
+    if (overBudget() && applyBudget(toTcp, toDisk)) {
+        ++dropped;
+        reason = std::string("memory budget exceeded (memoryPolicy ") + policyName(m_config.memoryPolicy) + ")";
+    }
+
+    // TCP 转发：与写盘共享同一个数据块
+    if (toTcp && !m_tcpSource->client.send(*m_tcpSource, chunk)) {
+        ++dropped;
+        reason = "TCP queue full";
+    }
+
+    // 交给写盘线程，队列满时丢弃，读取线程不等待磁盘
+    if (toDisk && !m_diskWriter.submit(*m_diskChannel, std::move(chunk))) {
+        ++dropped;
+        reason = "disk queue full";
+    }
+    chunk.reset();
+    reportDrops(dropped, reason);
+}
+
+bool PortCollector::overBudget() const {
+    return (m_memoryLimit > 0 && m_pool->outstandingBytes() > m_memoryLimit) ||
+           (m_memory && m_memory->exceeded());
+}
+
+bool PortCollector::hasBacklog() const {
+    return (m_tcpSource && !m_tcpSource->queue.empty()) || (m_diskChannel && !m_diskChannel->queue.empty());
+}
+
+bool PortCollector::applyBudget(bool& toTcp, bool& toDisk) {
+    // 内存由积压的队列占用：只处理积压最多的阶段，另一个阶段照常接收。
+    // 两个队列都空时内存在发送窗口等自有上限的地方，或者是其他串口超出了全局预算，不处理
+    if (!hasBacklog()) {
+        return false;
+    }
+
+    if (m_config.memoryPolicy == MemoryPolicy::Block) {
+        // 不读串口，数据留在驱动和 UART 中；停止时不再等待
+        auto begin = std::chrono::steady_clock::now();
+        while (m_running && overBudget() && hasBacklog()) {
+            std::this_thread::sleep_for(kBudgetPollInterval);
+        }
+        m_metrics->budgetBlockedUs.add(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin).count()));
+        return false;
+    }
+
+    size_t tcpDepth = toTcp ? m_tcpSource->queue.size() : 0;
+    size_t diskDepth = toDisk ? m_diskChannel->queue.size() : 0;
+    bool tcp = toTcp && tcpDepth >= diskDepth;
+    std::atomic<uint64_t>& shed = tcp ? m_tcpSource->shed : m_diskChannel->shed;
+    if (m_config.memoryPolicy == MemoryPolicy::DropOldest && shed.load(std::memory_order_relaxed) == 0) {
+        // 消费者取下一个数据块时丢弃最旧的一个；上一个请求还没处理（消费者停滞）时丢弃本块，内存不再增长
+        shed.fetch_add(1, std::memory_order_relaxed);
+        m_metrics->budgetDrops.add();
+        return true;
+    }
+    if (m_config.memoryPolicy == MemoryPolicy::Spill && tcp && m_tcpSource->client.canSpill() &&
+        m_tcpSource->client.requestSpill()) {
+        return false;  // 发送线程停滞、上一次请求还没处理时同样丢弃本块
+    }
+    (tcp ? toTcp : toDisk) = false;
+    m_metrics->budgetDrops.add();
+    return true;
+}
+
+void PortCollector::reportDrops(uint64_t dropped, const std::string& reason) {
+    // 开始丢弃时记录一次原因，持续一段时间没有丢弃后记录期间丢弃的数据块数
+    // （在之后的读取或读取线程的超时检查中，事件模式下没有数据时在停止时记录）
+    auto now = std::chrono::steady_clock::now();
+    if (dropped > 0) {
+        m_lastDrop = now;
+        if (!m_dropping) {
+            m_dropping = true;
+            m_dropsBefore = drops() - dropped;
+            LOG_ERROR(m_config.name, "Dropping data: " + reason);
+        }
+    } else if (m_dropping && now - m_lastDrop >= kDropQuietTime) {
+        m_dropping = false;
+        LOG_ERROR(m_config.name, "Stopped dropping data, " + std::to_string(drops() - m_dropsBefore) +
+                  " chunks dropped");
+    }
+}
+
+void PortCollector::checkIdle() {
+    reportDrops(0, std::string());
+    if (m_idleGapUs <= 0.0 || !m_assembler || m_assembler->pending() == 0) {
+        return;
+    }
+    double silentUs = std::chrono::duration<double, std::micro>(
+        std::chrono::steady_clock::now() - m_lastDataRead).count();
+    if (silentUs < m_idleGapUs) {
+        armIdleTimer();
+        return;
+    }
+    m_assembler->flush(m_frames);
+    auto time = WallClock::fromSteady(m_lastDataRead);
+    for (auto& frame : m_frames) {
+        dispatch(std::move(frame), time);
+    }
+    m_frames.clear();
+}
+
+void PortCollector::armIdleTimer() {
+#ifndef _WIN32
+    if (m_idleTimerFd < 0 || m_assembler->pending() == 0) {
+        return;
+    }
+    double remainingUs = m_idleGapUs - std::chrono::duration<double, std::micro>(
+        std::chrono::steady_clock::now() - m_lastDataRead).count();
+    auto ns = static_cast<long long>(std::max(remainingUs, 1.0) * 1000.0);
+    itimerspec spec = {};
+    spec.it_value.tv_sec = static_cast<time_t>(ns / 1000000000LL);
+    spec.it_value.tv_nsec = static_cast<long>(ns % 1000000000LL);
+    timerfd_settime(m_idleTimerFd, 0, &spec, nullptr);
+#endif
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include "SerialPort.h"
+#include "TcpClient.h"
+#include "DiskWriter.h"
+#include "Uplinks.h"
+#include "Framer.h"
+#include "Metrics.h"
+#include "MemoryBudget.h"
+#include "ShmPublisher.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+class Reactor;
+class ReactorPool;
+
+// 单个串口的采集器（读取阶段）：读取串口后把数据块分发到写盘和 TCP 转发队列
+class PortCollector {
+public:
+    PortCollector(const PortConfig& config, DiskWriter& diskWriter, Uplinks& uplinks,
+                  MemoryBudget* memory = nullptr);
+    ~PortCollector();
+
+    // 打开串口并接入写盘和 TCP 通道；热加载时在旧采集器停止前调用，缩短串口关闭的时间
+    bool open();
+    // 按 readMode 启动读取，未打开时先打开；Event 模式注册到 reactors
+    bool start(ReactorPool* reactors);
+    void stop();
+    bool isRunning() const { return m_running; }
+    size_t pendingInput() const { return m_port.pendingInput(); }  // 驱动中尚未读取的字节数
+
+    const PortConfig& getConfig() const { return m_config; }
+    const PortMetrics& metrics() const { return *m_metrics; }
+    QueueStats diskQueueStats() const;
+    QueueStats tcpQueueStats() const;
+    uint64_t spooledBytes() const;
+    uint64_t tcpConnects() const;  // 所在 TCP 连接的连接成功次数
+    const CompressionStats* compressionStats() const;  // 未启用压缩时为空
+    uint64_t allocations() const { return m_pool->allocations(); }
+    size_t memoryBytes() const { return m_pool->outstandingBytes(); }  // 本串口数据块占用的内存
+    uint64_t drops() const;  // 队列满和超出内存预算丢弃的数据块总数
+
+private:
+    bool onReadable(uint32_t events);
+    void setupReadThread();  // 读取线程开始时设置串口的 scheduling
+    void runBlocking();
+    void runPoll();
+    void runLegacy();
+    bool readChunk(double& sinceLastReadUs);
+    void reportReadError();
+    void handleChunk(double latencyUs);
+    // 文本格式下只有空白的数据不保存；首次收到二进制数据时记录一次日志
+    bool acceptText(const char* data, size_t size);
+    void dispatch(ChunkRef&& chunk, std::chrono::system_clock::time_point time);
+    bool overBudget() const;
+    bool hasBacklog() const;
+    bool applyBudget(bool& toTcp, bool& toDisk);
+    void reportDrops(uint64_t dropped, const std::string& reason);
+    void checkIdle();
+    void armIdleTimer();
+
+    PortConfig m_config;
+    SerialPort m_port;
+    // 下游持有的数据块可能比采集器活得更久，池在最后一个数据块归还后才释放
+    std::unique_ptr<ChunkPool, ChunkPool::Retire> m_pool;
+    DiskWriter& m_diskWriter;
+    std::shared_ptr<DiskWriter::Channel> m_diskChannel;
+    Uplinks& m_uplinks;
+    std::shared_ptr<TcpClient::Source> m_tcpSource;
+    std::unique_ptr<ShmPublisher> m_shm;  // sharedMemory 启用时在 start() 中打开，读取线程直接发布
+    uint64_t m_sequence;  // 下一个数据块的序号
+    ChunkRef m_chunk;  // 正在读入的数据块，读到数据后交给下游阶段
+    size_t m_lastReadBytes;
+    // 启用分帧时读入 m_assembler 的缓冲区，切出的帧逐个交给下游
+    std::unique_ptr<FrameAssembler> m_assembler;
+    std::vector<ChunkRef> m_frames;
+    double m_idleGapUs;  // IdleGap：线路静默超过该时间即结束一帧
+    std::chrono::steady_clock::time_point m_lastDataRead;
+    int m_idleTimerFd;   // Event 模式下的静默定时器
+    bool m_framingErrorReported;
+    bool m_binaryReported;
+    bool m_lastReadFailed;
+    // 写盘和 TCP 通道也持有，串口停止后仍在发送的数据继续计入
+    std::shared_ptr<PortMetrics> m_metrics;
+    MemoryBudget* m_memory;  // 全局预算，可以为空
+    size_t m_memoryLimit;    // 本串口的预算，0 为不限
+    bool m_dropping;         // 正在丢弃数据，恢复后记录一次日志
+    uint64_t m_dropsBefore;  // 开始丢弃时的丢弃总数
+    std::chrono::steady_clock::time_point m_lastDrop;
+
+    std::atomic<bool> m_running;
+    std::thread m_readThread;
+    Reactor* m_reactor;
+    std::chrono::steady_clock::time_point m_lastReadReturn;
+};
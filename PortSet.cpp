@@ -0,0 +1,171 @@
+#include "PortSet.h"
+#include "Logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double elapsedMs(Clock::time_point from, Clock::time_point to) {
+    return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+std::string formatMs(double ms) {
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.1f ms", ms);
+    return text;
+}
+
+// 起始位 + 数据位 + 校验位 + 停止位
+double charTimeUs(const PortConfig& config) {
+    int bits = 1 + config.dataBits + (config.parity == "none" ? 0 : 1) + config.stopBits;
+    return config.baudRate > 0 ? bits * 1e6 / config.baudRate : 0.0;
+}
+
+// 超时时间内收到过数据的串口视为正在发送
+bool receiving(const PortCollector& collector) {
+    int64_t lastDataNs = collector.metrics().lastDataNs.load(std::memory_order_relaxed);
+    return lastDataNs != 0 &&
+           Clock::now().time_since_epoch() - std::chrono::nanoseconds(lastDataNs) <
+               std::chrono::seconds(collector.getConfig().timeout);
+}
+
+// 非 multiplex 的连接不发送串口编号，portId 随串口在配置中的序号变化时不需要重建
+TcpConfig effectiveTcp(const TcpConfig& tcp) {
+    TcpConfig effective = tcp;
+    if (!tcp.enabled) {
+        effective = TcpConfig{};
+    } else if (!tcp.multiplex) {
+        effective.portId = 0;
+    }
+    return effective;
+}
+
+bool sameSettings(const PortConfig& a, const PortConfig& b) {
+    PortConfig normalized = b;
+    normalized.tcpForward = effectiveTcp(b.tcpForward);
+    PortConfig current = a;
+    current.tcpForward = effectiveTcp(a.tcpForward);
+    return current == normalized;
+}
+
+} // namespace
+
+PortSet::PortSet(DiskWriter& diskWriter, Uplinks& uplinks, ReactorPool* reactors, MemoryBudget* memory)
+    : m_diskWriter(diskWriter), m_uplinks(uplinks), m_reactors(reactors), m_memory(memory), m_started(false),
+      m_stats{ 0, 0, 0 } {
+}
+
+PortSet::~PortSet() {
+    stopAll();
+}
+
+void PortSet::apply(const std::vector<PortConfig>& configs) {
+    auto begin = Clock::now();
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    size_t added = 0, reconfigured = 0, unchanged = 0;
+    std::vector<std::unique_ptr<PortCollector>> next;
+    for (const auto& config : configs) {
+        auto it = std::find_if(m_collectors.begin(), m_collectors.end(),
+                               [&](const std::unique_ptr<PortCollector>& collector) {
+                                   return collector && collector->getConfig().name == config.name;
+                               });
+        if (it == m_collectors.end()) {
+            auto collector = std::make_unique<PortCollector>(config, m_diskWriter, m_uplinks, m_memory);
+            collector->start(m_reactors);
+            if (m_started) {
+                LOG_ERROR(config.name, "Port added by config reload");
+            }
+            next.push_back(std::move(collector));
+            ++added;
+        } else if (sameSettings((*it)->getConfig(), config) && (*it)->isRunning()) {
+            next.push_back(std::move(*it));
+            ++unchanged;
+        } else {
+            // 打开失败的串口即使配置未变也重试一次
+            next.push_back(reconfigure(std::move(*it), config));
+            ++reconfigured;
+        }
+    }
+
+    size_t removed = 0;
+    for (auto& collector : m_collectors) {
+        if (collector) {
+            collector->stop();
+            LOG_ERROR(collector->getConfig().name, "Port removed by config reload");
+            ++removed;
+        }
+    }
+    m_collectors = std::move(next);
+
+    if (!m_started) {
+        m_started = true;
+        return;
+    }
+    double ms = elapsedMs(begin, Clock::now());
+    ++m_stats.reloads;
+    m_stats.lastDurationUs = static_cast<uint64_t>(ms * 1000.0);
+    LOG_ERROR("Config", "Reloaded in " + formatMs(ms) + ": " + std::to_string(added) + " added, " +
+              std::to_string(removed) + " removed, " + std::to_string(reconfigured) +
+              " reconfigured, " + std::to_string(unchanged) + " unchanged");
+}
+
+std::unique_ptr<PortCollector> PortSet::reconfigure(std::unique_ptr<PortCollector> old,
+                                                    const PortConfig& config) {
+    auto collector = std::make_unique<PortCollector>(config, m_diskWriter, m_uplinks, m_memory);
+    bool wasRunning = old->isRunning();
+    bool wasReceiving = wasRunning && receiving(*old);
+
+    // 新采集器先打开串口再停止旧的，串口始终有一个打开的句柄，切换期间到达的数据留在驱动缓冲区中。
+    // 非 multiplex 的 TCP 连接按串口名共用，TCP 参数变化时旧连接须先关闭，只能先停后开；
+    // Windows 串口只能独占打开，同样先停后开
+    bool overlap = wasRunning &&
+                   effectiveTcp(config.tcpForward) == effectiveTcp(old->getConfig().tcpForward);
+#ifdef _WIN32
+    overlap = false;
+#endif
+    auto begin = Clock::now();
+    bool opened = overlap && collector->open();
+    old->stop();
+    auto closed = Clock::now();
+    old.reset();
+
+    size_t buffered = opened ? collector->pendingInput() : 0;
+    bool started = collector->start(m_reactors);
+    auto end = Clock::now();
+
+    std::string message = "Reconfigured in " + formatMs(elapsedMs(begin, end));
+    if (!started) {
+        message += ", failed to reopen";
+    } else if (opened) {
+        message += ", " + std::to_string(buffered) + " bytes buffered by the driver";
+    } else if (wasRunning) {
+        // 串口关闭期间线路上的数据无法保存，按波特率满速估计上限
+        double closedMs = elapsedMs(closed, end);
+        uint64_t lost = 0;
+        if (wasReceiving && charTimeUs(config) > 0.0) {
+            lost = static_cast<uint64_t>(closedMs * 1000.0 / charTimeUs(config));
+        }
+        m_stats.lostBytes += lost;
+        message += ", port closed for " + formatMs(closedMs) + ", up to " +
+                   std::to_string(lost) + " bytes lost";
+    }
+    LOG_ERROR(config.name, message);
+    return collector;
+}
+
+void PortSet::stopAll() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& collector : m_collectors) {
+        collector->stop();
+    }
+    m_collectors.clear();
+}
+
+PortSet::ReloadStats PortSet::reloadStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include "PortCollector.h"
+#include "MemoryBudget.h"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class ReactorPool;
+
+// 运行中的串口集合。配置热加载时按串口名与新配置比较：只启动新增的、停止删除的、
+// 重建参数有变化的串口，其余串口的缓冲、数据文件和 TCP 连接保持不动
+class PortSet {
+public:
+    struct ReloadStats {
+        uint64_t reloads;         // 已应用的配置次数，不含启动时的第一次
+        uint64_t lastDurationUs;  // 最近一次应用的耗时
+        uint64_t lostBytes;       // 切换期间串口关闭导致丢失字节数的估计（上限）
+    };
+
+    // memory 为所有串口共用的数据块内存预算，可以为空
+    PortSet(DiskWriter& diskWriter, Uplinks& uplinks, ReactorPool* reactors, MemoryBudget* memory);
+    ~PortSet();
+
+    PortSet(const PortSet&) = delete;
+    PortSet& operator=(const PortSet&) = delete;
+
+    // 启动时和每次配置变化时调用，顺序与配置中的串口顺序一致
+    void apply(const std::vector<PortConfig>& configs);
+    void stopAll();
+
+    // 遍历 collectors() 期间需持有该锁，热加载会替换其中的采集器
+    std::unique_lock<std::mutex> lock() const { return std::unique_lock<std::mutex>(m_mutex); }
+    const std::vector<std::unique_ptr<PortCollector>>& collectors() const { return m_collectors; }
+    ReloadStats reloadStats() const;
+    const MemoryBudget* memory() const { return m_memory; }
+
+private:
+    std::unique_ptr<PortCollector> reconfigure(std::unique_ptr<PortCollector> old,
+                                               const PortConfig& config);
+
+    DiskWriter& m_diskWriter;
+    Uplinks& m_uplinks;
+    ReactorPool* m_reactors;
+    MemoryBudget* m_memory;
+    mutable std::mutex m_mutex;
+    std::vector<std::unique_ptr<PortCollector>> m_collectors;
+    bool m_started;
+    ReloadStats m_stats;
+};
@@ -0,0 +1,194 @@
+#include "Reactor.h"
+#include "Logger.h"
+#include "Scheduling.h"
+#include <algorithm>
+
+#ifndef _WIN32
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+Reactor::Reactor(const SchedulingConfig& scheduling)
+    : m_scheduling(scheduling), m_epollFd(-1), m_wakeFd(-1), m_running(false), m_dispatchingFd(-1) {}
+
+Reactor::~Reactor() {
+    stop();
+}
+
+#ifndef _WIN32
+
+bool Reactor::start() {
+    m_epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (m_epollFd < 0) {
+        LOG_ERROR("Reactor", "epoll_create1 failed: " + std::string(strerror(errno)));
+        return false;
+    }
+
+    m_wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_wakeFd < 0) {
+        ::close(m_epollFd);
+        m_epollFd = -1;
+        return false;
+    }
+
+    epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.fd = m_wakeFd;
+    epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_wakeFd, &ev);
+
+    m_running = true;
+    m_thread = std::thread(&Reactor::loop, this);
+    return true;
+}
+
+void Reactor::stop() {
+    if (!m_running.exchange(false)) {
+        return;
+    }
+
+    uint64_t one = 1;
+    ssize_t ignored = ::write(m_wakeFd, &one, sizeof(one));
+    (void)ignored;
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+
+    ::close(m_wakeFd);
+    ::close(m_epollFd);
+    m_wakeFd = -1;
+    m_epollFd = -1;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_handlers.clear();
+}
+
+bool Reactor::add(int fd, Handler handler) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_handlers[fd] = std::make_shared<Handler>(std::move(handler));
+    }
+
+    epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    if (epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        LOG_ERROR("Reactor", "epoll_ctl add failed: " + std::string(strerror(errno)));
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_handlers.erase(fd);
+        return false;
+    }
+    return true;
+}
+
+void Reactor::remove(int fd) {
+    epoll_ctl(m_epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_handlers.erase(fd);
+
+    // 其他线程移除时等待正在执行的回调结束，之后调用方即可安全释放资源
+    if (std::this_thread::get_id() != m_thread.get_id()) {
+        m_dispatchCV.wait(lock, [this, fd] { return m_dispatchingFd != fd; });
+    }
+}
+
+size_t Reactor::size() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_handlers.size();
+}
+
+void Reactor::loop() {
+    constexpr int kMaxEvents = 64;
+    epoll_event events[kMaxEvents];
+    applyScheduling(m_scheduling, "Reactor");
+    prefaultStack();
+
+    while (m_running) {
+        int count = epoll_wait(m_epollFd, events, kMaxEvents, -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG_ERROR("Reactor", "epoll_wait failed: " + std::string(strerror(errno)));
+            break;
+        }
+
+        for (int i = 0; i < count; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == m_wakeFd) {
+                continue;
+            }
+
+            std::shared_ptr<Handler> handler;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                auto it = m_handlers.find(fd);
+                if (it == m_handlers.end()) {
+                    continue;
+                }
+                handler = it->second;
+                m_dispatchingFd = fd;
+            }
+
+            bool keep = (*handler)(events[i].events);
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_dispatchingFd = -1;
+            }
+            m_dispatchCV.notify_all();
+
+            if (!keep) {
+                remove(fd);
+            }
+        }
+    }
+}
+
+#else
+
+// Windows 没有 epoll，start() 失败后调用方退回每串口一个线程的模式
+bool Reactor::start() { return false; }
+void Reactor::stop() { m_running = false; }
+bool Reactor::add(int, Handler) { return false; }
+void Reactor::remove(int) {}
+size_t Reactor::size() const { return 0; }
+void Reactor::loop() {}
+
+#endif
+
+ReactorPool::ReactorPool(size_t threads, const SchedulingConfig& scheduling) {
+    threads = std::max<size_t>(threads, 1);
+    for (size_t i = 0; i < threads; ++i) {
+        m_reactors.push_back(std::make_unique<Reactor>(scheduling));
+    }
+}
+
+ReactorPool::~ReactorPool() {
+    stop();
+}
+
+bool ReactorPool::start() {
+    for (auto& reactor : m_reactors) {
+        if (!reactor->start()) {
+            stop();
+            return false;
+        }
+    }
+    return true;
+}
+
+void ReactorPool::stop() {
+    for (auto& reactor : m_reactors) {
+        reactor->stop();
+    }
+}
+
+Reactor& ReactorPool::next() {
+    auto it = std::min_element(m_reactors.begin(), m_reactors.end(),
+        [](const std::unique_ptr<Reactor>& a, const std::unique_ptr<Reactor>& b) {
+            return a->size() < b->size();
+        });
+    return **it;
+}
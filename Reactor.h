@@ -0,0 +1,54 @@
+#pragma once
+#include "Common.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// 基于 epoll 的事件循环，一个线程负责监听多个串口描述符
+class Reactor {
+public:
+    // 返回 false 表示该描述符不再需要监听，Reactor 会将其移除
+    using Handler = std::function<bool(uint32_t events)>;
+
+    explicit Reactor(const SchedulingConfig& scheduling = SchedulingConfig());
+    ~Reactor();
+
+    bool start();
+    void stop();
+    bool add(int fd, Handler handler);
+    void remove(int fd);  // 返回后保证该描述符的回调不再执行
+    size_t size() const;
+
+private:
+    void loop();
+
+    SchedulingConfig m_scheduling;  // loop() 开始时设置到 Reactor 线程
+    int m_epollFd;
+    int m_wakeFd;
+    std::atomic<bool> m_running;
+    std::thread m_thread;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_dispatchCV;
+    int m_dispatchingFd;
+    std::unordered_map<int, std::shared_ptr<Handler>> m_handlers;
+};
+
+// 固定数量的 Reactor，线程数不随串口数量增长
+class ReactorPool {
+public:
+    ReactorPool(size_t threads, const SchedulingConfig& scheduling);
+    ~ReactorPool();
+
+    bool start();
+    void stop();
+    Reactor& next();  // 返回当前负载最小的 Reactor
+
+private:
+    std::vector<std::unique_ptr<Reactor>> m_reactors;
+};
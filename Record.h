@@ -0,0 +1,94 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// 二进制记录文件 data/<串口>/YYYYMMDD.rec，所有字段为小端：
+//   偏移  类型     字段
+//    0    char[8]  magic      "SPCREC\r\n"
+//    8    uint32   version    1
+//   12    uint32   reserved
+//   16             记录...
+// 每条记录对应读取到的一个数据块，原样保存，不做任何文本处理：
+//    0    uint32   length     负载字节数
+//    4    uint16   flags      RecordFlag 的组合
+//    6    uint16   reserved
+//    8    uint64   timestamp  读取时刻，Unix 纪元起的纳秒数
+//   16             负载
+//
+// 稀疏索引 YYYYMMDD.idx 与数据文件一同增长，文件头格式相同（magic "SPCIDX\r\n"），
+// 之后每 kRecordIndexInterval 字节数据记一个条目：uint64 timestamp + uint64 记录偏移。
+// 条目只在对应数据落盘后写入，因此总是指向已写出的记录边界
+constexpr char kRecordMagic[8] = { 'S', 'P', 'C', 'R', 'E', 'C', '\r', '\n' };
+constexpr char kRecordIndexMagic[8] = { 'S', 'P', 'C', 'I', 'D', 'X', '\r', '\n' };
+constexpr uint32_t kRecordVersion = 1;
+constexpr size_t kRecordFileHeaderSize = 16;
+constexpr size_t kRecordHeaderSize = 16;
+constexpr size_t kRecordIndexEntrySize = 16;
+constexpr uint64_t kRecordIndexInterval = 64 * 1024;
+
+namespace RecordFlag {
+constexpr uint16_t Gap = 0x0001;   // 此记录之前有数据块因写盘队列满被丢弃
+constexpr uint16_t Full = 0x0002;  // 读取填满了数据块，数据可能在下一条记录中继续
+}
+
+struct RecordHeader {
+    uint32_t length;
+    uint16_t flags;
+    uint64_t timestampNs;
+};
+
+namespace RecordCodec {
+
+inline void put(char* out, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) {
+        out[i] = static_cast<char>(value >> (8 * i));
+    }
+}
+
+inline uint64_t get(const char* in, size_t bytes) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; ++i) {
+        value |= static_cast<uint64_t>(static_cast<uint8_t>(in[i])) << (8 * i);
+    }
+    return value;
+}
+
+} // namespace RecordCodec
+
+inline void encodeRecordFileHeader(const char (&magic)[8], char* out) {
+    std::memcpy(out, magic, sizeof(magic));
+    RecordCodec::put(out + 8, kRecordVersion, 4);
+    RecordCodec::put(out + 12, 0, 4);
+}
+
+// magic 不符或版本不支持时返回 false
+inline bool checkRecordFileHeader(const char (&magic)[8], const char* in) {
+    return std::memcmp(in, magic, sizeof(magic)) == 0 &&
+           RecordCodec::get(in + 8, 4) == kRecordVersion;
+}
+
+inline void encodeRecordHeader(const RecordHeader& header, char* out) {
+    RecordCodec::put(out, header.length, 4);
+    RecordCodec::put(out + 4, header.flags, 2);
+    RecordCodec::put(out + 6, 0, 2);
+    RecordCodec::put(out + 8, header.timestampNs, 8);
+}
+
+inline RecordHeader decodeRecordHeader(const char* in) {
+    RecordHeader header;
+    header.length = static_cast<uint32_t>(RecordCodec::get(in, 4));
+    header.flags = static_cast<uint16_t>(RecordCodec::get(in + 4, 2));
+    header.timestampNs = RecordCodec::get(in + 8, 8);
+    return header;
+}
+
+inline void encodeRecordIndexEntry(uint64_t timestampNs, uint64_t offset, char* out) {
+    RecordCodec::put(out, timestampNs, 8);
+    RecordCodec::put(out + 8, offset, 8);
+}
+
+inline void decodeRecordIndexEntry(const char* in, uint64_t& timestampNs, uint64_t& offset) {
+    timestampNs = RecordCodec::get(in, 8);
+    offset = RecordCodec::get(in + 8, 8);
+}
@@ -0,0 +1,211 @@
+// Record 格式数据文件的查看工具
+// 用法: RecordCat [--from 时间] [--to 时间] [--raw | --hex | --stats] <YYYYMMDD.rec>
+//   时间为本地时间 "YYYY-MM-DD HH:MM:SS[.小数]"，或只写 "HH:MM:SS[.小数]" 表示文件第一条记录的当天
+//   默认每条记录输出一行 "[时间戳] 数据"，--raw 只输出原始数据，--hex 输出十六进制，
+//   --stats 只输出统计；记录之前有数据块被丢弃时在时间戳后标记 (gap)
+#include "Common.h"
+#include "RecordReader.h"
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+namespace {
+
+enum class OutputMode { Text, Raw, Hex, Stats };
+
+void usage() {
+    std::cerr << "Usage: RecordCat [--from TIME] [--to TIME] [--raw | --hex | --stats] <file.rec>\n"
+              << "  TIME is local time \"YYYY-MM-DD HH:MM:SS[.fraction]\" or \"HH:MM:SS[.fraction]\"\n"
+              << "  (the latter on the day of the first record)" << std::endl;
+}
+
+// 解析失败返回 false；只有时分秒时使用 firstNs 所在的日期
+bool parseTime(const std::string& text, uint64_t firstNs, uint64_t& timestampNs) {
+    std::string value = text;
+    uint64_t fractionNs = 0;
+    size_t dot = value.find('.');
+    if (dot != std::string::npos) {
+        std::string digits = value.substr(dot + 1, 9);
+        if (digits.empty() || digits.find_first_not_of("0123456789") != std::string::npos) {
+            return false;
+        }
+        digits.append(9 - digits.size(), '0');
+        fractionNs = std::stoull(digits);
+        value.erase(dot);
+    }
+
+    struct tm timeinfo = {};
+    std::istringstream input(value);
+    if (value.find('-') != std::string::npos) {
+        input >> std::get_time(&timeinfo, "%Y-%m-%d %H:%M:%S");
+    } else {
+        time_t first = static_cast<time_t>(firstNs / 1000000000ull);
+        localtime_s(&timeinfo, &first);
+        input >> std::get_time(&timeinfo, "%H:%M:%S");
+    }
+    if (input.fail()) {
+        return false;
+    }
+    timeinfo.tm_isdst = -1;
+    time_t seconds = std::mktime(&timeinfo);
+    if (seconds < 0) {
+        return false;
+    }
+    timestampNs = static_cast<uint64_t>(seconds) * 1000000000ull + fractionNs;
+    return true;
+}
+
+// "[2024-01-18 12:34:56.123456789] "
+size_t formatTime(uint64_t timestampNs, char* out, size_t size) {
+    time_t seconds = static_cast<time_t>(timestampNs / 1000000000ull);
+    struct tm timeinfo;
+    localtime_s(&timeinfo, &seconds);
+    size_t length = std::strftime(out, size, "[%Y-%m-%d %H:%M:%S", &timeinfo);
+    length += std::snprintf(out + length, size - length, ".%09llu] ",
+                            static_cast<unsigned long long>(timestampNs % 1000000000ull));
+    return length;
+}
+
+void printRecord(const RecordReader::Record& record, OutputMode mode) {
+    if (mode == OutputMode::Raw) {
+        std::fwrite(record.data, 1, record.size, stdout);
+        return;
+    }
+
+    char prefix[64];
+    size_t length = formatTime(record.timestampNs, prefix, sizeof(prefix));
+    std::fwrite(prefix, 1, length, stdout);
+    if (record.flags & RecordFlag::Gap) {
+        std::fputs("(gap) ", stdout);
+    }
+
+    if (mode == OutputMode::Text) {
+        std::fwrite(record.data, 1, record.size, stdout);
+        if (record.size == 0 || record.data[record.size - 1] != '\n') {
+            std::fputc('\n', stdout);
+        }
+        return;
+    }
+
+    std::printf("%u bytes\n", record.size);
+    for (uint32_t line = 0; line < record.size; line += 16) {
+        std::printf("  %08x ", line);
+        for (uint32_t i = line; i < line + 16; ++i) {
+            if (i < record.size) {
+                std::printf(" %02x", static_cast<unsigned char>(record.data[i]));
+            } else {
+                std::fputs("   ", stdout);
+            }
+        }
+        std::fputs("  ", stdout);
+        for (uint32_t i = line; i < line + 16 && i < record.size; ++i) {
+            unsigned char c = static_cast<unsigned char>(record.data[i]);
+            std::fputc(c >= 0x20 && c < 0x7f ? c : '.', stdout);
+        }
+        std::fputc('\n', stdout);
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string path;
+    std::string fromText;
+    std::string toText;
+    OutputMode mode = OutputMode::Text;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if ((arg == "--from" || arg == "--to") && i + 1 < argc) {
+            (arg == "--from" ? fromText : toText) = argv[++i];
+        } else if (arg == "--raw") {
+            mode = OutputMode::Raw;
+        } else if (arg == "--hex") {
+            mode = OutputMode::Hex;
+        } else if (arg == "--stats") {
+            mode = OutputMode::Stats;
+        } else if (!arg.empty() && arg[0] != '-' && path.empty()) {
+            path = arg;
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (path.empty()) {
+        usage();
+        return 2;
+    }
+
+    RecordReader reader;
+    if (!reader.open(path)) {
+        std::cerr << reader.error() << std::endl;
+        return 1;
+    }
+
+    uint64_t offset = reader.begin();
+    RecordReader::Record record;
+    uint64_t firstNs = 0;
+    {
+        uint64_t probe = offset;
+        if (reader.next(probe, record)) {
+            firstNs = record.timestampNs;
+        }
+    }
+
+    uint64_t fromNs = 0;
+    uint64_t toNs = UINT64_MAX;
+    if ((!fromText.empty() && !parseTime(fromText, firstNs, fromNs)) ||
+        (!toText.empty() && !parseTime(toText, firstNs, toNs))) {
+        std::cerr << "Invalid time, expected \"YYYY-MM-DD HH:MM:SS[.fraction]\" or \"HH:MM:SS[.fraction]\""
+                  << std::endl;
+        return 2;
+    }
+    if (!fromText.empty()) {
+        offset = reader.seek(fromNs);
+    }
+
+    uint64_t records = 0;
+    uint64_t bytes = 0;
+    uint64_t gaps = 0;
+    uint64_t startNs = 0;
+    uint64_t endNs = 0;
+    while (reader.next(offset, record)) {
+        // 索引假定时间非递减，到达结束时间即停止
+        if (record.timestampNs > toNs) {
+            break;
+        }
+        if (records == 0) {
+            startNs = record.timestampNs;
+        }
+        endNs = record.timestampNs;
+        records++;
+        bytes += record.size;
+        if (record.flags & RecordFlag::Gap) {
+            gaps++;
+        }
+        if (mode != OutputMode::Stats) {
+            printRecord(record, mode);
+        }
+    }
+
+    if (mode == OutputMode::Stats) {
+        char start[64] = "-";
+        char end[64] = "-";
+        if (records > 0) {
+            formatTime(startNs, start, sizeof(start));
+            formatTime(endNs, end, sizeof(end));
+        }
+        std::cout << "File size:     " << reader.size() << "\n"
+                  << "Index entries: " << reader.indexEntries() << "\n"
+                  << "Records:       " << records << "\n"
+                  << "Payload bytes: " << bytes << "\n"
+                  << "Gaps:          " << gaps << "\n"
+                  << "First:         " << start << "\n"
+                  << "Last:          " << end << std::endl;
+    }
+    return 0;
+}
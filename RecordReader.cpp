@@ -0,0 +1,175 @@
+#include "RecordReader.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+RecordReader::RecordReader()
+    : m_data(nullptr), m_size(0),
+#ifdef _WIN32
+      m_file(INVALID_HANDLE_VALUE), m_mapping(nullptr)
+#else
+      m_fd(-1)
+#endif
+{}
+
+RecordReader::~RecordReader() {
+    close();
+}
+
+bool RecordReader::open(const std::string& path) {
+    close();
+
+#ifdef _WIN32
+    // 允许采集程序继续写入
+    m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                         nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    LARGE_INTEGER size;
+    if (m_file == INVALID_HANDLE_VALUE || !GetFileSizeEx(m_file, &size)) {
+        m_error = "cannot open " + path;
+        close();
+        return false;
+    }
+    m_size = static_cast<uint64_t>(size.QuadPart);
+    if (m_size >= kRecordFileHeaderSize) {
+        m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        m_data = m_mapping ? static_cast<const char*>(
+            MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+    }
+#else
+    m_fd = ::open(path.c_str(), O_RDONLY);
+    struct stat st;
+    if (m_fd < 0 || fstat(m_fd, &st) != 0) {
+        m_error = "cannot open " + path + ": " + std::strerror(errno);
+        close();
+        return false;
+    }
+    m_size = static_cast<uint64_t>(st.st_size);
+    if (m_size >= kRecordFileHeaderSize) {
+        void* data = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, m_fd, 0);
+        if (data != MAP_FAILED) {
+            m_data = static_cast<const char*>(data);
+            // 按时间查找后基本是顺序读取
+            madvise(data, m_size, MADV_SEQUENTIAL);
+        }
+    }
+#endif
+
+    if (m_size < kRecordFileHeaderSize || !m_data) {
+        m_error = m_size < kRecordFileHeaderSize ? path + " is too short" : "cannot map " + path;
+        close();
+        return false;
+    }
+    if (!checkRecordFileHeader(kRecordMagic, m_data)) {
+        m_error = path + " is not a record file";
+        close();
+        return false;
+    }
+
+    std::string indexPath = path;
+    size_t dot = indexPath.find_last_of('.');
+    size_t slash = indexPath.find_last_of("/\\");
+    if (dot != std::string::npos && (slash == std::string::npos || dot > slash)) {
+        indexPath.erase(dot);
+    }
+    loadIndex(indexPath + ".idx");
+    return true;
+}
+
+void RecordReader::close() {
+#ifdef _WIN32
+    if (m_data) {
+        UnmapViewOfFile(m_data);
+    }
+    if (m_mapping) {
+        CloseHandle(m_mapping);
+        m_mapping = nullptr;
+    }
+    if (m_file != INVALID_HANDLE_VALUE) {
+        CloseHandle(m_file);
+        m_file = INVALID_HANDLE_VALUE;
+    }
+#else
+    if (m_data) {
+        munmap(const_cast<char*>(m_data), m_size);
+    }
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+#endif
+    m_data = nullptr;
+    m_size = 0;
+    m_index.clear();
+}
+
+void RecordReader::loadIndex(const std::string& path) {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        return;
+    }
+
+    char header[kRecordFileHeaderSize];
+    if (std::fread(header, 1, sizeof(header), file) == sizeof(header) &&
+        checkRecordFileHeader(kRecordIndexMagic, header)) {
+        // 只接受偏移递增且落在数据文件内的条目，遇到不合法的条目就停止
+        char entry[kRecordIndexEntrySize];
+        uint64_t last = 0;
+        while (std::fread(entry, 1, sizeof(entry), file) == sizeof(entry)) {
+            IndexEntry item;
+            decodeRecordIndexEntry(entry, item.timestampNs, item.offset);
+            if (item.offset < kRecordFileHeaderSize || item.offset >= m_size ||
+                (!m_index.empty() && item.offset <= last)) {
+                break;
+            }
+            last = item.offset;
+            m_index.push_back(item);
+        }
+    }
+    std::fclose(file);
+}
+
+uint64_t RecordReader::seek(uint64_t timestampNs) const {
+    // 最后一个早于目标时间的索引点之后才可能出现目标记录
+    auto it = std::partition_point(m_index.begin(), m_index.end(),
+        [timestampNs](const IndexEntry& entry) { return entry.timestampNs < timestampNs; });
+    uint64_t offset = it == m_index.begin() ? begin() : (it - 1)->offset;
+
+    Record record;
+    uint64_t current = offset;
+    while (next(offset, record)) {
+        if (record.timestampNs >= timestampNs) {
+            return current;
+        }
+        current = offset;
+    }
+    return current;
+}
+
+bool RecordReader::next(uint64_t& offset, Record& record) const {
+    if (offset < kRecordFileHeaderSize || m_size < kRecordHeaderSize ||
+        offset > m_size - kRecordHeaderSize) {
+        return false;
+    }
+    RecordHeader header = decodeRecordHeader(m_data + offset);
+    if (header.length > m_size - offset - kRecordHeaderSize) {
+        return false;
+    }
+
+    record.offset = offset;
+    record.timestampNs = header.timestampNs;
+    record.flags = header.flags;
+    record.size = header.length;
+    record.data = m_data + offset + kRecordHeaderSize;
+    offset += kRecordHeaderSize + header.length;
+    return true;
+}
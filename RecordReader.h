@@ -0,0 +1,61 @@
+#pragma once
+#include "Record.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Record 格式数据文件（见 Record.h）的只读访问
+// 数据文件整体映射到内存；按时间查找时先在稀疏索引中二分，再从最近的索引点向后扫描，
+// 不需要读取整个文件。可以打开正在写入的文件，只看到打开时已写出的记录
+class RecordReader {
+public:
+    struct Record {
+        uint64_t offset;  // 记录在文件中的偏移
+        uint64_t timestampNs;
+        uint16_t flags;
+        uint32_t size;
+        const char* data;  // 指向映射区，close() 后失效
+    };
+
+    RecordReader();
+    ~RecordReader();
+
+    RecordReader(const RecordReader&) = delete;
+    RecordReader& operator=(const RecordReader&) = delete;
+
+    // 同时加载同名 .idx；索引缺失或损坏时按时间查找退化为从头扫描
+    bool open(const std::string& path);
+    void close();
+    const std::string& error() const { return m_error; }
+
+    uint64_t begin() const { return kRecordFileHeaderSize; }
+    uint64_t size() const { return m_size; }
+    size_t indexEntries() const { return m_index.size(); }
+
+    // 第一条时间戳不早于 timestampNs 的记录的偏移，没有时返回已写出记录的末尾
+    // 索引假定时间戳随偏移非递减，系统时间被回拨过时结果只是近似的
+    uint64_t seek(uint64_t timestampNs) const;
+
+    // 解析 offset 处的记录并把 offset 移到下一条
+    // 到达末尾或末尾记录不完整（正在写入）时返回 false
+    bool next(uint64_t& offset, Record& record) const;
+
+private:
+    struct IndexEntry {
+        uint64_t timestampNs;
+        uint64_t offset;
+    };
+
+    void loadIndex(const std::string& path);
+
+    const char* m_data;
+    uint64_t m_size;
+#ifdef _WIN32
+    void* m_file;
+    void* m_mapping;
+#else
+    int m_fd;
+#endif
+    std::vector<IndexEntry> m_index;
+    std::string m_error;
+};
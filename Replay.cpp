@@ -0,0 +1,906 @@
+// 录制数据回放：把采集器保存的数据文件重新发送到 TCP 接收端或虚拟串口，用于对下游接收端做负载测试，
+// 或者把现场数据回放给采集器本身
+// 用法: Replay [选项] <数据文件或 data/<串口> 目录>...，--help 查看选项；发送失败时返回 1
+//
+// 文本数据文件按行首的 "[YYYY-MM-DD HH:MM:SS[.小数]] " 时间戳前缀切分记录，没有前缀的行属于上一条记录，
+// 未开启 addTimestamp 的文件没有时间信息，尽快发送；Record 格式文件使用记录中的纳秒时间戳。
+// 所有串口以最早的一条记录为起点对齐，串口之间的相对时间保持不变，--speed 按倍数缩短间隔。
+// 少量工作线程各负责一部分串口，用 ppoll 等待下一条记录的发送时刻或连接可写，writev 直接从文件映射区发送
+#include "Frame.h"
+#include "Metrics.h"
+#include "Record.h"
+#include "RecordReader.h"
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <pty.h>
+#include <signal.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <termios.h>
+#include <unistd.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+constexpr size_t kMaxIov = 64;                  // 一次 writev 最多的片段数
+constexpr size_t kMaxBatchBytes = 256 * 1024;   // 一次 writev 最多的字节数
+constexpr size_t kMaxPumpBytes = 1024 * 1024;   // 每个连接每轮最多发送的字节数，同一线程的连接轮流发送
+constexpr auto kProgressInterval = std::chrono::seconds(5);
+constexpr auto kPtyDrainTimeout = std::chrono::seconds(5);
+
+volatile std::sig_atomic_t g_stop = 0;
+
+void onSignal(int) {
+    g_stop = 1;
+}
+
+struct Options {
+    std::vector<std::string> inputs;
+    std::string tcpHost;
+    std::string tcpPort;
+    std::string ptyDir;
+    double speed = 1.0;  // 0 为尽快发送
+    int threads = 0;     // 0 为 min(4, 串口数, CPU 数)
+    bool multiplex = false;
+    bool originalTime = false;
+    double delaySeconds = 0.0;
+};
+
+uint64_t steadyNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+uint64_t wallNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+void usage() {
+    std::cout <<
+        "Usage: Replay [options] <file.data | file.rec | data/<port>>...\n"
+        "  --tcp HOST:PORT    send each port's stream to this TCP receiver\n"
+        "  --multiplex        send frames (see Frame.h), one connection per worker thread\n"
+        "  --original-time    frame timestamps are the recorded read times (default: send time)\n"
+        "  --pty DIR          create a virtual serial port per port, linked as DIR/<port>\n"
+        "  --speed F          replay F times faster than recorded (default 1)\n"
+        "  --max              replay as fast as the target accepts\n"
+        "  --threads N        worker threads (default min(4, ports, CPUs))\n"
+        "  --delay S          wait S seconds after opening the targets before sending (default 0)\n"
+        "Files of the same port are replayed in day and segment order; a directory adds all its\n"
+        "uncompressed .data and .rec files.\n";
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto next = [&]() -> const char* { return i + 1 < argc ? argv[++i] : nullptr; };
+        const char* value = nullptr;
+        if (arg == "--multiplex") {
+            options.multiplex = true;
+        } else if (arg == "--original-time") {
+            options.originalTime = true;
+        } else if (arg == "--max") {
+            options.speed = 0.0;
+        } else if (arg == "--help" || arg == "-h") {
+            return false;
+        } else if (!arg.empty() && arg[0] != '-') {
+            options.inputs.push_back(arg);
+        } else if ((value = next()) == nullptr) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            return false;
+        } else if (arg == "--tcp") {
+            std::string target = value;
+            size_t colon = target.rfind(':');
+            if (colon == std::string::npos || colon == 0 || colon + 1 == target.size()) {
+                std::cerr << "--tcp expects HOST:PORT" << std::endl;
+                return false;
+            }
+            options.tcpHost = target.substr(0, colon);
+            options.tcpPort = target.substr(colon + 1);
+        } else if (arg == "--pty") {
+            options.ptyDir = value;
+        } else if (arg == "--speed") {
+            options.speed = std::atof(value);
+            if (options.speed <= 0.0) {
+                std::cerr << "--speed must be positive, use --max for maximum rate" << std::endl;
+                return false;
+            }
+        } else if (arg == "--threads") {
+            options.threads = std::atoi(value);
+        } else if (arg == "--delay") {
+            options.delaySeconds = std::atof(value);
+        } else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return false;
+        }
+    }
+    if (options.tcpHost.empty() == options.ptyDir.empty()) {
+        std::cerr << "Specify exactly one of --tcp and --pty" << std::endl;
+        return false;
+    }
+    if (options.multiplex && options.tcpHost.empty()) {
+        std::cerr << "--multiplex needs --tcp" << std::endl;
+        return false;
+    }
+    return !options.inputs.empty();
+}
+
+// ---------------------------------------------------------------- 数据文件
+
+struct Record {
+    uint64_t timestampNs;  // 0 为没有时间信息
+    uint16_t flags;
+    const char* data;
+    size_t size;
+};
+
+// 只读映射整个文件，只看到打开时已写出的数据
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { close(); }
+
+    bool open(const std::string& path, std::string& error) {
+        close();
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) != 0) {
+            error = "cannot open " + path + ": " + std::strerror(errno);
+            if (fd >= 0) {
+                ::close(fd);
+            }
+            return false;
+        }
+        m_size = static_cast<size_t>(st.st_size);
+        if (m_size > 0) {
+            void* data = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+            if (data == MAP_FAILED) {
+                error = "cannot map " + path + ": " + std::strerror(errno);
+                m_size = 0;
+                ::close(fd);
+                return false;
+            }
+            madvise(data, m_size, MADV_SEQUENTIAL);
+            m_data = static_cast<const char*>(data);
+        }
+        ::close(fd);
+        return true;
+    }
+
+    void close() {
+        if (m_data) {
+            munmap(const_cast<char*>(m_data), m_size);
+        }
+        m_data = nullptr;
+        m_size = 0;
+    }
+
+    const char* data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+private:
+    const char* m_data = nullptr;
+    size_t m_size = 0;
+};
+
+// 文本格式的时间戳前缀 "[YYYY-MM-DD HH:MM:SS[.小数]] "，按本地时间换算；
+// 同一秒内复用上一次 mktime 的结果，与写入时的 TimestampFormatter 对应
+class PrefixParser {
+public:
+    // p 处是时间戳前缀时返回前缀长度并写入 timestampNs，否则返回 0
+    size_t parse(const char* p, size_t size, uint64_t& timestampNs) {
+        static const char kPattern[] = "[dddd-dd-dd dd:dd:dd";
+        constexpr size_t kDateLength = sizeof(kPattern) - 1;
+        if (size < kDateLength + 2) {
+            return 0;
+        }
+        for (size_t i = 0; i < kDateLength; ++i) {
+            if (kPattern[i] == 'd' ? !isDigit(p[i]) : p[i] != kPattern[i]) {
+                return 0;
+            }
+        }
+
+        size_t pos = kDateLength;
+        uint64_t fractionNs = 0;
+        if (p[pos] == '.') {
+            size_t digits = 0;
+            for (++pos; pos < size && isDigit(p[pos]) && digits < 9; ++pos, ++digits) {
+                fractionNs = fractionNs * 10 + static_cast<uint64_t>(p[pos] - '0');
+            }
+            if (digits == 0) {
+                return 0;
+            }
+            for (; digits < 9; ++digits) {
+                fractionNs *= 10;
+            }
+        }
+        if (pos + 2 > size || p[pos] != ']' || p[pos + 1] != ' ') {
+            return 0;
+        }
+
+        if (std::memcmp(p + 1, m_cached, kDateLength - 1) != 0) {
+            struct tm timeinfo = {};
+            timeinfo.tm_year = number(p + 1, 4) - 1900;
+            timeinfo.tm_mon = number(p + 6, 2) - 1;
+            timeinfo.tm_mday = number(p + 9, 2);
+            timeinfo.tm_hour = number(p + 12, 2);
+            timeinfo.tm_min = number(p + 15, 2);
+            timeinfo.tm_sec = number(p + 18, 2);
+            timeinfo.tm_isdst = -1;
+            time_t seconds = std::mktime(&timeinfo);
+            if (seconds < 0) {
+                return 0;
+            }
+            std::memcpy(m_cached, p + 1, kDateLength - 1);
+            m_seconds = static_cast<uint64_t>(seconds);
+        }
+        timestampNs = m_seconds * 1000000000ull + fractionNs;
+        return pos + 2;
+    }
+
+private:
+    static bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+    static int number(const char* p, size_t digits) {
+        int value = 0;
+        for (size_t i = 0; i < digits; ++i) {
+            value = value * 10 + (p[i] - '0');
+        }
+        return value;
+    }
+
+    char m_cached[19] = {};  // "YYYY-MM-DD HH:MM:SS"
+    uint64_t m_seconds = 0;
+};
+
+// 一个串口按顺序排列的数据文件，逐条取出记录；无法打开的文件跳过。
+// 发送队列中的记录直接指向映射区，已打开的文件保持映射到回放结束
+class PortSource {
+public:
+    void addFile(const std::string& path) { m_paths.push_back(path); }
+    const std::vector<std::string>& files() const { return m_paths; }
+
+    // 记录用完时返回 false
+    bool next(Record& record) {
+        for (;;) {
+            if (m_open) {
+                if (m_isRecord) {
+                    RecordReader::Record item;
+                    if (m_readers.back()->next(m_offset, item)) {
+                        record = { item.timestampNs, item.flags, item.data, item.size };
+                        return true;
+                    }
+                } else if (m_offset < m_texts.back()->size()) {
+                    nextText(record);
+                    return true;
+                }
+                m_open = false;
+            }
+            if (m_nextPath == m_paths.size()) {
+                return false;
+            }
+            openFile(m_paths[m_nextPath++]);
+        }
+    }
+
+private:
+    void openFile(const std::string& path) {
+        std::string error;
+        m_isRecord = std::filesystem::path(path).extension() == ".rec";
+        if (m_isRecord) {
+            m_readers.push_back(std::make_unique<RecordReader>());
+            m_open = m_readers.back()->open(path);
+            error = m_readers.back()->error();
+            m_offset = m_readers.back()->begin();
+        } else {
+            m_texts.push_back(std::make_unique<MappedFile>());
+            m_open = m_texts.back()->open(path, error);
+            m_offset = 0;
+        }
+        if (!m_open) {
+            std::cerr << error << ", skipped" << std::endl;
+        }
+    }
+
+    // 一条记录从时间戳前缀之后到下一个以时间戳前缀开头的行为止
+    void nextText(Record& record) {
+        const char* base = m_texts.back()->data();
+        size_t size = m_texts.back()->size();
+        size_t start = m_offset;
+        uint64_t timestampNs = 0;
+        size_t prefix = m_parser.parse(base + start, size - start, timestampNs);
+        size_t end = start + prefix;
+        while (end < size) {
+            const void* newline = std::memchr(base + end, '\n', size - end);
+            end = newline ? static_cast<size_t>(static_cast<const char*>(newline) - base) + 1 : size;
+            uint64_t ignored;
+            if (end < size && m_parser.parse(base + end, size - end, ignored) > 0) {
+                break;
+            }
+        }
+        record = { timestampNs, 0, base + start + prefix, end - start - prefix };
+        m_offset = end;
+    }
+
+    std::vector<std::string> m_paths;
+    size_t m_nextPath = 0;
+    bool m_open = false;
+    bool m_isRecord = false;
+    uint64_t m_offset = 0;
+    std::vector<std::unique_ptr<RecordReader>> m_readers;
+    std::vector<std::unique_ptr<MappedFile>> m_texts;
+    PrefixParser m_parser;
+};
+
+// 文件名 YYYYMMDD[.N].data / .rec 按日期、分段序号排序
+bool fileOrder(const std::filesystem::path& a, const std::filesystem::path& b) {
+    auto key = [](const std::filesystem::path& path) {
+        std::string name = path.filename().string();
+        size_t dot = name.find('.');
+        std::string day = name.substr(0, dot);
+        unsigned long segment = 0;
+        if (dot != std::string::npos && dot + 1 < name.size() && std::isdigit(static_cast<unsigned char>(name[dot + 1]))) {
+            segment = std::strtoul(name.c_str() + dot + 1, nullptr, 10);
+        }
+        return std::make_tuple(day, segment, name);
+    };
+    return key(a) < key(b);
+}
+
+bool isCompressed(const std::filesystem::path& path) {
+    std::string extension = path.extension().string();
+    return extension == ".zst" || extension == ".lz4" || extension == ".gz";
+}
+
+// ---------------------------------------------------------------- 发送
+
+struct Port {
+    // 已加入发送队列、尚未发完的记录
+    struct InFlight {
+        uint64_t dueNs;
+        uint64_t timestampNs;
+        size_t size;
+    };
+
+    std::string name;
+    uint16_t portId = 0;
+    PortSource source;
+
+    bool hasRecord = false;
+    bool done = false;
+    Record record = {};
+    uint64_t dueNs = 0;      // 当前记录的发送时刻（steady_clock）
+    uint64_t lastDueNs = 0;
+    uint64_t sequence = 0;
+    std::deque<InFlight> inFlight;
+
+    std::atomic<uint64_t> records{ 0 };
+    std::atomic<uint64_t> bytes{ 0 };
+    uint64_t firstSendNs = 0;
+    uint64_t lastSendNs = 0;
+    uint64_t firstRecordNs = 0;  // 已发送的第一条和最后一条有时间信息的记录
+    uint64_t lastRecordNs = 0;
+    Histogram lateness;          // 实际发送时刻比计划晚的时间
+};
+
+struct Segment {
+    const char* data;
+    size_t size;
+    Port* port;   // 记录的数据片段才有，发送完后计入该串口
+    bool header;  // 帧头片段，发送完后释放 Output::headers 的第一个
+};
+
+// 一个发送目标：TCP 连接或虚拟串口主端，多路复用时同一线程的串口共用一个连接
+struct Output {
+    int fd = -1;
+    int slave = -1;  // 虚拟串口从端，保持打开，否则没有读取方时主端会读到挂断
+    std::vector<Port*> ports;
+    std::deque<Segment> queue;
+    std::deque<std::array<char, kFrameHeaderSize>> headers;  // 帧头，与 queue 中的帧头片段一一对应
+    size_t queued = 0;
+    bool failed = false;
+};
+
+class Replayer {
+public:
+    // 各工作线程共用，只访问传给 run() 的发送目标
+    Replayer(const Options& options, uint64_t startNs, uint64_t originNs)
+        : m_options(options), m_startNs(startNs), m_originNs(originNs) {}
+
+    // 计算 port 当前记录的发送时刻；记录的时间不早于上一条
+    void schedule(Port& port) const {
+        uint64_t due = port.lastDueNs;
+        if (m_options.speed > 0.0 && port.record.timestampNs != 0) {
+            uint64_t offset = port.record.timestampNs > m_originNs ? port.record.timestampNs - m_originNs : 0;
+            due = (std::max)(due, m_startNs + static_cast<uint64_t>(static_cast<double>(offset) / m_options.speed));
+        }
+        port.dueNs = port.lastDueNs = due;
+    }
+
+    void run(std::vector<Output*>& outputs) {
+        std::vector<pollfd> fds;
+        for (;;) {
+            uint64_t now = steadyNs();
+            uint64_t wake = UINT64_MAX;
+            bool active = false;
+            fds.clear();
+            for (Output* output : outputs) {
+                if (output->failed) {
+                    continue;
+                }
+                size_t pumped = 0;
+                while (!g_stop && pumped < kMaxPumpBytes) {
+                    fill(*output, now);
+                    if (output->queue.empty() || !flush(*output, pumped)) {
+                        break;
+                    }
+                    now = steadyNs();
+                }
+                if (output->failed) {
+                    continue;
+                }
+                if (!output->queue.empty()) {
+                    fds.push_back({ output->fd, POLLOUT, 0 });
+                    active = true;
+                }
+                for (Port* port : output->ports) {
+                    if (ensureRecord(*port)) {
+                        active = true;
+                        wake = (std::min)(wake, port->dueNs);
+                    }
+                }
+            }
+            if (!active || g_stop) {
+                return;
+            }
+
+            timespec timeout = { 1, 0 };
+            now = steadyNs();
+            if (wake != UINT64_MAX) {
+                uint64_t wait = wake > now ? (std::min)(wake - now, uint64_t(1000000000)) : 0;
+                timeout = { static_cast<time_t>(wait / 1000000000), static_cast<long>(wait % 1000000000) };
+            }
+            ppoll(fds.data(), fds.size(), &timeout, nullptr);
+        }
+    }
+
+private:
+    // 取出 port 的下一条记录，记录用完时标记完成
+    bool ensureRecord(Port& port) const {
+        if (port.hasRecord) {
+            return true;
+        }
+        if (port.done || !port.source.next(port.record)) {
+            port.done = true;
+            return false;
+        }
+        port.hasRecord = true;
+        schedule(port);
+        return true;
+    }
+
+    // 各串口轮流把已到发送时刻的记录加入发送队列，直到队列达到单次 writev 的上限
+    void fill(Output& output, uint64_t now) {
+        bool progress = true;
+        while (progress) {
+            progress = false;
+            for (Port* port : output.ports) {
+                if (output.queued >= kMaxBatchBytes || output.queue.size() + 2 > kMaxIov) {
+                    return;
+                }
+                if (!ensureRecord(*port) || port->dueNs > now) {
+                    continue;
+                }
+                enqueue(output, *port);
+                port->hasRecord = false;
+                progress = true;
+            }
+        }
+    }
+
+    void enqueue(Output& output, Port& port) {
+        const Record& record = port.record;
+        if (m_options.multiplex) {
+            // 记录之前有数据块被丢弃时序号跳过一个，接收端能看到缺口
+            if (record.flags & RecordFlag::Gap) {
+                port.sequence++;
+            }
+            uint64_t stamp = m_options.originalTime && record.timestampNs != 0 ? record.timestampNs : wallNs();
+            output.headers.emplace_back();
+            encodeFrameHeader({ FrameType::Data, port.portId, static_cast<uint32_t>(record.size),
+                                port.sequence++, stamp }, output.headers.back().data());
+            output.queue.push_back({ output.headers.back().data(), kFrameHeaderSize, nullptr, true });
+            output.queued += kFrameHeaderSize;
+        }
+        output.queue.push_back({ record.data, record.size, &port, false });
+        output.queued += record.size;
+        // 统计在记录完整发出后更新
+        port.inFlight.push_back({ port.dueNs, record.timestampNs, record.size });
+    }
+
+    // 发送队列前部的片段，返回是否全部发出；连接暂时不可写时返回 false，出错时标记失败
+    bool flush(Output& output, size_t& pumped) {
+        iovec iov[kMaxIov];
+        size_t count = 0;
+        for (auto it = output.queue.begin(); it != output.queue.end() && count < kMaxIov; ++it, ++count) {
+            iov[count].iov_base = const_cast<char*>(it->data);
+            iov[count].iov_len = it->size;
+        }
+        ssize_t written = ::writev(output.fd, iov, static_cast<int>(count));
+        if (written < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+                return false;
+            }
+            std::cerr << portNames(output) << ": write failed: " << std::strerror(errno) << std::endl;
+            output.failed = true;
+            for (Port* port : output.ports) {
+                port->done = true;
+            }
+            return false;
+        }
+
+        size_t left = static_cast<size_t>(written);
+        pumped += left;
+        output.queued -= left;
+        uint64_t now = steadyNs();
+        while (!output.queue.empty() && output.queue.front().size <= left) {
+            Segment segment = output.queue.front();
+            output.queue.pop_front();
+            left -= segment.size;
+            if (segment.port) {
+                complete(*segment.port, now);
+            } else if (segment.header) {
+                output.headers.pop_front();
+            }
+        }
+        if (left > 0) {
+            output.queue.front().data += left;
+            output.queue.front().size -= left;
+        }
+        return output.queue.empty();
+    }
+
+    void complete(Port& port, uint64_t now) {
+        Port::InFlight record = port.inFlight.front();
+        port.inFlight.pop_front();
+        if (port.records.load(std::memory_order_relaxed) == 0) {
+            port.firstSendNs = now;
+        }
+        port.lastSendNs = now;
+        if (record.timestampNs != 0) {
+            if (port.firstRecordNs == 0) {
+                port.firstRecordNs = record.timestampNs;
+            }
+            port.lastRecordNs = record.timestampNs;
+            if (m_options.speed > 0.0) {
+                port.lateness.record(now > record.dueNs ? now - record.dueNs : 0);
+            }
+        }
+        port.records.fetch_add(1, std::memory_order_relaxed);
+        port.bytes.fetch_add(record.size, std::memory_order_relaxed);
+    }
+
+    static std::string portNames(const Output& output) {
+        std::string names;
+        for (const Port* port : output.ports) {
+            names += (names.empty() ? "" : ",") + port->name;
+        }
+        return names;
+    }
+
+    const Options& m_options;
+    uint64_t m_startNs;   // 回放起点（steady_clock）
+    uint64_t m_originNs;  // 对应回放起点的记录时间
+};
+
+int connectTcp(const std::string& host, const std::string& port) {
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* result = nullptr;
+    int status = getaddrinfo(host.c_str(), port.c_str(), &hints, &result);
+    if (status != 0) {
+        std::cerr << "Cannot resolve " << host << ": " << gai_strerror(status) << std::endl;
+        return -1;
+    }
+    int fd = -1;
+    for (addrinfo* addr = result; addr; addr = addr->ai_next) {
+        fd = socket(addr->ai_family, addr->ai_socktype | SOCK_CLOEXEC, addr->ai_protocol);
+        if (fd >= 0 && connect(fd, addr->ai_addr, addr->ai_addrlen) == 0) {
+            break;
+        }
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(result);
+    if (fd < 0) {
+        std::cerr << "Cannot connect to " << host << ":" << port << ": " << std::strerror(errno) << std::endl;
+        return -1;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    return fd;
+}
+
+bool openPty(Output& output, const std::filesystem::path& link) {
+    if (openpty(&output.fd, &output.slave, nullptr, nullptr, nullptr) != 0) {
+        std::cerr << "openpty failed: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    termios tio;
+    tcgetattr(output.slave, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(output.slave, TCSANOW, &tio);
+    fcntl(output.fd, F_SETFL, fcntl(output.fd, F_GETFL) | O_NONBLOCK);
+    fcntl(output.fd, F_SETFD, FD_CLOEXEC);
+    fcntl(output.slave, F_SETFD, FD_CLOEXEC);
+    std::error_code ec;
+    std::filesystem::remove(link, ec);
+    std::filesystem::create_symlink(ttyname(output.slave), link, ec);
+    if (ec) {
+        std::cerr << "Cannot link " << link.string() << ": " << ec.message() << std::endl;
+        return false;
+    }
+    std::cout << link.string() << " -> " << ttyname(output.slave) << std::endl;
+    return true;
+}
+
+// 多路复用连接建立后先为每个串口发送一次名称帧
+void queuePortNames(Output& output) {
+    for (Port* port : output.ports) {
+        output.headers.emplace_back();
+        encodeFrameHeader({ FrameType::PortName, port->portId, static_cast<uint32_t>(port->name.size()), 0, 0 },
+                          output.headers.back().data());
+        output.queue.push_back({ output.headers.back().data(), kFrameHeaderSize, nullptr, true });
+        output.queue.push_back({ port->name.data(), port->name.size(), nullptr, false });
+        output.queued += kFrameHeaderSize + port->name.size();
+    }
+}
+
+std::string fixed(double value, int precision) {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(precision) << value;
+    return out.str();
+}
+
+std::string formatMs(uint64_t ns) {
+    return fixed(ns / 1e6, 2);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        usage();
+        return 2;
+    }
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    // 按串口收集文件：目录名即串口名，单个文件取所在目录名
+    std::vector<std::unique_ptr<Port>> ports;
+    std::map<std::string, Port*> byName;
+    auto portFor = [&](const std::string& name) {
+        Port*& port = byName[name];
+        if (!port) {
+            ports.push_back(std::make_unique<Port>());
+            port = ports.back().get();
+            port->name = name;
+            port->portId = static_cast<uint16_t>(ports.size());
+        }
+        return port;
+    };
+    for (const std::string& input : options.inputs) {
+        std::filesystem::path path = std::filesystem::path(input).lexically_normal();
+        if (path.filename().empty()) {
+            path = path.parent_path();
+        }
+        std::error_code ec;
+        if (std::filesystem::is_directory(path, ec)) {
+            std::vector<std::filesystem::path> files;
+            for (const auto& entry : std::filesystem::directory_iterator(path, ec)) {
+                std::string extension = entry.path().extension().string();
+                if (extension == ".data" || extension == ".rec") {
+                    files.push_back(entry.path());
+                } else if (isCompressed(entry.path())) {
+                    std::cerr << entry.path().string() << " is compressed, decompress it to replay" << std::endl;
+                }
+            }
+            std::sort(files.begin(), files.end(), fileOrder);
+            Port* port = portFor(path.filename().string());
+            for (const auto& file : files) {
+                port->source.addFile(file.string());
+            }
+        } else if (isCompressed(path)) {
+            std::cerr << input << " is compressed, decompress it to replay" << std::endl;
+            return 2;
+        } else {
+            std::string name = path.parent_path().filename().string();
+            portFor(name.empty() ? path.stem().string() : name)->source.addFile(path.string());
+        }
+    }
+
+    // 每个串口先取出第一条记录，最早的记录时间作为回放起点
+    uint64_t originNs = UINT64_MAX;
+    for (auto& port : ports) {
+        port->hasRecord = port->source.next(port->record);
+        port->done = !port->hasRecord;
+        if (port->hasRecord && port->record.timestampNs != 0) {
+            originNs = (std::min)(originNs, port->record.timestampNs);
+        } else if (port->hasRecord && options.speed > 0.0) {
+            std::cerr << port->name << ": no timestamps at the start, sent at maximum rate until the first one"
+                      << std::endl;
+        }
+    }
+    if (originNs == UINT64_MAX) {
+        originNs = 0;
+    }
+
+    // 打开发送目标，串口依次分给工作线程
+    size_t threads = options.threads > 0 ? static_cast<size_t>(options.threads) :
+        (std::min)({ size_t(4), ports.size(), size_t((std::max)(1u, std::thread::hardware_concurrency())) });
+    threads = (std::max)(size_t(1), (std::min)(threads, ports.size()));
+    std::vector<std::unique_ptr<Output>> outputs;
+    std::vector<std::vector<Output*>> workerOutputs(threads);
+    for (size_t i = 0; i < ports.size(); ++i) {
+        size_t worker = i % threads;
+        if (options.multiplex && workerOutputs[worker].size() == 1) {
+            workerOutputs[worker].front()->ports.push_back(ports[i].get());
+            continue;
+        }
+        outputs.push_back(std::make_unique<Output>());
+        Output& output = *outputs.back();
+        output.ports.push_back(ports[i].get());
+        bool opened = options.ptyDir.empty() ?
+            (output.fd = connectTcp(options.tcpHost, options.tcpPort)) >= 0 :
+            openPty(output, std::filesystem::path(options.ptyDir) / ports[i]->name);
+        if (!opened) {
+            return 2;
+        }
+        workerOutputs[worker].push_back(&output);
+    }
+    if (options.multiplex) {
+        for (auto& output : outputs) {
+            queuePortNames(*output);
+        }
+    }
+    if (options.delaySeconds > 0.0) {
+        std::this_thread::sleep_for(std::chrono::duration<double>(options.delaySeconds));
+    }
+
+    uint64_t startNs = steadyNs();
+    Replayer replayer(options, startNs, originNs);
+    for (auto& port : ports) {
+        port->lastDueNs = startNs;
+        if (port->hasRecord) {
+            replayer.schedule(*port);
+        }
+    }
+
+    std::atomic<size_t> running(threads);
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < threads; ++i) {
+        workers.emplace_back([&, i] {
+            replayer.run(workerOutputs[i]);
+            running.fetch_sub(1);
+        });
+    }
+
+    auto lastProgress = std::chrono::steady_clock::now();
+    while (running.load() > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        if (std::chrono::steady_clock::now() - lastProgress >= kProgressInterval) {
+            lastProgress = std::chrono::steady_clock::now();
+            uint64_t bytes = 0;
+            for (const auto& port : ports) {
+                bytes += port->bytes.load(std::memory_order_relaxed);
+            }
+            std::cerr << std::fixed << std::setprecision(1) << (steadyNs() - startNs) / 1e9 << " s: "
+                      << bytes / 1048576.0 << " MB sent" << std::endl;
+        }
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    uint64_t endNs = steadyNs();
+
+    // 虚拟串口等读取方取走缓冲区中的数据再关闭
+    if (!options.ptyDir.empty()) {
+        auto deadline = std::chrono::steady_clock::now() + kPtyDrainTimeout;
+        for (auto& output : outputs) {
+            int unread = 0;
+            while (!g_stop && std::chrono::steady_clock::now() < deadline &&
+                   ioctl(output->slave, FIONREAD, &unread) == 0 && unread > 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+        }
+    }
+
+    bool timed = options.speed > 0.0;
+    std::cout << std::setw(16) << "Port" << std::setw(10) << "Records" << std::setw(14) << "Bytes"
+              << std::setw(10) << "MB/s" << std::setw(9) << "Speed" << std::setw(10) << "p50(ms)"
+              << std::setw(10) << "p99(ms)" << std::setw(10) << "max(ms)" << std::endl;
+    Histogram total;
+    uint64_t totalRecords = 0;
+    uint64_t totalBytes = 0;
+    double recordedSeconds = 0.0;
+    double replaySeconds = 0.0;
+    for (const auto& port : ports) {
+        uint64_t records = port->records.load();
+        uint64_t bytes = port->bytes.load();
+        double seconds = (port->lastSendNs - port->firstSendNs) / 1e9;
+        double recorded = (port->lastRecordNs - port->firstRecordNs) / 1e9;
+        // 实际达到的倍速：记录时间跨度 / 回放时间跨度
+        std::string speed = timed && seconds > 0.0 && recorded > 0.0 ? fixed(recorded / seconds, 2) + "x" : "-";
+        std::cout << std::setw(16) << port->name << std::setw(10) << records << std::setw(14) << bytes
+                  << std::setw(10) << std::fixed << std::setprecision(2)
+                  << (seconds > 0.0 ? bytes / seconds / 1e6 : 0.0) << std::setw(9) << speed;
+        if (timed && port->lateness.count() > 0) {
+            std::cout << std::setw(10) << formatMs(port->lateness.percentileNs(0.5))
+                      << std::setw(10) << formatMs(port->lateness.percentileNs(0.99))
+                      << std::setw(10) << formatMs(port->lateness.percentileNs(1.0));
+        } else {
+            std::cout << std::setw(10) << "-" << std::setw(10) << "-" << std::setw(10) << "-";
+        }
+        std::cout << std::endl;
+        total.merge(port->lateness);
+        totalRecords += records;
+        totalBytes += bytes;
+        recordedSeconds = (std::max)(recordedSeconds, recorded);
+        replaySeconds = (std::max)(replaySeconds, seconds);
+    }
+
+    double wallSeconds = (endNs - startNs) / 1e9;
+    std::cout << std::fixed << std::setprecision(2)
+              << "Throughput:  " << (wallSeconds > 0.0 ? totalBytes / wallSeconds / 1e6 : 0.0) << " MB/s, "
+              << (wallSeconds > 0.0 ? totalRecords / wallSeconds : 0.0) << " records/s over " << wallSeconds
+              << " s (" << ports.size() << " ports, " << threads << " threads)\n";
+    if (timed && total.count() > 0) {
+        std::cout << "Timing:      lateness p50 " << formatMs(total.percentileNs(0.5))
+                  << " p99 " << formatMs(total.percentileNs(0.99))
+                  << " p999 " << formatMs(total.percentileNs(0.999))
+                  << " max " << formatMs(total.percentileNs(1.0)) << " ms, speed "
+                  << (replaySeconds > 0.0 ? recordedSeconds / replaySeconds : 0.0) << "x of requested "
+                  << options.speed << "x\n";
+    }
+    std::cout << std::flush;
+
+    bool failed = false;
+    for (auto& output : outputs) {
+        failed = failed || output->failed;
+        ::close(output->fd);
+        if (output->slave >= 0) {
+            ::close(output->slave);
+        }
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,152 @@
+#include "Scheduling.h"
+#include "Logger.h"
+#include <atomic>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <cerrno>
+#endif
+
+namespace {
+
+// 预先访问的栈大小，覆盖读取路径上的调用深度
+constexpr size_t kStackPrefaultBytes = 64 * 1024;
+
+std::atomic<bool> g_memoryLocked(false);
+
+#ifdef _WIN32
+DWORD_PTR g_defaultMask = 0;
+#elif defined(__linux__)
+cpu_set_t g_defaultCpus;
+bool g_defaultCaptured = false;
+#endif
+
+} // namespace
+
+void captureDefaultAffinity() {
+#ifdef _WIN32
+    DWORD_PTR systemMask;
+    GetProcessAffinityMask(GetCurrentProcess(), &g_defaultMask, &systemMask);
+#elif defined(__linux__)
+    CPU_ZERO(&g_defaultCpus);
+    g_defaultCaptured = sched_getaffinity(0, sizeof(g_defaultCpus), &g_defaultCpus) == 0;
+#endif
+}
+
+bool applyScheduling(const SchedulingConfig& config, const std::string& owner) {
+    bool ok = true;
+#ifdef _WIN32
+    DWORD_PTR mask = g_defaultMask;
+    if (!config.cpus.empty()) {
+        mask = 0;
+        for (int cpu : config.cpus) {
+            if (cpu >= 0 && cpu < static_cast<int>(sizeof(DWORD_PTR) * 8)) {
+                mask |= DWORD_PTR(1) << cpu;
+            }
+        }
+    }
+    if (mask != 0 && SetThreadAffinityMask(GetCurrentThread(), mask) == 0) {
+        LOG_ERROR(owner, "Failed to set CPU affinity (" + describeScheduling(config) + ")");
+        ok = false;
+    }
+    if (config.priority > 0 && !SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL)) {
+        LOG_ERROR(owner, "Failed to raise thread priority");
+        ok = false;
+    }
+#elif defined(__linux__)
+    if (!config.cpus.empty() || g_defaultCaptured) {
+        cpu_set_t cpus = g_defaultCpus;
+        if (!config.cpus.empty()) {
+            CPU_ZERO(&cpus);
+            for (int cpu : config.cpus) {
+                if (cpu >= 0 && cpu < CPU_SETSIZE) {
+                    CPU_SET(cpu, &cpus);
+                }
+            }
+        }
+        int result = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+        if (result != 0) {
+            LOG_ERROR(owner, "Failed to set CPU affinity (" + describeScheduling(config) + "): " +
+                      std::strerror(result));
+            ok = false;
+        }
+    }
+    if (config.priority > 0) {
+        sched_param param = {};
+        param.sched_priority = config.priority;
+        int result = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (result != 0) {
+            LOG_ERROR(owner, "Failed to set SCHED_FIFO priority " + std::to_string(config.priority) + ": " +
+                      std::strerror(result) + (result == EPERM ? " (needs CAP_SYS_NICE or RLIMIT_RTPRIO)" : ""));
+            ok = false;
+        }
+    } else {
+        // 线程从主线程继承了 bulkScheduling 的 SCHED_FIFO，没有设置优先级时恢复普通调度
+        int policy = SCHED_OTHER;
+        sched_param param = {};
+        if (pthread_getschedparam(pthread_self(), &policy, &param) == 0 && policy != SCHED_OTHER) {
+            param.sched_priority = 0;
+            int result = pthread_setschedparam(pthread_self(), SCHED_OTHER, &param);
+            if (result != 0) {
+                LOG_ERROR(owner, std::string("Failed to reset scheduling to SCHED_OTHER: ") + std::strerror(result));
+                ok = false;
+            }
+        }
+    }
+#else
+    if (!config.cpus.empty() || config.priority > 0) {
+        LOG_ERROR(owner, "Thread scheduling is not supported on this platform");
+        ok = false;
+    }
+#endif
+    return ok;
+}
+
+bool lockProcessMemory() {
+#ifdef _WIN32
+    LOG_ERROR("Collector", "lockMemory is not supported on Windows");
+    return false;
+#else
+    // MCL_ONFAULT：线程栈等映射在访问时才锁定，不会为每个线程的整个栈分配物理内存
+    int flags = MCL_CURRENT | MCL_FUTURE;
+#ifdef MCL_ONFAULT
+    flags |= MCL_ONFAULT;
+#endif
+    if (mlockall(flags) != 0) {
+        LOG_ERROR("Collector", std::string("mlockall failed: ") + std::strerror(errno) +
+                  " (needs CAP_IPC_LOCK or a larger RLIMIT_MEMLOCK)");
+        return false;
+    }
+    g_memoryLocked = true;
+    return true;
+#endif
+}
+
+void prefaultStack() {
+    if (!g_memoryLocked) {
+        return;
+    }
+    volatile char stack[kStackPrefaultBytes];
+    for (size_t i = 0; i < sizeof(stack); i += 4096) {
+        stack[i] = 0;
+    }
+}
+
+std::string describeScheduling(const SchedulingConfig& config) {
+    std::string text;
+    if (!config.cpus.empty()) {
+        text = "cpus ";
+        for (size_t i = 0; i < config.cpus.size(); ++i) {
+            text += (i > 0 ? "," : "") + std::to_string(config.cpus[i]);
+        }
+    }
+    if (config.priority > 0) {
+        text += (text.empty() ? "" : " ") + std::string("priority ") + std::to_string(config.priority);
+    }
+    return text.empty() ? "default" : text;
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include "Common.h"
+#include <string>
+
+// 线程的 CPU 绑定、SCHED_FIFO 优先级和进程内存锁定
+// 新线程继承创建者的设置：主线程启动时先设置 bulkScheduling，之后创建的写盘、TCP、压缩、日志等线程
+// 都运行在这些 CPU 上；串口读取线程和 Reactor 线程在线程开始时设置自己的调度
+
+// 进程启动时调用一次，记录初始的 CPU 集合，之后没有指定 cpus 的线程恢复到这个集合
+void captureDefaultAffinity();
+
+// 设置当前线程；没有指定 cpus / priority 时恢复默认 CPU 集合和 SCHED_OTHER，不沿用创建者的设置
+// 失败时以 owner 记录日志并返回 false，其余部分照常设置
+bool applyScheduling(const SchedulingConfig& config, const std::string& owner);
+
+// mlockall：已映射和之后映射的内存在首次访问后常驻，不会被换出
+bool lockProcessMemory();
+
+// 锁定内存后预先访问当前线程栈上的一段内存，读取路径不再因栈增长缺页；未锁定时不做任何事
+void prefaultStack();
+
+// 用于日志："cpus 2,3 priority 80"
+std::string describeScheduling(const SchedulingConfig& config);
@@ -1,17 +1,59 @@
 #include "SerialPort.h"
+#include <algorithm>
 #include <iostream>
 #include "Logger.h"
 
 #ifdef _WIN32
 #include <windows.h>
 #else
+#include "CustomBaud.h"
 #include <fcntl.h>
+#include <poll.h>
 #include <termios.h>
 #include <unistd.h>
+#include <sys/ioctl.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#ifdef __linux__
+#include <linux/serial.h>
+#endif
+
+namespace {
+
+// Rates with a Bxxx constant; the higher ones are not defined on every platform
+bool standardBaud(int rate, speed_t& speed) {
+    static const struct { int rate; speed_t speed; } rates[] = {
+        { 50, B50 }, { 75, B75 }, { 110, B110 }, { 134, B134 }, { 150, B150 }, { 200, B200 },
+        { 300, B300 }, { 600, B600 }, { 1200, B1200 }, { 1800, B1800 }, { 2400, B2400 },
+        { 4800, B4800 }, { 9600, B9600 }, { 19200, B19200 }, { 38400, B38400 },
+        { 57600, B57600 }, { 115200, B115200 }, { 230400, B230400 },
+#ifdef B460800
+        { 460800, B460800 }, { 500000, B500000 }, { 576000, B576000 }, { 921600, B921600 },
+        { 1000000, B1000000 }, { 1152000, B1152000 }, { 1500000, B1500000 },
+        { 2000000, B2000000 }, { 2500000, B2500000 }, { 3000000, B3000000 },
+        { 3500000, B3500000 }, { 4000000, B4000000 },
+#endif
+    };
+    for (const auto& entry : rates) {
+        if (entry.rate == rate) {
+            speed = entry.speed;
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
 #endif
 
 SerialPort::SerialPort(const PortConfig& config) 
-    : m_config(config), m_isOpen(false), m_handle(nullptr) {}
+    : m_config(config), m_isOpen(false),
+#ifdef _WIN32
+      m_handle(nullptr) {}
+#else
+      m_handle(-1), m_wakePipe{ -1, -1 } {}
+#endif
 
 SerialPort::~SerialPort() {
     if (m_isOpen) {
@@ -47,7 +89,23 @@ bool SerialPort::open() {
     dcb.ByteSize = m_config.dataBits;
     dcb.StopBits = m_config.stopBits == 1 ? ONESTOPBIT : TWOSTOPBITS;
     dcb.Parity = m_config.parity == "none" ? NOPARITY :
-                 m_config.parity == "odd" ? ODDPARITY : EVENPARITY;
+                 m_config.parity == "odd" ? ODDPARITY :
+                 m_config.parity == "mark" ? MARKPARITY :
+                 m_config.parity == "space" ? SPACEPARITY : EVENPARITY;
+    dcb.fBinary = TRUE;
+    dcb.fParity = dcb.Parity != NOPARITY;
+    dcb.fErrorChar = FALSE;
+    dcb.fNull = FALSE;
+    dcb.fAbortOnError = FALSE;
+
+    bool hardware = m_config.flowControl == "hardware";
+    bool software = m_config.flowControl == "software";
+    dcb.fOutxCtsFlow = hardware;
+    dcb.fOutxDsrFlow = FALSE;
+    dcb.fRtsControl = hardware ? RTS_CONTROL_HANDSHAKE : RTS_CONTROL_ENABLE;
+    dcb.fDtrControl = DTR_CONTROL_ENABLE;
+    dcb.fOutX = software;
+    dcb.fInX = software;
 
     if (!SetCommState(m_handle, &dcb)) {
         CloseHandle(m_handle);
@@ -55,9 +113,16 @@ bool SerialPort::open() {
     }
 
     COMMTIMEOUTS timeouts = { 0 };
-    timeouts.ReadIntervalTimeout = MAXDWORD;
-    timeouts.ReadTotalTimeoutMultiplier = 0;
-    timeouts.ReadTotalTimeoutConstant = 0;
+    if (m_config.readMode == ReadMode::Blocking) {
+        // Wait for the first byte, then return after an inter-byte gap of vtime
+        timeouts.ReadIntervalTimeout = (std::max)(m_config.vtime, 1) * 100;
+        timeouts.ReadTotalTimeoutMultiplier = 0;
+        timeouts.ReadTotalTimeoutConstant = 0;
+    } else {
+        timeouts.ReadIntervalTimeout = MAXDWORD;
+        timeouts.ReadTotalTimeoutMultiplier = 0;
+        timeouts.ReadTotalTimeoutConstant = 0;
+    }
     SetCommTimeouts(m_handle, &timeouts);
 
 #else
@@ -67,25 +132,128 @@ bool SerialPort::open() {
     }
 
     struct termios options;
-    tcgetattr(m_handle, &options);
-    
-    // Set baud rate
+    if (tcgetattr(m_handle, &options) != 0) {
+        LOG_ERROR(m_config.name, "tcgetattr failed: " + std::string(strerror(errno)));
+        ::close(m_handle);
+        m_handle = -1;
+        return false;
+    }
+
+    // Raw mode: no line editing, echo, signal characters or CR/NL translation
+    options.c_iflag &= ~(IGNBRK | BRKINT | PARMRK | ISTRIP | INLCR | IGNCR | ICRNL |
+                         IXON | IXOFF | IXANY | INPCK);
+    options.c_oflag &= ~OPOST;
+    options.c_lflag &= ~(ECHO | ECHOE | ECHONL | ICANON | ISIG | IEXTEN);
+    options.c_cflag &= ~(CSIZE | PARENB | PARODD | CMSPAR | CSTOPB | CRTSCTS);
+    options.c_cflag |= CLOCAL | CREAD;
+
+    switch (m_config.dataBits) {
+        case 5: options.c_cflag |= CS5; break;
+        case 6: options.c_cflag |= CS6; break;
+        case 7: options.c_cflag |= CS7; break;
+        case 8: options.c_cflag |= CS8; break;
+        default:
+            LOG_ERROR(m_config.name, "Unsupported data bits " + std::to_string(m_config.dataBits) + ", using 8");
+            options.c_cflag |= CS8;
+    }
+    if (m_config.stopBits == 2) {
+        options.c_cflag |= CSTOPB;
+    }
+
+    // Bytes with parity errors are read as 0 (INPCK without PARMRK/IGNPAR)
+    if (m_config.parity == "odd") {
+        options.c_cflag |= PARENB | PARODD;
+    } else if (m_config.parity == "even") {
+        options.c_cflag |= PARENB;
+    } else if (m_config.parity == "mark") {
+        options.c_cflag |= PARENB | CMSPAR | PARODD;
+    } else if (m_config.parity == "space") {
+        options.c_cflag |= PARENB | CMSPAR;
+    }
+    if (options.c_cflag & PARENB) {
+        options.c_iflag |= INPCK;
+    }
+
+    if (m_config.flowControl == "hardware") {
+        options.c_cflag |= CRTSCTS;
+    } else if (m_config.flowControl == "software") {
+        options.c_iflag |= IXON | IXOFF;
+    }
+
+    if (m_config.readMode == ReadMode::Blocking) {
+        // The driver chunks reads by VMIN/VTIME
+        options.c_cc[VMIN] = static_cast<cc_t>(std::clamp(m_config.vmin, 0, 255));
+        options.c_cc[VTIME] = static_cast<cc_t>(std::clamp(m_config.vtime, 0, 255));
+    } else {
+        options.c_cc[VMIN] = 1;
+        options.c_cc[VTIME] = 0;
+    }
+
+    // Standard rates go through cfsetspeed; anything else is set afterwards
+    // with termios2/BOTHER
     speed_t baud;
-    switch (m_config.baudRate) {
-        case 9600: baud = B9600; break;
-        case 115200: baud = B115200; break;
-        default: baud = B9600;
+    bool standard = standardBaud(m_config.baudRate, baud);
+    cfsetispeed(&options, standard ? baud : B38400);
+    cfsetospeed(&options, standard ? baud : B38400);
+
+    if (tcsetattr(m_handle, TCSANOW, &options) != 0) {
+        LOG_ERROR(m_config.name, "tcsetattr failed: " + std::string(strerror(errno)));
+        ::close(m_handle);
+        m_handle = -1;
+        return false;
     }
-    cfsetispeed(&options, baud);
-    cfsetospeed(&options, baud);
 
-    options.c_cflag |= (CLOCAL | CREAD);
-    options.c_cflag &= ~PARENB;  // No parity
-    options.c_cflag &= ~CSTOPB;  // 1 stop bit
-    options.c_cflag &= ~CSIZE;
-    options.c_cflag |= CS8;      // 8 data bits
+#ifdef __linux__
+    if (!standard && !setCustomBaudRate(m_handle, m_config.baudRate)) {
+        LOG_ERROR(m_config.name, "Baud rate " + std::to_string(m_config.baudRate) +
+                  " not supported by the driver: " + std::string(strerror(errno)));
+        ::close(m_handle);
+        m_handle = -1;
+        return false;
+    }
 
-    tcsetattr(m_handle, TCSANOW, &options);
+    // The driver may round the rate to what its divisor can reach
+    int inputBaud = 0, outputBaud = 0;
+    if (getBaudRate(m_handle, inputBaud, outputBaud) && outputBaud > 0 &&
+        std::abs(outputBaud - m_config.baudRate) * 100 > m_config.baudRate * 3) {
+        LOG_ERROR(m_config.name, "Driver set baud rate " + std::to_string(outputBaud) +
+                  " instead of " + std::to_string(m_config.baudRate));
+    }
+
+    if (m_config.lowLatency) {
+        struct serial_struct serial;
+        if (ioctl(m_handle, TIOCGSERIAL, &serial) != 0 ||
+            (serial.flags |= ASYNC_LOW_LATENCY, ioctl(m_handle, TIOCSSERIAL, &serial)) != 0) {
+            LOG_ERROR(m_config.name, "Low latency mode not supported by the driver");
+        }
+    }
+#else
+    if (!standard) {
+        LOG_ERROR(m_config.name, "Unsupported baud rate " + std::to_string(m_config.baudRate));
+        ::close(m_handle);
+        m_handle = -1;
+        return false;
+    }
+#endif
+
+    if (m_config.readMode == ReadMode::Blocking) {
+        int flags = fcntl(m_handle, F_GETFL);
+        fcntl(m_handle, F_SETFL, flags & ~O_NONBLOCK);
+
+        // n_tty samples VMIN/VTIME when read() starts, so changing termios does
+        // not end a read that is already waiting. Blocking reads wait in poll()
+        // on the port and this pipe instead
+        if (pipe(m_wakePipe) != 0) {
+            LOG_ERROR(m_config.name, "pipe failed: " + std::string(strerror(errno)));
+            ::close(m_handle);
+            m_handle = -1;
+            return false;
+        }
+        for (int fd : m_wakePipe) {
+            fcntl(fd, F_SETFD, FD_CLOEXEC);
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        }
+    }
 #endif
 
     m_isOpen = true;
@@ -105,6 +273,12 @@ bool SerialPort::close() {
         ::close(m_handle);
         m_handle = -1;
     }
+    for (int& fd : m_wakePipe) {
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
 #endif
 
     m_isOpen = false;
@@ -113,27 +287,88 @@ bool SerialPort::close() {
 
 bool SerialPort::read(std::vector<char>& buffer) {
     buffer.resize(1024);
-    DWORD bytesRead = 0;
+    size_t bytesRead = 0;
+    bool result = read(buffer.data(), buffer.size(), bytesRead);
+    buffer.resize(bytesRead);
+    return result;
+}
+
+bool SerialPort::read(char* buffer, size_t capacity, size_t& bytesRead) {
+    bytesRead = 0;
 
 #ifdef _WIN32
-    if (buffer.size() > MAXDWORD) {
+    DWORD count = 0;
+    if (capacity > MAXDWORD) {
         LOG_ERROR(m_config.name, "Buffer size exceeds DWORD maximum");
         return false;
     }
 
-    if (!ReadFile(m_handle, buffer.data(), static_cast<DWORD>(buffer.size()), &bytesRead, NULL)) {
+    if (!ReadFile(m_handle, buffer, static_cast<DWORD>(capacity), &count, NULL)) {
         DWORD error = GetLastError();
         LOG_ERROR(m_config.name, "ReadFile failed with error: " + std::to_string(error));
         return false;
     }
 #else
-    bytesRead = ::read(m_handle, buffer.data(), buffer.size());
-    if (bytesRead < 0) {
+    if (m_wakePipe[0] >= 0) {
+        // With VMIN=0 the driver would return 0 bytes after VTIME; keep that so
+        // the caller can still notice an idle line
+        int timeout = m_config.vmin == 0 && m_config.vtime > 0 ? m_config.vtime * 100 : -1;
+        pollfd fds[2] = { { m_handle, POLLIN, 0 }, { m_wakePipe[0], POLLIN, 0 } };
+        int ready = ::poll(fds, 2, timeout);
+        if (ready <= 0) {
+            return ready == 0 || errno == EINTR;
+        }
+        if (fds[1].revents & POLLIN) {
+            return true;  // Interrupted; the byte stays in the pipe so later reads return too
+        }
+    }
+    ssize_t count = ::read(m_handle, buffer, capacity);
+    if (count < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+            return true;  // No data available
+        }
         LOG_ERROR(m_config.name, "Read failed with error: " + std::string(strerror(errno)));
         return false;
     }
 #endif
 
-    buffer.resize(bytesRead);
-    return bytesRead > 0;
-} 
\ No newline at end of file
+    // Zero bytes with a true result means no data was available
+    bytesRead = static_cast<size_t>(count);
+    return true;
+}
+
+void SerialPort::interruptRead() {
+    if (!m_isOpen) return;
+
+#ifdef _WIN32
+    CancelIoEx(m_handle, NULL);
+#else
+    // A read() already past poll() still finishes by VMIN/VTIME; with VTIME=0
+    // and VMIN>1 that means waiting for the remaining bytes
+    if (m_wakePipe[1] >= 0) {
+        char byte = 1;
+        ssize_t ignored = ::write(m_wakePipe[1], &byte, 1);
+        (void)ignored;
+    }
+#endif
+}
+
+size_t SerialPort::pendingInput() const {
+    if (!m_isOpen) return 0;
+
+#ifdef _WIN32
+    COMSTAT status = {};
+    DWORD errors = 0;
+    return ClearCommError(m_handle, &errors, &status) ? status.cbInQue : 0;
+#else
+    int count = 0;
+    return ioctl(m_handle, FIONREAD, &count) == 0 && count > 0 ? static_cast<size_t>(count) : 0;
+#endif
+}
+
+double SerialPort::wireTimeUs(size_t bytes) const {
+    if (m_config.baudRate <= 0) return 0.0;
+    int bitsPerChar = 1 + m_config.dataBits + m_config.stopBits +
+                      (m_config.parity == "none" ? 0 : 1);
+    return static_cast<double>(bytes) * bitsPerChar * 1e6 / m_config.baudRate;
+}
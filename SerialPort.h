@@ -3,17 +3,60 @@
 #include <string>
 #include <vector>
 
+// 串口读取策略
+enum class ReadMode {
+    Event,     // 共享 epoll 事件循环（默认）
+    Blocking,  // 独立线程阻塞读取，按 VMIN/VTIME 分块
+    Poll,      // 独立线程 poll() 等待，带超时
+    Legacy     // 旧版轮询：读取后固定休眠
+};
+
 struct PortConfig {
     std::string name;
     int baudRate;
     int dataBits;
     int stopBits;
-    std::string parity;
+    std::string parity;       // none / odd / even / mark / space
+    std::string flowControl;  // none / hardware (RTS/CTS) / software (XON/XOFF)
+    bool lowLatency;          // Linux：设置 ASYNC_LOW_LATENCY，减少 USB 转串口等驱动的缓冲延迟
     bool addTimestamp;
+    TimestampPrecision timestampPrecision;  // 文本格式时间戳前缀的精度
     int timeout;
+    int writeBufferSize;  // 数据文件写缓冲块大小（字节）
+    int flushInterval;    // 数据文件最长刷新间隔（毫秒）
+    int queueCapacity;    // 写盘、TCP 转发队列容量（数据块数）
+    int memoryBudgetKB;   // 本串口数据块内存上限，0 为只受全局预算限制
+    MemoryPolicy memoryPolicy;
+    FileFormat fileFormat;
+    int maxFileMB;           // 单个数据文件分段的大小上限，超出后切换到同一天的下一个分段，0 为不限
+    Codec compression;       // 已关闭分段的压缩算法
+    int compressionLevel;    // 0 为算法默认级别
+    int compressionBlockKB;  // 每个可独立解压的压缩块对应的原始数据大小
+    ReadMode readMode;
+    int vmin;         // Blocking 模式：最少读取字节数 (0-255)
+    int vtime;        // Blocking 模式：字节间超时，单位 0.1 秒 (0-255)
+    int pollTimeout;  // Poll 模式：poll() 超时毫秒数
+    FramingConfig framing;
     TcpConfig tcpForward;
+    SharedMemoryConfig sharedMemory;
+    SchedulingConfig scheduling;  // 设置后使用独立读取线程，不与其他串口共用 Reactor
 };
 
+// 热加载时据此判断串口是否需要重新配置；新增字段时需要同时加到这里
+inline bool operator==(const PortConfig& a, const PortConfig& b) {
+    return std::tie(a.name, a.baudRate, a.dataBits, a.stopBits, a.parity, a.flowControl,
+                    a.lowLatency, a.addTimestamp, a.timestampPrecision, a.timeout,
+                    a.writeBufferSize, a.flushInterval, a.queueCapacity, a.memoryBudgetKB,
+                    a.memoryPolicy, a.fileFormat, a.maxFileMB, a.compression, a.compressionLevel, a.compressionBlockKB, a.readMode, a.vmin,
+                    a.vtime, a.pollTimeout, a.framing, a.tcpForward, a.sharedMemory, a.scheduling) ==
+           std::tie(b.name, b.baudRate, b.dataBits, b.stopBits, b.parity, b.flowControl,
+                    b.lowLatency, b.addTimestamp, b.timestampPrecision, b.timeout,
+                    b.writeBufferSize, b.flushInterval, b.queueCapacity, b.memoryBudgetKB,
+                    b.memoryPolicy, b.fileFormat, b.maxFileMB, b.compression, b.compressionLevel, b.compressionBlockKB, b.readMode, b.vmin,
+                    b.vtime, b.pollTimeout, b.framing, b.tcpForward, b.sharedMemory, b.scheduling);
+}
+inline bool operator!=(const PortConfig& a, const PortConfig& b) { return !(a == b); }
+
 class SerialPort {
 public:
     SerialPort(const PortConfig& config);
@@ -22,8 +65,15 @@ public:
     bool open();
     bool close();
     bool read(std::vector<char>& buffer);
+    bool read(char* buffer, size_t capacity, size_t& bytesRead);  // 直接读入调用方的缓冲区
+    void interruptRead();  // 唤醒阻塞中的 read()
+    double wireTimeUs(size_t bytes) const;  // 传输指定字节数所需的线路时间
     bool isOpen() const { return m_isOpen; }
+    size_t pendingInput() const;  // 驱动接收缓冲区中尚未读取的字节数
     const PortConfig& getConfig() const { return m_config; }
+#ifndef _WIN32
+    int getFd() const { return m_handle; }
+#endif
 
 private:
     PortConfig m_config;
@@ -32,5 +82,6 @@ private:
     void* m_handle;  // HANDLE for Windows
 #else
     int m_handle;    // File descriptor for Linux
+    int m_wakePipe[2];  // Blocking 模式：interruptRead() 写入一个字节唤醒等待中的 read()
 #endif
 }; 
\ No newline at end of file
@@ -0,0 +1,256 @@
+// SerialPort 串口参数测试：用 openpty 创建虚拟串口，经 SerialPort 打开从端后用 tcgetattr / TCGETS2 读回设置，
+// 检查波特率（包括 921600、3000000 和需要 BOTHER 的非标准速率）、数据位、校验、停止位、流控、
+// 原始模式标志和 VMIN/VTIME，以及 interruptRead() 能结束阻塞中的读取
+// 用法: SerialPortTest，任何一项不符时返回 1
+#include "CustomBaud.h"
+#include "SerialPort.h"
+#include <pty.h>
+#include <signal.h>
+#include <termios.h>
+#include <unistd.h>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// <asm/termbits.h> 中的 BOTHER（x86、ARM 等），该头文件不能与 <termios.h> 同时包含，见 CustomBaud.h
+constexpr tcflag_t kBother = 0010000;
+
+int g_failures = 0;
+
+void check(bool ok, const std::string& name, const std::string& what) {
+    if (!ok) {
+        std::cerr << "FAIL " << name << ": " << what << std::endl;
+        ++g_failures;
+    }
+}
+
+// Linux 6.0 起 pty 忽略数据位和 PARENB（总是 CS8、无校验），这两项只能在保留它们的内核上检查
+bool ptyKeepsFraming() {
+    int master = -1;
+    int slave = -1;
+    if (openpty(&master, &slave, nullptr, nullptr, nullptr) != 0) {
+        return false;
+    }
+    termios options;
+    tcgetattr(slave, &options);
+    options.c_cflag = (options.c_cflag & ~CSIZE) | CS7 | PARENB;
+    tcsetattr(slave, TCSANOW, &options);
+    tcgetattr(slave, &options);
+    ::close(slave);
+    ::close(master);
+    return (options.c_cflag & CSIZE) == CS7 && (options.c_cflag & PARENB) != 0;
+}
+
+PortConfig makeConfig(const std::string& device) {
+    PortConfig config{};
+    config.name = device;
+    config.baudRate = 115200;
+    config.dataBits = 8;
+    config.stopBits = 1;
+    config.parity = "none";
+    config.flowControl = "none";
+    config.readMode = ReadMode::Event;
+    return config;
+}
+
+struct Case {
+    int baudRate;
+    int dataBits;
+    int stopBits;
+    const char* parity;
+    const char* flowControl;
+    ReadMode readMode;
+    int vmin;
+    int vtime;
+};
+
+const Case kCases[] = {
+    { 9600, 8, 1, "none", "none", ReadMode::Event, 0, 0 },
+    { 115200, 7, 2, "even", "hardware", ReadMode::Poll, 0, 0 },
+    { 921600, 8, 1, "odd", "software", ReadMode::Blocking, 64, 2 },
+    { 3000000, 6, 1, "mark", "none", ReadMode::Blocking, 0, 5 },
+    { 250000, 5, 2, "space", "none", ReadMode::Event, 0, 0 },   // 非标准速率，经 BOTHER 设置
+    { 1234567, 8, 1, "none", "hardware", ReadMode::Legacy, 0, 0 },
+};
+
+std::string describe(const Case& c) {
+    return std::to_string(c.baudRate) + " " + std::to_string(c.dataBits) + c.parity[0] +
+           std::to_string(c.stopBits) + " " + c.flowControl;
+}
+
+void testCase(const Case& c, bool framing) {
+    std::string name = describe(c);
+    int master = -1;
+    int slave = -1;
+    char device[64];
+    if (openpty(&master, &slave, device, nullptr, nullptr) != 0) {
+        check(false, name, std::string("openpty failed: ") + std::strerror(errno));
+        return;
+    }
+
+    PortConfig config = makeConfig(device);
+    config.baudRate = c.baudRate;
+    config.dataBits = c.dataBits;
+    config.stopBits = c.stopBits;
+    config.parity = c.parity;
+    config.flowControl = c.flowControl;
+    config.readMode = c.readMode;
+    config.vmin = c.vmin;
+    config.vtime = c.vtime;
+    SerialPort port(config);
+    if (!port.open()) {
+        check(false, name, "open failed");
+        ::close(slave);
+        ::close(master);
+        return;
+    }
+
+    termios options;
+    check(tcgetattr(port.getFd(), &options) == 0, name, "tcgetattr failed");
+
+    static const tcflag_t kSizes[] = { CS5, CS6, CS7, CS8 };
+    check(!framing || (options.c_cflag & CSIZE) == kSizes[c.dataBits - 5], name, "CSIZE");
+    check(((options.c_cflag & CSTOPB) != 0) == (c.stopBits == 2), name, "CSTOPB");
+
+    std::string parity = c.parity;
+    bool parenb = parity != "none";
+    bool parodd = parity == "odd" || parity == "mark";
+    bool cmspar = parity == "mark" || parity == "space";
+    check(!framing || ((options.c_cflag & PARENB) != 0) == parenb, name, "PARENB");
+    check(((options.c_cflag & PARODD) != 0) == parodd, name, "PARODD");
+    check(((options.c_cflag & CMSPAR) != 0) == cmspar, name, "CMSPAR");
+    check(((options.c_iflag & INPCK) != 0) == parenb, name, "INPCK");
+
+    std::string flow = c.flowControl;
+    check(((options.c_cflag & CRTSCTS) != 0) == (flow == "hardware"), name, "CRTSCTS");
+    check(((options.c_iflag & IXON) != 0) == (flow == "software"), name, "IXON");
+    check(((options.c_iflag & IXOFF) != 0) == (flow == "software"), name, "IXOFF");
+    check((options.c_iflag & IXANY) == 0, name, "IXANY");
+
+    // 原始模式
+    check((options.c_cflag & (CLOCAL | CREAD)) == (CLOCAL | CREAD), name, "CLOCAL | CREAD");
+    check((options.c_lflag & (ICANON | ECHO | ECHOE | ECHONL | ISIG | IEXTEN)) == 0, name, "c_lflag not raw");
+    check((options.c_iflag & (IGNBRK | BRKINT | PARMRK | ISTRIP | INLCR | IGNCR | ICRNL)) == 0, name,
+          "c_iflag not raw");
+    check((options.c_oflag & OPOST) == 0, name, "OPOST");
+
+    cc_t vmin = c.readMode == ReadMode::Blocking ? static_cast<cc_t>(c.vmin) : 1;
+    cc_t vtime = c.readMode == ReadMode::Blocking ? static_cast<cc_t>(c.vtime) : 0;
+    check(options.c_cc[VMIN] == vmin, name, "VMIN " + std::to_string(options.c_cc[VMIN]));
+    check(options.c_cc[VTIME] == vtime, name, "VTIME " + std::to_string(options.c_cc[VTIME]));
+
+    bool custom = c.baudRate == 250000 || c.baudRate == 1234567;
+    check(((options.c_cflag & CBAUD) == kBother) == custom, name, "BOTHER");
+    int inputBaud = 0;
+    int outputBaud = 0;
+    check(getBaudRate(port.getFd(), inputBaud, outputBaud), name, "TCGETS2 failed");
+    check(inputBaud == c.baudRate && outputBaud == c.baudRate, name,
+          "speed " + std::to_string(inputBaud) + "/" + std::to_string(outputBaud));
+
+    // 数据原样读出（没有 CR/NL 转换）
+    const char sent[] = "a\rb\nc\x03";
+    check(::write(master, sent, sizeof(sent) - 1) == static_cast<ssize_t>(sizeof(sent) - 1), name, "write");
+    std::string received;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (received.size() < sizeof(sent) - 1 && std::chrono::steady_clock::now() < deadline) {
+        char buffer[64];
+        size_t count = 0;
+        if (!port.read(buffer, sizeof(buffer), count)) {
+            break;
+        }
+        received.append(buffer, count);
+        if (count == 0) {
+            usleep(1000);
+        }
+    }
+    check(received == std::string(sent, sizeof(sent) - 1), name, "data changed in transit");
+
+    port.close();
+    ::close(slave);
+    ::close(master);
+}
+
+// 没有数据时阻塞读取，interruptRead() 后应在很短时间内返回
+void testInterrupt() {
+    const std::string name = "interruptRead";
+    int master = -1;
+    int slave = -1;
+    char device[64];
+    if (openpty(&master, &slave, device, nullptr, nullptr) != 0) {
+        check(false, name, std::string("openpty failed: ") + std::strerror(errno));
+        return;
+    }
+    PortConfig config = makeConfig(device);
+    config.readMode = ReadMode::Blocking;
+    config.vmin = 1;
+    config.vtime = 0;
+    SerialPort port(config);
+    if (!port.open()) {
+        check(false, name, "open failed");
+        ::close(slave);
+        ::close(master);
+        return;
+    }
+
+    auto reader = std::async(std::launch::async, [&port] {
+        char buffer[64];
+        size_t count = 0;
+        bool ok = port.read(buffer, sizeof(buffer), count);
+        return ok && count == 0;
+    });
+    check(reader.wait_for(std::chrono::milliseconds(200)) == std::future_status::timeout, name,
+          "read returned without data");
+    auto start = std::chrono::steady_clock::now();
+    port.interruptRead();
+    if (reader.wait_for(std::chrono::seconds(2)) != std::future_status::ready) {
+        // 读取线程无法结束，不能正常析构
+        std::cerr << "FAIL " << name << ": read still blocked 2 s after interruptRead()" << std::endl;
+        std::_Exit(1);
+    }
+    check(reader.get(), name, "interrupted read should return true with 0 bytes");
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    check(elapsed.count() < 100, name, "took " + std::to_string(elapsed.count()) + " ms");
+
+    port.close();
+    ::close(slave);
+    ::close(master);
+}
+
+} // namespace
+
+void onTimeout(int) {
+    const char message[] = "FAIL timed out, a read did not return\n";
+    ssize_t ignored = ::write(STDERR_FILENO, message, sizeof(message) - 1);
+    (void)ignored;
+    std::_Exit(1);
+}
+
+int main() {
+    // 读取卡住时不能让测试一直挂着
+    signal(SIGALRM, onTimeout);
+    alarm(30);
+
+    bool framing = ptyKeepsFraming();
+    if (!framing) {
+        std::cout << "pty ignores CSIZE and PARENB on this kernel, not checking them" << std::endl;
+    }
+    for (const Case& c : kCases) {
+        testCase(c, framing);
+    }
+    testInterrupt();
+
+    size_t total = sizeof(kCases) / sizeof(kCases[0]) + 1;
+    if (g_failures > 0) {
+        std::cerr << g_failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All " << total << " serial port cases passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,203 @@
+// 共享内存环形缓冲区的示例读取程序，演示 ShmReader 的用法
+// 用法: ShmCat [--raw | --hex | --stats] [--spin 微秒] <名称>
+//   名称为串口配置的 sharedMemory.name，默认 "serial.<串口名>"（Linux 上在 /dev/shm 下）
+//   默认每条记录输出一行 "[时间戳] 数据"，--raw 只输出原始数据，--hex 输出十六进制；
+//   --stats 每秒输出记录数、吞吐、被覆盖跳过的记录数和从读取到收到的延迟分布。
+//   读取太慢跳过记录时在时间戳后标记 (lost N)；采集器改变环的大小重建共享内存后自动重新打开
+#include "Common.h"
+#include "Metrics.h"
+#include "Record.h"
+#include "ShmReader.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace {
+
+enum class OutputMode { Text, Raw, Hex, Stats };
+
+void usage() {
+    std::cerr << "Usage: ShmCat [--raw | --hex | --stats] [--spin US] <name>\n"
+              << "  name is the port's sharedMemory.name, by default \"serial.<port>\"\n"
+              << "  --spin US  busy-wait up to US microseconds for new data before sleeping" << std::endl;
+}
+
+uint64_t nowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+// "[2024-01-18 12:34:56.123456789] "
+void appendTime(uint64_t timestampNs, std::string& out) {
+    time_t seconds = static_cast<time_t>(timestampNs / 1000000000ull);
+    struct tm timeinfo;
+    localtime_s(&timeinfo, &seconds);
+    char text[64];
+    size_t length = std::strftime(text, sizeof(text), "[%Y-%m-%d %H:%M:%S", &timeinfo);
+    length += std::snprintf(text + length, sizeof(text) - length, ".%09llu] ",
+                            static_cast<unsigned long long>(timestampNs % 1000000000ull));
+    out.append(text, length);
+}
+
+// 先格式化到 out，再由调用方用 valid() 确认数据在此期间没有被覆盖
+void formatRecord(const ShmReader::Record& record, OutputMode mode, std::string& out) {
+    if (mode == OutputMode::Raw) {
+        out.append(record.data, record.size);
+        return;
+    }
+    appendTime(record.timestampNs, out);
+    if (record.lost > 0) {
+        out += "(lost " + std::to_string(record.lost) + ") ";
+    }
+    if (mode == OutputMode::Text) {
+        out.append(record.data, record.size);
+        if (record.size == 0 || record.data[record.size - 1] != '\n') {
+            out += '\n';
+        }
+        return;
+    }
+
+    char line[96];
+    std::snprintf(line, sizeof(line), "%u bytes\n", record.size);
+    out += line;
+    for (uint32_t offset = 0; offset < record.size; offset += 16) {
+        size_t length = static_cast<size_t>(std::snprintf(line, sizeof(line), "  %08x ", offset));
+        for (uint32_t i = offset; i < offset + 16; ++i) {
+            length += i < record.size
+                ? static_cast<size_t>(std::snprintf(line + length, sizeof(line) - length, " %02x",
+                                                    static_cast<unsigned char>(record.data[i])))
+                : static_cast<size_t>(std::snprintf(line + length, sizeof(line) - length, "   "));
+        }
+        out.append(line, length);
+        out += "  ";
+        for (uint32_t i = offset; i < offset + 16 && i < record.size; ++i) {
+            unsigned char c = static_cast<unsigned char>(record.data[i]);
+            out += c >= 0x20 && c < 0x7f ? static_cast<char>(c) : '.';
+        }
+        out += '\n';
+    }
+}
+
+struct Stats {
+    uint64_t records = 0;
+    uint64_t bytes = 0;
+    uint64_t lost = 0;
+    Histogram latency;
+};
+
+void printStats(const Stats& stats, uint64_t overruns, double seconds) {
+    std::printf("%10.0f rec/s %9.3f MB/s  lost %llu  overruns %llu  latency us p50 %.1f p99 %.1f p99.9 %.1f\n",
+                static_cast<double>(stats.records) / seconds,
+                static_cast<double>(stats.bytes) / seconds / (1024.0 * 1024.0),
+                static_cast<unsigned long long>(stats.lost), static_cast<unsigned long long>(overruns),
+                stats.latency.percentileNs(0.5) / 1000.0, stats.latency.percentileNs(0.99) / 1000.0,
+                stats.latency.percentileNs(0.999) / 1000.0);
+    std::fflush(stdout);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string name;
+    OutputMode mode = OutputMode::Text;
+    int spinUs = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--raw") {
+            mode = OutputMode::Raw;
+        } else if (arg == "--hex") {
+            mode = OutputMode::Hex;
+        } else if (arg == "--stats") {
+            mode = OutputMode::Stats;
+        } else if (arg == "--spin" && i + 1 < argc) {
+            spinUs = std::atoi(argv[++i]);
+        } else if (!arg.empty() && arg[0] != '-' && name.empty()) {
+            name = arg;
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (name.empty()) {
+        usage();
+        return 2;
+    }
+
+    ShmReader reader;
+    if (!reader.open(name)) {
+        std::cerr << reader.error() << std::endl;
+        return 1;
+    }
+    std::cerr << "Reading " << reader.port() << " (" << reader.dataSize() / 1024 << " KB ring)" << std::endl;
+
+    std::unique_ptr<Stats> stats(new Stats());
+    uint64_t overrunsBefore = 0;
+    auto statsStart = std::chrono::steady_clock::now();
+    auto lastCheck = statsStart;
+    uint64_t discarded = 0;  // 格式化期间被覆盖而作废的记录，计入下一条输出的 lost
+    std::string out;
+    ShmReader::Record record;
+    for (uint64_t count = 0;; ++count) {
+        if (!reader.isOpen()) {
+            // 重建期间可能暂时打不开
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+            if (reader.open(name)) {
+                std::cerr << "Reopened " << name << std::endl;
+                overrunsBefore = 0;
+            }
+            continue;
+        }
+        bool got = reader.next(record);
+        if (mode == OutputMode::Stats && (!got || count % 1024 == 0)) {
+            auto now = std::chrono::steady_clock::now();
+            if (now - statsStart >= std::chrono::seconds(1)) {
+                printStats(*stats, reader.overruns() - overrunsBefore,
+                           std::chrono::duration<double>(now - statsStart).count());
+                stats.reset(new Stats());
+                overrunsBefore = reader.overruns();
+                statsStart = now;
+            }
+        }
+        if (!got) {
+            std::fflush(stdout);
+            // 采集器重建了共享内存（sizeKB 变化）时重新打开
+            auto now = std::chrono::steady_clock::now();
+            if (now - lastCheck >= std::chrono::seconds(1)) {
+                lastCheck = now;
+                if (!reader.writerAlive() && reader.replaced()) {
+                    reader.close();
+                    continue;
+                }
+            }
+            reader.wait(100, spinUs);
+            continue;
+        }
+
+        if (mode == OutputMode::Stats) {
+            // 只用到记录头，next() 已经确认过
+            ++stats->records;
+            stats->bytes += record.size;
+            stats->lost += record.lost;
+            uint64_t now = nowNs();
+            stats->latency.record(now > record.timestampNs ? now - record.timestampNs : 0);
+            continue;
+        }
+
+        out.clear();
+        record.lost += discarded;
+        formatRecord(record, mode, out);
+        if (!reader.valid(record)) {
+            ++discarded;
+            continue;
+        }
+        discarded = 0;
+        std::fwrite(out.data(), 1, out.size(), stdout);
+    }
+}
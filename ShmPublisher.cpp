@@ -0,0 +1,202 @@
+#include "ShmPublisher.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <climits>
+#endif
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+namespace {
+
+#ifndef _WIN32
+std::string shmPath(const std::string& name) {
+    return name.empty() || name[0] != '/' ? "/" + name : name;
+}
+
+void wakeAll(std::atomic<uint32_t>& word) {
+#ifdef __linux__
+    // 共享映射上的 futex，不能用 FUTEX_PRIVATE_FLAG
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#else
+    (void)word;
+#endif
+}
+#endif
+
+} // namespace
+
+ShmPublisher::ShmPublisher()
+    : m_header(nullptr), m_data(nullptr), m_mapSize(0), m_mask(0), m_position(0), m_sequence(0),
+      m_reserveFloor(0) {}
+
+ShmPublisher::~ShmPublisher() {
+    close();
+}
+
+std::string ShmPublisher::defaultName(const std::string& port) {
+    return "serial." + std::filesystem::path(port).filename().string();
+}
+
+bool ShmPublisher::open(const std::string& name, size_t dataSize, const std::string& port) {
+    m_port = port;
+#ifdef _WIN32
+    (void)name;
+    (void)dataSize;
+    LOG_ERROR(port, "sharedMemory is not supported on Windows");
+    return false;
+#else
+    size_t size = 4096;
+    while (size < dataSize) {
+        size <<= 1;
+    }
+    std::string path = shmPath(name);
+    size_t mapSize = kShmHeaderSize + size;
+
+    int fd = shm_open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0660);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        LOG_ERROR(port, "Failed to open shared memory " + path + ": " + std::strerror(errno));
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        return false;
+    }
+
+    // 已有同样大小的环时接着写入，读取方保持映射
+    void* map = MAP_FAILED;
+    bool reuse = false;
+    if (static_cast<size_t>(st.st_size) == mapSize) {
+        map = mmap(nullptr, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        auto* header = static_cast<ShmRingHeader*>(map);
+        reuse = map != MAP_FAILED && std::memcmp(header->magic, kShmMagic, sizeof(kShmMagic)) == 0 &&
+                header->version == kShmVersion && header->headerSize == kShmHeaderSize &&
+                header->dataSize == size;
+        if (reuse) {
+            pid_t owner = static_cast<pid_t>(header->writerPid.load());
+            if (owner != 0 && owner != getpid() && (kill(owner, 0) == 0 || errno == EPERM)) {
+                LOG_ERROR(port, "Shared memory " + path + " is in use by process " + std::to_string(owner));
+                munmap(map, mapSize);
+                ::close(fd);
+                return false;
+            }
+        } else if (map != MAP_FAILED) {
+            munmap(map, mapSize);
+            map = MAP_FAILED;
+        }
+    }
+    if (!reuse && st.st_size != 0) {
+        // 大小或格式不同：删除后重建，旧的读取方继续持有原来的映射
+        ::close(fd);
+        shm_unlink(path.c_str());
+        fd = shm_open(path.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0660);
+    }
+    if (!reuse) {
+        if (fd < 0 || ftruncate(fd, static_cast<off_t>(mapSize)) != 0 ||
+            (map = mmap(nullptr, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)) == MAP_FAILED) {
+            LOG_ERROR(port, "Failed to create shared memory " + path + ": " + std::strerror(errno));
+            if (fd >= 0) {
+                ::close(fd);
+            }
+            return false;
+        }
+        // 新建的共享内存全部为 0；magic 最后写入，读取方看到 magic 时其他字段已经有效
+        auto* header = static_cast<ShmRingHeader*>(map);
+        header->version = kShmVersion;
+        header->headerSize = kShmHeaderSize;
+        header->dataSize = size;
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(header->magic, kShmMagic, sizeof(kShmMagic));
+    }
+    ::close(fd);
+
+    m_header = static_cast<ShmRingHeader*>(map);
+    m_data = static_cast<char*>(map) + kShmHeaderSize;
+    m_mapSize = mapSize;
+    m_mask = size - 1;
+    m_position = m_header->publish.load();
+    m_sequence = m_header->nextSequence.load();
+    m_reserveFloor = m_header->reserve.load();
+    std::memset(m_header->port, 0, kShmPortNameSize);
+    std::strncpy(m_header->port, port.c_str(), kShmPortNameSize - 1);
+    m_header->writerPid.store(static_cast<uint32_t>(getpid()));
+    return true;
+#endif
+}
+
+void ShmPublisher::close() {
+    if (!m_header) {
+        return;
+    }
+#ifndef _WIN32
+    m_header->writerPid.store(0);
+    m_header->notify.fetch_add(1);
+    wakeAll(m_header->notify);
+    munmap(m_header, m_mapSize);
+#endif
+    m_header = nullptr;
+    m_data = nullptr;
+}
+
+void ShmPublisher::publish(const char* data, size_t size, std::chrono::system_clock::time_point time,
+                           uint16_t flags) {
+    if (!m_header) {
+        return;
+    }
+#ifndef _WIN32
+    uint64_t dataSize = m_mask + 1;
+    uint64_t record = shmRecordSize(static_cast<uint32_t>(size));
+    if (record > dataSize / 2) {
+        return;  // open() 时按数据块大小保证了数据区足够大
+    }
+
+    // 放不下时跳到数据区开头，剩余部分放得下记录头时写一个填充记录
+    uint64_t offset = m_position & m_mask;
+    uint64_t skip = offset + record > dataSize ? dataSize - offset : 0;
+    uint64_t start = m_position + skip;
+    uint64_t end = start + record;
+
+    // 先推进 reserve 再覆盖数据，读取方据此判断读到的数据是否有效
+    m_header->reserve.store(std::max(end, m_reserveFloor), std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    if (skip >= kShmRecordHeaderSize) {
+        ShmRecordHeader padding = { kShmPadding, 0, 0, m_sequence, 0 };
+        std::memcpy(m_data + offset, &padding, sizeof(padding));
+    }
+    ShmRecordHeader header = {
+        static_cast<uint32_t>(size), flags, 0, m_sequence,
+        static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            time.time_since_epoch()).count())
+    };
+    char* out = m_data + (start & m_mask);
+    std::memcpy(out, &header, sizeof(header));
+    std::memcpy(out + kShmRecordHeaderSize, data, size);
+
+    m_position = end;
+    ++m_sequence;
+    m_header->nextSequence.store(m_sequence, std::memory_order_relaxed);
+    // 与读取方登记等待后再检查 publish 的顺序配对（均为 seq_cst），不会漏掉唤醒
+    m_header->publish.store(end);
+    if (m_header->waiters.load() > 0) {
+        m_header->notify.fetch_add(1);
+        wakeAll(m_header->notify);
+    }
+#else
+    (void)data;
+    (void)size;
+    (void)time;
+    (void)flags;
+#endif
+}
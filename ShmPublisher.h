@@ -0,0 +1,39 @@
+#pragma once
+#include "ShmRing.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// 单个串口的共享内存发布（格式见 ShmRing.h），publish() 只在该串口的读取线程中调用
+// 同名的共享内存已存在且大小相同时接着使用，位置和序号延续，读取方不需要重新打开；
+// 大小不同时删除后重建，已打开的读取方看到写入方关闭后需要重新打开
+class ShmPublisher {
+public:
+    ShmPublisher();
+    ~ShmPublisher();
+
+    ShmPublisher(const ShmPublisher&) = delete;
+    ShmPublisher& operator=(const ShmPublisher&) = delete;
+
+    // dataSize 向上取 2 的幂；失败时以 port 记录日志
+    bool open(const std::string& name, size_t dataSize, const std::string& port);
+    // 标记写入方已关闭并唤醒等待的读取方；共享内存保留，读取方可以读完剩余的记录
+    void close();
+    bool isOpen() const { return m_header != nullptr; }
+
+    // 不等待读取方，数据区满时覆盖最旧的记录
+    void publish(const char* data, size_t size, std::chrono::system_clock::time_point time, uint16_t flags);
+
+    static std::string defaultName(const std::string& port);  // "serial.<串口名>"
+
+private:
+    ShmRingHeader* m_header;
+    char* m_data;
+    size_t m_mapSize;
+    uint64_t m_mask;
+    uint64_t m_position;      // 下一条记录的位置
+    uint64_t m_sequence;      // 下一条记录的序号
+    uint64_t m_reserveFloor;  // 上一个写入方中途退出时已推进的 reserve，不能回退
+    std::string m_port;
+};
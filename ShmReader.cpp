@@ -0,0 +1,229 @@
+#include "ShmReader.h"
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#endif
+
+namespace {
+
+std::string shmPath(const std::string& name) {
+    return name.empty() || name[0] != '/' ? "/" + name : name;
+}
+
+// 只读映射时无法登记等待，按这个间隔检查
+constexpr auto kReadOnlyPollInterval = std::chrono::microseconds(200);
+
+} // namespace
+
+ShmReader::ShmReader()
+    : m_header(nullptr), m_data(nullptr), m_mapSize(0), m_mask(0), m_writable(false), m_device(0),
+      m_inode(0), m_position(0), m_expected(0), m_hasExpected(false), m_overruns(0), m_lost(0) {}
+
+ShmReader::~ShmReader() {
+    close();
+}
+
+bool ShmReader::open(const std::string& name) {
+    close();
+    m_name = shmPath(name);
+    m_writable = true;
+    int fd = shm_open(m_name.c_str(), O_RDWR | O_CLOEXEC, 0);
+    if (fd < 0 && errno == EACCES) {
+        m_writable = false;
+        fd = shm_open(m_name.c_str(), O_RDONLY | O_CLOEXEC, 0);
+    }
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        m_error = m_name + ": " + std::strerror(errno);
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        return false;
+    }
+    if (static_cast<size_t>(st.st_size) < kShmHeaderSize) {
+        m_error = m_name + ": not initialized yet";
+        ::close(fd);
+        return false;
+    }
+
+    m_mapSize = static_cast<size_t>(st.st_size);
+    int protection = m_writable ? PROT_READ | PROT_WRITE : PROT_READ;
+    void* map = mmap(nullptr, m_mapSize, protection, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        m_error = m_name + ": mmap failed: " + std::strerror(errno);
+        return false;
+    }
+    auto* header = static_cast<ShmRingHeader*>(map);
+    if (std::memcmp(header->magic, kShmMagic, sizeof(kShmMagic)) != 0 || header->version != kShmVersion ||
+        header->headerSize != kShmHeaderSize || header->dataSize == 0 ||
+        (header->dataSize & (header->dataSize - 1)) != 0 || kShmHeaderSize + header->dataSize != m_mapSize) {
+        m_error = m_name + ": not a serial data ring or unsupported version";
+        munmap(map, m_mapSize);
+        return false;
+    }
+
+    m_header = header;
+    m_data = static_cast<const char*>(map) + kShmHeaderSize;
+    m_mask = header->dataSize - 1;
+    m_device = static_cast<uint64_t>(st.st_dev);
+    m_inode = static_cast<uint64_t>(st.st_ino);
+    m_position = m_header->publish.load(std::memory_order_acquire);
+    m_hasExpected = false;
+    m_overruns = 0;
+    m_lost = 0;
+    m_error.clear();
+    return true;
+}
+
+void ShmReader::close() {
+    if (m_header) {
+        munmap(m_header, m_mapSize);
+        m_header = nullptr;
+        m_data = nullptr;
+    }
+}
+
+std::string ShmReader::port() const {
+    if (!m_header) {
+        return std::string();
+    }
+    return std::string(m_header->port, strnlen(m_header->port, kShmPortNameSize));
+}
+
+bool ShmReader::next(Record& record) {
+    const uint64_t dataSize = m_mask + 1;
+    for (;;) {
+        uint64_t publish = m_header->publish.load(std::memory_order_acquire);
+        if (m_position == publish) {
+            return false;
+        }
+        if (publish < m_position || publish - m_position > dataSize) {
+            overrun(publish);
+            continue;
+        }
+
+        uint64_t offset = m_position & m_mask;
+        uint64_t left = dataSize - offset;
+        if (left < kShmRecordHeaderSize) {
+            m_position += left;
+            continue;
+        }
+        ShmRecordHeader header;
+        std::memcpy(&header, m_data + offset, sizeof(header));
+        // 读完记录头再检查 reserve：写入方在覆盖之前推进 reserve
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m_header->reserve.load(std::memory_order_relaxed) > m_position + dataSize) {
+            overrun(publish);
+            continue;
+        }
+        if (header.length == kShmPadding) {
+            m_position += left;
+            continue;
+        }
+        uint64_t size = shmRecordSize(header.length);
+        if (size > left) {
+            overrun(publish);  // 不会发生，除非写入方不是采集器
+            continue;
+        }
+
+        record.position = m_position;
+        record.sequence = header.sequence;
+        record.lost = m_hasExpected && header.sequence > m_expected ? header.sequence - m_expected : 0;
+        record.timestampNs = header.timestampNs;
+        record.flags = header.flags;
+        record.size = header.length;
+        record.data = m_data + offset + kShmRecordHeaderSize;
+        m_lost += record.lost;
+        m_expected = header.sequence + 1;
+        m_hasExpected = true;
+        m_position += size;
+        return true;
+    }
+}
+
+bool ShmReader::valid(const Record& record) const {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return m_header->reserve.load(std::memory_order_relaxed) <= record.position + m_mask + 1;
+}
+
+void ShmReader::overrun(uint64_t publish) {
+    // 被覆盖后找不到记录边界，从最新位置继续；跳过的记录数在下一条记录的序号中体现
+    ++m_overruns;
+    m_position = publish;
+}
+
+bool ShmReader::available() const {
+    return m_header->publish.load() != m_position;
+}
+
+bool ShmReader::wait(int timeoutMs, int spinUs) {
+    if (available()) {
+        return true;
+    }
+    auto now = std::chrono::steady_clock::now();
+    auto spinEnd = now + std::chrono::microseconds(spinUs);
+    while (std::chrono::steady_clock::now() < spinEnd) {
+        if (available()) {
+            return true;
+        }
+    }
+
+    auto deadline = now + std::chrono::milliseconds(timeoutMs);
+    if (!m_writable) {
+        while (!available() && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(kReadOnlyPollInterval);
+        }
+        return available();
+    }
+
+#ifdef __linux__
+    // 先读 notify 再登记；登记后再检查 publish，写入方发布后看到有等待者时推进 notify 并唤醒
+    uint32_t seen = m_header->notify.load();
+    m_header->waiters.fetch_add(1);
+    if (!available() && m_header->writerPid.load() != 0) {
+        auto remaining = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            deadline - std::chrono::steady_clock::now());
+        if (remaining.count() > 0) {
+            timespec timeout;
+            timeout.tv_sec = static_cast<time_t>(remaining.count() / 1000000000);
+            timeout.tv_nsec = static_cast<long>(remaining.count() % 1000000000);
+            syscall(SYS_futex, reinterpret_cast<uint32_t*>(&m_header->notify), FUTEX_WAIT, seen, &timeout,
+                    nullptr, 0);
+        }
+    }
+    m_header->waiters.fetch_sub(1);
+#else
+    while (!available() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(kReadOnlyPollInterval);
+    }
+#endif
+    return available();
+}
+
+bool ShmReader::writerAlive() const {
+    pid_t pid = static_cast<pid_t>(m_header->writerPid.load());
+    return pid != 0 && (kill(pid, 0) == 0 || errno == EPERM);
+}
+
+bool ShmReader::replaced() const {
+    struct stat st;
+    int fd = shm_open(m_name.c_str(), O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0) {
+        return true;
+    }
+    bool same = fstat(fd, &st) == 0 && static_cast<uint64_t>(st.st_dev) == m_device &&
+                static_cast<uint64_t>(st.st_ino) == m_inode;
+    ::close(fd);
+    return !same;
+}
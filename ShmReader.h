@@ -0,0 +1,69 @@
+#pragma once
+#include "ShmRing.h"
+#include <cstdint>
+#include <string>
+
+// 串口共享内存环形缓冲区（见 ShmRing.h）的读取方，每个线程使用自己的 ShmReader
+// 记录的数据直接指向共享内存，不复制；写入方从不等待读取方，读取太慢时记录会被覆盖：
+// next() 发现时跳到最新位置继续，下一条记录的 lost 为跳过的记录数；
+// 原地处理数据后用 valid() 确认处理期间没有被覆盖，否则结果作废
+class ShmReader {
+public:
+    struct Record {
+        uint64_t position;  // 记录在环中的位置，供 valid() 使用
+        uint64_t sequence;
+        uint64_t lost;      // 此记录之前因读取太慢被覆盖而跳过的记录数
+        uint64_t timestampNs;
+        uint16_t flags;     // RecordFlag::Full
+        uint32_t size;
+        const char* data;   // 指向共享内存，写入方可能随时覆盖
+    };
+
+    ShmReader();
+    ~ShmReader();
+
+    ShmReader(const ShmReader&) = delete;
+    ShmReader& operator=(const ShmReader&) = delete;
+
+    // name 为采集器配置的 sharedMemory.name（默认 "serial.<串口名>"），从最新位置开始读取
+    // 没有写权限时只读映射，wait() 改为定时检查
+    bool open(const std::string& name);
+    void close();
+    bool isOpen() const { return m_header != nullptr; }
+    const std::string& error() const { return m_error; }
+
+    std::string port() const;
+    uint64_t dataSize() const { return m_mask + 1; }
+    uint64_t overruns() const { return m_overruns; }  // 被覆盖的次数
+    uint64_t lost() const { return m_lost; }          // 被覆盖而跳过的记录总数
+
+    // 读取下一条记录，没有新记录时返回 false
+    bool next(Record& record);
+    // 记录的数据仍未被覆盖
+    bool valid(const Record& record) const;
+    // 等待新记录：先忙等 spinUs 微秒，再用 futex 睡眠，最长 timeoutMs 毫秒；有新记录时返回 true
+    bool wait(int timeoutMs, int spinUs = 0);
+
+    bool writerAlive() const;  // 写入方进程在运行且没有关闭
+    // 共享内存已被删除或重建（采集器改变了 sizeKB），需要重新 open()
+    bool replaced() const;
+
+private:
+    bool available() const;
+    void overrun(uint64_t publish);
+
+    std::string m_name;
+    ShmRingHeader* m_header;
+    const char* m_data;
+    size_t m_mapSize;
+    uint64_t m_mask;
+    bool m_writable;
+    uint64_t m_device;
+    uint64_t m_inode;
+    uint64_t m_position;
+    uint64_t m_expected;  // 下一条记录应有的序号
+    bool m_hasExpected;
+    uint64_t m_overruns;
+    uint64_t m_lost;
+    std::string m_error;
+};
@@ -0,0 +1,72 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// 串口数据的共享内存环形缓冲区（shm_open，Linux 上为 /dev/shm/<name>），一个写入方（采集器的读取线程）、
+// 任意多个读取方。只在本机共享，字段使用本机字节序，计数器直接用原子操作读写。
+//
+// 文件头（kShmHeaderSize 字节）：
+//   偏移  类型      字段
+//    0    char[8]   magic       "SPCSHM\r\n"
+//    8    uint32    version     1
+//   12    uint32    headerSize  数据区的偏移
+//   16    uint64    dataSize    数据区字节数，2 的幂
+//   24    uint32    writerPid   正在写入的采集器进程，0 为写入方已关闭
+//   64    char[128] port        串口名，0 结尾
+//  192    uint64    reserve     写入方可能已经覆盖到的位置
+//  200    uint64    publish     已发布记录的末尾位置
+//  208    uint64    nextSequence 下一条记录的序号
+//  256    uint32    notify      futex 字，有读取方等待时每次发布后加一
+//  260    uint32    waiters     正在等待的读取方数量
+//
+// 位置是数据区中单调增长的字节数，对 dataSize 取模得到偏移。记录按 8 字节对齐，不跨越数据区末尾：
+//    0    uint32   length     负载字节数，kShmPadding 表示跳到数据区开头
+//    4    uint16   flags      RecordFlag::Full（见 Record.h）
+//    6    uint16   reserved
+//    8    uint64   sequence   记录序号，从 0 开始连续增长，采集器重启后接着编号
+//   16    uint64   timestamp  读取时刻，Unix 纪元起的纳秒数
+//   24             负载，补齐到 8 字节
+// 距数据区末尾不足一个记录头时同样跳到开头。
+//
+// 写入方不等待读取方：先把 reserve 推进到新记录的末尾，再写入记录，最后推进 publish。
+// 读取方在读完记录（或处理完映射区中的数据）后检查 reserve <= 记录位置 + dataSize，
+// 不满足说明记录已被覆盖（读取方太慢），数据作废，从最新位置继续，跳过的记录数由序号得出
+constexpr char kShmMagic[8] = { 'S', 'P', 'C', 'S', 'H', 'M', '\r', '\n' };
+constexpr uint32_t kShmVersion = 1;
+constexpr size_t kShmHeaderSize = 4096;
+constexpr size_t kShmRecordHeaderSize = 24;
+constexpr uint32_t kShmPadding = 0xFFFFFFFF;
+constexpr size_t kShmPortNameSize = 128;
+
+struct ShmRingHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t dataSize;
+    std::atomic<uint32_t> writerPid;
+    alignas(64) char port[kShmPortNameSize];
+    alignas(64) std::atomic<uint64_t> reserve;
+    std::atomic<uint64_t> publish;
+    std::atomic<uint64_t> nextSequence;
+    alignas(64) std::atomic<uint32_t> notify;
+    std::atomic<uint32_t> waiters;
+};
+
+static_assert(sizeof(ShmRingHeader) <= kShmHeaderSize, "ShmRingHeader must fit in the header page");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared memory counters must be lock-free");
+
+struct ShmRecordHeader {
+    uint32_t length;
+    uint16_t flags;
+    uint16_t reserved;
+    uint64_t sequence;
+    uint64_t timestampNs;
+};
+
+static_assert(sizeof(ShmRecordHeader) == kShmRecordHeaderSize, "unexpected ShmRecordHeader layout");
+
+// 负载为 length 字节的记录在数据区中占用的字节数
+inline uint64_t shmRecordSize(uint32_t length) {
+    return kShmRecordHeaderSize + ((static_cast<uint64_t>(length) + 7) & ~uint64_t(7));
+}
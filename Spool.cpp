@@ -0,0 +1,235 @@
+#include "Spool.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cinttypes>
+#include <string>
+
+namespace {
+
+constexpr size_t kWriteBufferSize = 64 * 1024;
+// 新队列的段号从这里开始，为 prepend() 预留更小的段号
+constexpr uint64_t kFirstSegmentIndex = 1ull << 32;
+
+bool parseSegmentIndex(const std::filesystem::path& path, uint64_t& index) {
+    if (path.extension() != ".seg") {
+        return false;
+    }
+    std::string stem = path.stem().string();
+    if (stem.empty() || !std::all_of(stem.begin(), stem.end(), ::isdigit)) {
+        return false;
+    }
+    index = std::stoull(stem);
+    return true;
+}
+
+} // namespace
+
+Spool::Spool(const std::filesystem::path& dir, uint64_t segmentSize, uint64_t maxBytes)
+    : m_dir(dir), m_segmentSize(std::max<uint64_t>(segmentSize, 4096)), m_maxBytes(maxBytes),
+      m_nextIndex(kFirstSegmentIndex), m_writeFile(nullptr), m_writeDirty(false),
+      m_writeBuffer(kWriteBufferSize), m_readFile(nullptr), m_readIndex(0),
+      m_ackOffset(0), m_readOffset(0), m_writeOffset(0) {}
+
+Spool::~Spool() {
+    close();
+}
+
+std::filesystem::path Spool::segmentPath(uint64_t index) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016" PRIu64 ".seg", index);
+    return m_dir / name;
+}
+
+bool Spool::open() {
+    std::error_code ec;
+    std::filesystem::create_directories(m_dir, ec);
+    if (ec) {
+        LOG_ERROR(m_dir.string(), "Failed to create spool directory: " + ec.message());
+        return false;
+    }
+
+    std::vector<uint64_t> indexes;
+    for (const auto& entry : std::filesystem::directory_iterator(m_dir, ec)) {
+        uint64_t index;
+        if (entry.is_regular_file() && parseSegmentIndex(entry.path(), index)) {
+            indexes.push_back(index);
+        }
+    }
+    std::sort(indexes.begin(), indexes.end());
+
+    for (uint64_t index : indexes) {
+        uint64_t size = std::filesystem::file_size(segmentPath(index), ec);
+        if (ec || size == 0) {
+            std::filesystem::remove(segmentPath(index), ec);
+            continue;
+        }
+        m_segments.push_back({ index, m_writeOffset, size });
+        m_writeOffset += size;
+        m_nextIndex = index + 1;
+    }
+
+    if (!m_segments.empty()) {
+        LOG_ERROR(m_dir.string(), "Spool contains " + std::to_string(m_writeOffset) +
+                  " bytes from a previous run, replaying after connect");
+    }
+    return true;
+}
+
+void Spool::close() {
+    closeReadFile();
+    if (m_writeFile) {
+        std::fclose(m_writeFile);
+        m_writeFile = nullptr;
+        m_writeDirty = false;
+    }
+}
+
+bool Spool::openWriteSegment() {
+    if (m_writeFile) {
+        std::fclose(m_writeFile);
+        m_writeFile = nullptr;
+    }
+
+    uint64_t index = m_nextIndex++;
+    m_writeFile = std::fopen(segmentPath(index).string().c_str(), "wb");
+    if (!m_writeFile) {
+        LOG_ERROR(m_dir.string(), "Failed to create spool segment " + segmentPath(index).string());
+        return false;
+    }
+    std::setvbuf(m_writeFile, m_writeBuffer.data(), _IOFBF, m_writeBuffer.size());
+    m_segments.push_back({ index, m_writeOffset, 0 });
+    return true;
+}
+
+bool Spool::append(const char* data, size_t size) {
+    if (pendingBytes() + size > m_maxBytes) {
+        return false;
+    }
+
+    // 启动时加载的旧段不再追加，总是写入新段
+    if (!m_writeFile || m_segments.empty() || m_segments.back().size >= m_segmentSize) {
+        if (!openWriteSegment()) {
+            return false;
+        }
+    }
+
+    if (std::fwrite(data, 1, size, m_writeFile) != size) {
+        LOG_ERROR(m_dir.string(), "Short write to spool segment");
+        return false;
+    }
+    m_segments.back().size += size;
+    m_writeOffset += size;
+    m_writeDirty = true;
+    return true;
+}
+
+bool Spool::prepend(const char* data, size_t size) {
+    if (size == 0) {
+        return true;
+    }
+    uint64_t index = m_segments.empty() ? m_nextIndex++ : m_segments.front().index - 1;
+    if (!m_segments.empty() && m_segments.front().index == 0) {
+        return false;
+    }
+
+    closeReadFile();
+    std::FILE* file = std::fopen(segmentPath(index).string().c_str(), "wb");
+    if (!file) {
+        LOG_ERROR(m_dir.string(), "Failed to create spool segment " + segmentPath(index).string());
+        return false;
+    }
+    bool ok = std::fwrite(data, 1, size, file) == size;
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok) {
+        LOG_ERROR(m_dir.string(), "Short write to spool segment");
+        std::error_code ec;
+        std::filesystem::remove(segmentPath(index), ec);
+    }
+    return ok;
+}
+
+size_t Spool::peek(char* buffer, size_t size) {
+    auto it = std::find_if(m_segments.begin(), m_segments.end(), [this](const Segment& segment) {
+        return m_readOffset < segment.start + segment.size;
+    });
+    if (it == m_segments.end()) {
+        return 0;
+    }
+
+    // 正在写入的段先把写缓冲落盘再读取
+    if (m_writeFile && m_writeDirty && it->index == m_segments.back().index) {
+        std::fflush(m_writeFile);
+        m_writeDirty = false;
+    }
+
+    if (!m_readFile || m_readIndex != it->index) {
+        closeReadFile();
+        m_readFile = std::fopen(segmentPath(it->index).string().c_str(), "rb");
+        if (!m_readFile) {
+            skipSegment(*it, "Failed to open spool segment ");
+            return 0;
+        }
+        // 读取直接进入调用方缓冲区，不需要 stdio 再缓冲一次
+        std::setvbuf(m_readFile, nullptr, _IONBF, 0);
+        m_readIndex = it->index;
+    }
+
+    uint64_t offset = m_readOffset - it->start;
+    size_t count = static_cast<size_t>(std::min<uint64_t>(size, it->size - offset));
+    size_t bytesRead = 0;
+    if (std::fseek(m_readFile, static_cast<long>(offset), SEEK_SET) == 0) {
+        bytesRead = std::fread(buffer, 1, count, m_readFile);
+    }
+    if (bytesRead == 0) {
+        skipSegment(*it, "Failed to read spool segment ");
+    }
+    return bytesRead;
+}
+
+void Spool::skipSegment(const Segment& segment, const std::string& reason) {
+    // 无法读取的段（被删除或截断）整段跳过，避免发送线程反复重试
+    LOG_ERROR(m_dir.string(), reason + segmentPath(segment.index).string() + ", skipping " +
+              std::to_string(segment.start + segment.size - m_readOffset) + " bytes");
+    closeReadFile();
+    m_readOffset = segment.start + segment.size;
+}
+
+void Spool::consume(size_t bytes) {
+    m_readOffset = std::min(m_readOffset + bytes, m_writeOffset);
+}
+
+void Spool::acknowledge(uint64_t offset) {
+    m_ackOffset = std::max(m_ackOffset, std::min(offset, m_readOffset));
+
+    // 删除已全部确认的段；全部确认后连正在写入的段也删除，下次写入新建
+    bool allAcked = m_ackOffset == m_writeOffset;
+    while (!m_segments.empty()) {
+        const Segment& front = m_segments.front();
+        bool isWriteSegment = m_segments.size() == 1;
+        if (front.start + front.size > m_ackOffset || (isWriteSegment && !allAcked)) {
+            break;
+        }
+        if (m_readFile && m_readIndex == front.index) {
+            closeReadFile();
+        }
+        if (isWriteSegment && m_writeFile) {
+            std::fclose(m_writeFile);
+            m_writeFile = nullptr;
+            m_writeDirty = false;
+        }
+        std::error_code ec;
+        std::filesystem::remove(segmentPath(front.index), ec);
+        m_segments.pop_front();
+    }
+}
+
+void Spool::rewind() {
+    m_readOffset = m_ackOffset;
+}
+
+void Spool::closeReadFile() {
+    if (m_readFile) {
+        std::fclose(m_readFile);
+        m_readFile = nullptr;
+    }
+}
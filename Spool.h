@@ -0,0 +1,69 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// TCP 转发的存储转发队列：只追加写入的分段文件
+// 偏移量在整个队列中连续编号；确认位置之前的整段会被删除，
+// 读取位置可以回退到确认位置，用于断线后重新发送未确认的数据
+class Spool {
+public:
+    Spool(const std::filesystem::path& dir, uint64_t segmentSize, uint64_t maxBytes);
+    ~Spool();
+
+    Spool(const Spool&) = delete;
+    Spool& operator=(const Spool&) = delete;
+
+    // 加载目录中已有的分段，进程重启后继续回放
+    bool open();
+    void close();
+
+    // 超出 maxBytes 时返回 false，数据不写入
+    bool append(const char* data, size_t size);
+    // 把数据写成排在最前面的新段，下次 open() 后最先回放；只在 close() 之前调用
+    bool prepend(const char* data, size_t size);
+
+    // 从读取位置复制最多 size 字节，不移动读取位置；返回 0 时不可读的段已被跳过
+    size_t peek(char* buffer, size_t size);
+    void consume(size_t bytes);
+
+    void acknowledge(uint64_t offset);  // offset 之前的数据已被对端确认
+    void rewind();                      // 读取位置回到确认位置
+
+    uint64_t readOffset() const { return m_readOffset; }
+    uint64_t pendingBytes() const { return m_writeOffset - m_ackOffset; }
+    uint64_t unreadBytes() const { return m_writeOffset - m_readOffset; }
+    bool hasUnread() const { return m_readOffset < m_writeOffset; }
+
+private:
+    struct Segment {
+        uint64_t index;
+        uint64_t start;  // 段首字节在队列中的偏移
+        uint64_t size;
+    };
+
+    std::filesystem::path segmentPath(uint64_t index) const;
+    bool openWriteSegment();
+    void closeReadFile();
+    void skipSegment(const Segment& segment, const std::string& reason);
+
+    std::filesystem::path m_dir;
+    uint64_t m_segmentSize;
+    uint64_t m_maxBytes;
+
+    std::deque<Segment> m_segments;
+    uint64_t m_nextIndex;
+
+    std::FILE* m_writeFile;  // 写入 m_segments.back()
+    bool m_writeDirty;       // 写缓冲中有尚未落盘的数据
+    std::vector<char> m_writeBuffer;
+    std::FILE* m_readFile;
+    uint64_t m_readIndex;
+
+    uint64_t m_ackOffset;
+    uint64_t m_readOffset;
+    uint64_t m_writeOffset;
+};
@@ -0,0 +1,127 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// 队列状态，用于状态显示
+struct QueueStats {
+    size_t depth;
+    size_t highWater;
+    size_t capacity;
+    uint64_t drops;
+};
+
+// 有界无锁单生产者/单消费者环形队列
+// push() 只能在一个线程调用，pop() 只能在另一个线程调用；队列满时 push() 立即返回 false
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacity)
+        : m_head(0), m_cachedTail(0), m_tail(0), m_cachedHead(0), m_highWater(0) {
+        size_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        m_slots.resize(size);
+        m_mask = size - 1;
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    bool push(T&& item) {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_cachedHead > m_mask) {
+            m_cachedHead = m_head.load(std::memory_order_acquire);
+            if (tail - m_cachedHead > m_mask) {
+                return false;
+            }
+        }
+        m_slots[tail & m_mask] = std::move(item);
+        m_tail.store(tail + 1, std::memory_order_release);
+
+        // 高水位按真实的消费位置计算，缓存的 head 可能已过时
+        size_t depth = tail + 1 - m_head.load(std::memory_order_relaxed);
+        if (depth > m_highWater.load(std::memory_order_relaxed)) {
+            m_highWater.store(depth, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    bool pop(T& item) {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_cachedTail) {
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+            if (head == m_cachedTail) {
+                return false;
+            }
+        }
+        item = std::move(m_slots[head & m_mask]);
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 以下方法可在任意线程调用，结果为近似值
+    size_t size() const {
+        size_t tail = m_tail.load(std::memory_order_acquire);
+        size_t head = m_head.load(std::memory_order_acquire);
+        return tail >= head ? tail - head : 0;
+    }
+    bool empty() const { return size() == 0; }
+    size_t capacity() const { return m_mask + 1; }
+    size_t highWater() const { return m_highWater.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr size_t kCacheLine = 64;
+
+    std::vector<T> m_slots;
+    size_t m_mask;
+
+    // 消费者写入的索引与生产者写入的索引分处不同缓存行，避免伪共享
+    alignas(kCacheLine) std::atomic<size_t> m_head;
+    size_t m_cachedTail;
+    alignas(kCacheLine) std::atomic<size_t> m_tail;
+    size_t m_cachedHead;
+    alignas(kCacheLine) std::atomic<size_t> m_highWater;
+};
+
+// 消费者无数据时休眠，生产者只有在消费者休眠时才加锁唤醒，正常情况下不加锁
+class WakeSignal {
+public:
+    WakeSignal() : m_sleeping(false) {}
+
+    void notify() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_sleeping.load(std::memory_order_relaxed)) {
+            { std::lock_guard<std::mutex> lock(m_mutex); }
+            m_cv.notify_one();
+        }
+    }
+
+    template <typename Predicate, typename Rep, typename Period>
+    void waitFor(Predicate ready, std::chrono::duration<Rep, Period> timeout) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_sleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        m_cv.wait_for(lock, timeout, ready);
+        m_sleeping.store(false, std::memory_order_relaxed);
+    }
+
+    template <typename Predicate>
+    void wait(Predicate ready) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_sleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        m_cv.wait(lock, ready);
+        m_sleeping.store(false, std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<bool> m_sleeping;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+};
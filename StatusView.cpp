@@ -0,0 +1,438 @@
+#include "StatusView.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <conio.h>
+#else
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace {
+
+// 速率等按时间常数 5 秒平滑，每秒取样一次
+constexpr double kSmoothingSeconds = 5.0;
+constexpr auto kSampleInterval = std::chrono::seconds(1);
+constexpr int kDefaultRows = 24;
+// 标题、分隔线、表头、分隔线，以及底部的分隔线和提示行
+constexpr int kHeaderRows = 4;
+constexpr int kFooterRows = 2;
+
+constexpr int kKeyNextPage = 0x100;
+constexpr int kKeyPrevPage = 0x101;
+
+// 各列宽度，总宽 143
+constexpr int kWidths[] = { 4, 14, 10, 10, 14, 10, 12, 12, 10, 9, 10, 8, 10, 10 };
+constexpr int kTotalWidth = 143;
+const char* const kHeaders[] = { "No.", "Port", "Baud", "Status", "Speed(B/s)", "Lat(ms)",
+                                 "DiskQ", "TcpQ", "Spool(KB)", "Mem(KB)", "Drops", "Ratio", "ms/MB",
+                                 "Alloc/s" };
+constexpr size_t kStatusColumn = 3;
+constexpr size_t kDropsColumn = 10;
+
+// 右对齐到列宽，过长时保留末尾（串口名的区别通常在后面）
+std::string fit(const std::string& text, int width) {
+    size_t w = static_cast<size_t>(width);
+    if (text.size() < w) {
+        return std::string(w - text.size(), ' ') + text;
+    }
+    return " " + text.substr(text.size() - (w - 1));
+}
+
+std::string fixed(double value, int precision) {
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.*f", precision, value);
+    return text;
+}
+
+// 队列深度/高水位
+std::string formatQueue(const QueueStats& stats) {
+    return std::to_string(stats.depth) + "/" + std::to_string(stats.highWater);
+}
+
+double smooth(double average, double value, double alpha) {
+    return average + alpha * (value - average);
+}
+
+// 终端的原始输入模式、窗口大小和按键读取，析构时恢复
+class Terminal {
+public:
+    Terminal() {
+#ifdef _WIN32
+        m_output = GetStdHandle(STD_OUTPUT_HANDLE);
+        if (GetConsoleMode(m_output, &m_outputMode)) {
+            SetConsoleMode(m_output, m_outputMode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+        }
+#else
+        m_raw = isatty(STDIN_FILENO) && tcgetattr(STDIN_FILENO, &m_saved) == 0;
+        if (m_raw) {
+            termios raw = m_saved;
+            raw.c_lflag &= ~static_cast<tcflag_t>(ICANON | ECHO);  // 保留 ISIG，Ctrl+C 照常退出
+            raw.c_cc[VMIN] = 0;
+            raw.c_cc[VTIME] = 0;
+            tcsetattr(STDIN_FILENO, TCSANOW, &raw);
+        }
+#endif
+        write("\033[?25l\033[2J");
+    }
+
+    ~Terminal() {
+        write("\033[0m\033[?25h\033[" + std::to_string(rows()) + ";1H\n");
+#ifdef _WIN32
+        SetConsoleMode(m_output, m_outputMode);
+#else
+        if (m_raw) {
+            tcsetattr(STDIN_FILENO, TCSANOW, &m_saved);
+        }
+#endif
+    }
+
+    int rows() const {
+#ifdef _WIN32
+        CONSOLE_SCREEN_BUFFER_INFO info;
+        if (GetConsoleScreenBufferInfo(m_output, &info)) {
+            return info.srWindow.Bottom - info.srWindow.Top + 1;
+        }
+#else
+        winsize size = {};
+        if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0 && size.ws_row > 0) {
+            return size.ws_row;
+        }
+#endif
+        return kDefaultRows;
+    }
+
+    void write(const std::string& text) {
+        std::fwrite(text.data(), 1, text.size(), stdout);
+        std::fflush(stdout);
+    }
+
+    // 等待按键，超时返回 -1
+    int readKey(int timeoutMs) {
+#ifdef _WIN32
+        for (int waited = 0; waited < timeoutMs; waited += 50) {
+            if (_kbhit()) {
+                int key = _getch();
+                if (key == 0 || key == 224) {
+                    int code = _getch();
+                    return code == 81 ? kKeyNextPage : code == 73 ? kKeyPrevPage : -1;
+                }
+                return key;
+            }
+            Sleep(50);
+        }
+        return -1;
+#else
+        if (!m_raw) {
+            // 标准输入不是终端（如重定向）时只等待
+            poll(nullptr, 0, timeoutMs);
+            return -1;
+        }
+        pollfd pfd = { STDIN_FILENO, POLLIN, 0 };
+        if (poll(&pfd, 1, timeoutMs) <= 0) {
+            return -1;  // 超时或被信号打断
+        }
+        char keys[16];
+        ssize_t size = ::read(STDIN_FILENO, keys, sizeof(keys));
+        if (size <= 0) {
+            return -1;
+        }
+        std::string sequence(keys, static_cast<size_t>(size));
+        if (sequence == "\033[6~") return kKeyNextPage;
+        if (sequence == "\033[5~") return kKeyPrevPage;
+        return size == 1 ? static_cast<unsigned char>(keys[0]) : -1;
+#endif
+    }
+
+private:
+#ifdef _WIN32
+    HANDLE m_output;
+    DWORD m_outputMode = 0;
+#else
+    bool m_raw;
+    termios m_saved;
+#endif
+};
+
+const char* colorCode(int color) {
+    switch (color) {
+        case 1:  return "\033[31m";
+        case 2:  return "\033[33m";
+        case 3:  return "\033[32m";
+        case 4:  return "\033[37m";
+        default: return "\033[0m";
+    }
+}
+
+} // namespace
+
+StatusView::StatusView(const PortSet& ports)
+    : m_ports(ports), m_sort(Sort::Config), m_page(0) {
+}
+
+void StatusView::run(std::atomic<bool>& running) {
+    Terminal terminal;
+    int lastRows = -1;
+    m_lastSample = std::chrono::steady_clock::now() - kSampleInterval;
+
+    while (running) {
+        int rows = terminal.rows();
+        std::vector<Row> frame;
+        {
+            auto lock = m_ports.lock();
+            if (std::chrono::steady_clock::now() - m_lastSample >= kSampleInterval) {
+                sample();
+            }
+            frame = buildFrame(rows);
+        }
+        // 窗口大小变化后终端内容已不可信，整屏重画
+        terminal.write(diff(frame, rows != lastRows));
+        lastRows = rows;
+
+        auto next = m_lastSample + kSampleInterval;
+        auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(
+            next - std::chrono::steady_clock::now()).count();
+        int key = terminal.readKey(static_cast<int>((std::max)(wait, static_cast<decltype(wait)>(1))));
+        if (key >= 0) {
+            handleKey(key, running);
+        }
+    }
+}
+
+void StatusView::sample() {
+    auto now = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(now - m_lastSample).count();
+    m_lastSample = now;
+    double alpha = 1.0 - std::exp(-elapsed / kSmoothingSeconds);
+
+    std::map<const PortCollector*, PortState> states;
+    for (const auto& collector : m_ports.collectors()) {
+        const PortMetrics& metrics = collector->metrics();
+        PortState state = m_states[collector.get()];
+        uint64_t bytesRead = metrics.bytesRead.load();
+        uint64_t latencyCount = metrics.readLatency.count();
+        uint64_t latencySumNs = metrics.readLatency.sumNs();
+        uint64_t allocations = collector->allocations();
+
+        if (state.sampled && elapsed > 0.0) {
+            double bytesPerSecond = (bytesRead - state.bytesRead) / elapsed;
+            double allocationsPerSecond = (allocations - state.allocations) / elapsed;
+            // 第一个区间直接取当前值，避免从 0 缓慢爬升
+            double weight = state.seeded ? alpha : 1.0;
+            state.bytesPerSecond = smooth(state.bytesPerSecond, bytesPerSecond, weight);
+            state.allocationsPerSecond = smooth(state.allocationsPerSecond, allocationsPerSecond, weight);
+            uint64_t count = latencyCount - state.latencyCount;
+            if (count > 0) {
+                double latencyMs = (latencySumNs - state.latencySumNs) / 1e6 / count;
+                state.latencyMs = smooth(state.latencyMs, latencyMs, state.latencyMs == 0.0 ? 1.0 : alpha);
+            }
+            state.seeded = true;
+        }
+        state.sampled = true;
+        state.bytesRead = bytesRead;
+        state.latencyCount = latencyCount;
+        state.latencySumNs = latencySumNs;
+        state.allocations = allocations;
+        states[collector.get()] = state;
+    }
+    // 已删除或替换的采集器不再保留
+    m_states = std::move(states);
+}
+
+std::vector<StatusView::Row> StatusView::buildFrame(int rows) {
+    const auto& collectors = m_ports.collectors();
+    auto now = std::chrono::steady_clock::now();
+
+    std::vector<Line> lines;
+    for (size_t i = 0; i < collectors.size(); ++i) {
+        const PortCollector& collector = *collectors[i];
+        const PortConfig& config = collector.getConfig();
+        const PortMetrics& metrics = collector.metrics();
+        auto state = m_states.find(&collector);
+        if (state == m_states.end()) {
+            state = m_states.emplace(&collector, PortState()).first;
+        }
+
+        // 根据超时时间和最近一次收到数据的时刻判断显示状态
+        int64_t lastDataNs = metrics.lastDataNs.load(std::memory_order_relaxed);
+        int status = 2;
+        if (lastDataNs == 0) {
+            status = 1;
+        } else if (now.time_since_epoch() - std::chrono::nanoseconds(lastDataNs) >=
+                   std::chrono::seconds(config.timeout)) {
+            status = 0;
+        }
+        lines.push_back(Line{ i, config.name, config.baudRate, status, &state->second, {} });
+    }
+
+    switch (m_sort) {
+        case Sort::Rate:
+            std::stable_sort(lines.begin(), lines.end(), [](const Line& a, const Line& b) {
+                return a.state->bytesPerSecond > b.state->bytesPerSecond;
+            });
+            break;
+        case Sort::Status:
+            std::stable_sort(lines.begin(), lines.end(), [](const Line& a, const Line& b) {
+                return a.status < b.status;
+            });
+            break;
+        default:
+            break;
+    }
+
+    size_t pageSize = static_cast<size_t>((std::max)(rows - kHeaderRows - kFooterRows, 1));
+    size_t pages = (std::max)((lines.size() + pageSize - 1) / pageSize, static_cast<size_t>(1));
+    m_page = (std::min)(m_page, pages - 1);
+    size_t first = m_page * pageSize;
+    size_t last = (std::min)(first + pageSize, lines.size());
+
+    std::string separator(kTotalWidth, '-');
+    std::vector<Row> frame;
+    std::string title = "Serial Port Collector v1.0.2";
+    title.resize(kTotalWidth, ' ');
+    frame.push_back({ Cell{ title, Color::White } });
+    frame.push_back({ Cell{ separator, Color::White } });
+    Row header;
+    for (size_t c = 0; c < sizeof(kWidths) / sizeof(kWidths[0]); ++c) {
+        header.push_back(Cell{ fit(kHeaders[c], kWidths[c]), Color::White });
+    }
+    frame.push_back(header);
+    frame.push_back({ Cell{ separator, Color::White } });
+
+    static const char* const statusText[] = { "Offline", "Waiting", "Active" };
+    static const Color statusColor[] = { Color::Red, Color::Yellow, Color::Green };
+    for (size_t i = first; i < last; ++i) {
+        const Line& line = lines[i];
+        const PortCollector& collector = *collectors[line.index];
+        const PortState& state = *line.state;
+        const CompressionStats* compression = collector.compressionStats();
+        uint64_t bytesIn = compression ? compression->bytesIn.load(std::memory_order_relaxed) : 0;
+        uint64_t bytesOut = compression ? compression->bytesOut.load(std::memory_order_relaxed) : 0;
+        bool compressed = bytesIn > 0 && bytesOut > 0;
+        uint64_t drops = collector.drops();
+
+        // 压缩比和每 MB 原始数据的压缩 CPU 时间
+        std::string ratio = compressed ? fixed(static_cast<double>(bytesIn) / bytesOut, 2) : "-";
+        std::string cpu = compressed ?
+            fixed(compression->cpuNs.load(std::memory_order_relaxed) / 1e6 / (bytesIn / 1048576.0), 2) : "-";
+
+        const std::string texts[] = {
+            std::to_string(line.index + 1), line.name, std::to_string(line.baudRate),
+            statusText[line.status], fixed(state.bytesPerSecond, 1), fixed(state.latencyMs, 2),
+            formatQueue(collector.diskQueueStats()), formatQueue(collector.tcpQueueStats()),
+            std::to_string(collector.spooledBytes() / 1024), std::to_string(collector.memoryBytes() / 1024),
+            std::to_string(drops), ratio, cpu, fixed(state.allocationsPerSecond, 0),
+        };
+        Row row;
+        for (size_t c = 0; c < sizeof(kWidths) / sizeof(kWidths[0]); ++c) {
+            Color color = Color::White;
+            if (c == kStatusColumn) {
+                color = statusColor[line.status];
+            } else if (c == kDropsColumn && drops > 0) {
+                color = Color::Red;
+            }
+            row.push_back(Cell{ fit(texts[c], kWidths[c]), color });
+        }
+        frame.push_back(std::move(row));
+    }
+
+    static const char* const sortText[] = { "config", "rate", "status" };
+    std::string memoryText;
+    if (const MemoryBudget* memory = m_ports.memory()) {
+        memoryText = "  Mem " + std::to_string(memory->used() / (1024 * 1024)) + "MB";
+        if (memory->limit() > 0) {
+            memoryText += "/" + std::to_string(memory->limit() / (1024 * 1024)) + "MB";
+        }
+    }
+    std::string footer = "Ports " + std::to_string(lines.empty() ? 0 : first + 1) + "-" +
+                         std::to_string(last) + " of " + std::to_string(lines.size()) +
+                         "  Page " + std::to_string(m_page + 1) + "/" + std::to_string(pages) +
+                         "  Sort: " + sortText[static_cast<int>(m_sort)] + memoryText +
+                         "  [n/p] page  [s] sort  [q] quit";
+    footer.resize(kTotalWidth, ' ');
+    frame.push_back({ Cell{ separator, Color::White } });
+    frame.push_back({ Cell{ footer, Color::White } });
+    return frame;
+}
+
+std::string StatusView::diff(const std::vector<Row>& frame, bool full) {
+    std::string out;
+    if (full) {
+        out += "\033[2J";
+        m_screen.clear();
+    }
+
+    int current = -1;  // 已输出的颜色，-1 为未知
+    auto setColor = [&](Color color) {
+        int code = static_cast<int>(color);
+        if (code != current) {
+            out += colorCode(code);
+            current = code;
+        }
+    };
+
+    for (size_t r = 0; r < frame.size(); ++r) {
+        const Row& row = frame[r];
+        // 列的划分不同时整行重写，否则只写变化的单元格
+        bool sameLayout = r < m_screen.size() && m_screen[r].size() == row.size();
+        for (size_t c = 0; sameLayout && c < row.size(); ++c) {
+            sameLayout = m_screen[r][c].text.size() == row[c].text.size();
+        }
+
+        size_t column = 0;
+        bool positioned = false;
+        for (size_t c = 0; c < row.size(); ++c) {
+            if (!sameLayout || m_screen[r][c] != row[c]) {
+                if (!positioned) {
+                    out += "\033[" + std::to_string(r + 1) + ";" + std::to_string(column + 1) + "H";
+                }
+                setColor(row[c].color);
+                out += row[c].text;
+                positioned = true;
+            } else {
+                positioned = false;
+            }
+            column += row[c].text.size();
+        }
+        if (!sameLayout) {
+            out += "\033[K";
+        }
+    }
+    // 上一帧多出的行清空
+    for (size_t r = frame.size(); r < m_screen.size(); ++r) {
+        out += "\033[" + std::to_string(r + 1) + ";1H\033[K";
+    }
+    if (!out.empty()) {
+        out += "\033[0m";
+    }
+    m_screen = frame;
+    return out;
+}
+
+bool StatusView::handleKey(int key, std::atomic<bool>& running) {
+    switch (key) {
+        case 'n': case 'N': case ' ': case kKeyNextPage:
+            ++m_page;  // 超出时在 buildFrame 中收回到最后一页
+            return true;
+        case 'p': case 'P': case kKeyPrevPage:
+            if (m_page > 0) {
+                --m_page;
+            }
+            return true;
+        case 's': case 'S':
+            m_sort = static_cast<Sort>((static_cast<int>(m_sort) + 1) % 3);
+            m_page = 0;
+            return true;
+        case 'q': case 'Q':
+            running = false;
+            return true;
+        default:
+            return false;
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include "PortSet.h"
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+// 控制台状态显示
+// 每秒从各串口的累计计数器取差值，速率、延迟和分配次数按指数滑动平均平滑；
+// 屏幕内容按单元格与上一帧比较，只重写变化的单元格。串口数超过一屏时分页，
+// 按键：n/PgDn 下一页，p/PgUp 上一页，s 切换排序（配置顺序、速率、状态），q 退出
+class StatusView {
+public:
+    explicit StatusView(const PortSet& ports);
+
+    // 运行到 running 变为 false 或按下 q（此时把 running 置为 false）
+    void run(std::atomic<bool>& running);
+
+private:
+    enum class Color { Default, Red, Yellow, Green, White };
+    enum class Sort { Config, Rate, Status };
+
+    struct Cell {
+        std::string text;
+        Color color;
+        bool operator==(const Cell& other) const { return text == other.text && color == other.color; }
+        bool operator!=(const Cell& other) const { return !(*this == other); }
+    };
+    using Row = std::vector<Cell>;
+
+    // 每个采集器的上一次读数和平滑后的值；热加载替换的采集器从头开始
+    struct PortState {
+        bool sampled = false;
+        bool seeded = false;
+        uint64_t bytesRead = 0;
+        uint64_t latencyCount = 0;
+        uint64_t latencySumNs = 0;
+        uint64_t allocations = 0;
+        double bytesPerSecond = 0.0;
+        double latencyMs = 0.0;
+        double allocationsPerSecond = 0.0;
+    };
+
+    struct Line {
+        size_t index;  // 在配置中的序号
+        std::string name;
+        int baudRate;
+        int status;    // 0 Offline, 1 Waiting, 2 Active
+        const PortState* state;
+        Row cells;
+    };
+
+    void sample();
+    std::vector<Row> buildFrame(int rows);
+    std::string diff(const std::vector<Row>& frame, bool full);
+    bool handleKey(int key, std::atomic<bool>& running);
+
+    const PortSet& m_ports;
+    std::map<const PortCollector*, PortState> m_states;
+    std::chrono::steady_clock::time_point m_lastSample;
+    std::vector<Row> m_screen;  // 终端上当前显示的内容
+    Sort m_sort;
+    size_t m_page;
+};
@@ -1,6 +1,12 @@
 #include "TcpClient.h"
+#include "Frame.h"
 #include "Logger.h"
+#include "Timestamp.h"
 #include <iostream>
+#include <algorithm>
+#include <climits>
+#include <filesystem>
+#include <random>
 
 #ifdef _WIN32
     #include <winsock2.h>
@@ -8,16 +14,144 @@
     #pragma comment(lib, "ws2_32.lib")
 #else
     #include <sys/socket.h>
+    #include <sys/uio.h>
     #include <netinet/in.h>
+    #include <netinet/tcp.h>
     #include <arpa/inet.h>
+    #include <sys/ioctl.h>
+    #include <poll.h>
+    #include <fcntl.h>
     #include <unistd.h>
     #include <errno.h>
+    #ifdef __linux__
+        #include <linux/sockios.h>
+    #endif
     #define SOCKET_ERROR (-1)
     #define INVALID_SOCKET (-1)
 #endif
 
-TcpClient::TcpClient(const TcpConfig& config)
-    : m_config(config), m_running(false), m_connected(false), m_socket(INVALID_SOCKET) {
+namespace {
+
+// 单次 writev/WSASend 的最大分段数
+constexpr size_t kMaxBatchChunks = 256;
+// 从磁盘队列补发时每次读取的字节数
+constexpr size_t kReplayBufferSize = 256 * 1024;
+// 有积压数据时等待套接字可写或对端确认的时间
+constexpr int kBacklogWaitMs = 10;
+// 等待连接建立时每次最长等待的时间，期间可以响应 stop()
+constexpr int kConnectSliceMs = 100;
+
+#ifdef _WIN32
+using IoVec = WSABUF;
+using SocketHandle = unsigned long long;
+
+void setIoVec(IoVec& vec, const char* data, size_t size) {
+    vec.buf = const_cast<char*>(data);
+    vec.len = static_cast<ULONG>(size);
+}
+#else
+using IoVec = iovec;
+using SocketHandle = int;
+
+void setIoVec(IoVec& vec, const char* data, size_t size) {
+    vec.iov_base = const_cast<char*>(data);
+    vec.iov_len = size;
+}
+#endif
+
+// 尝试发送一次，返回已发送字节数；非阻塞发送缓冲区已满时返回 0，出错返回 -1
+// Windows 下套接字是阻塞的，WSASend 发送全部数据或返回错误
+long long sendSome(SocketHandle socket, IoVec* iov, size_t count) {
+#ifdef _WIN32
+    DWORD sent = 0;
+    if (WSASend(socket, iov, static_cast<DWORD>(count), &sent, 0, NULL, NULL) == SOCKET_ERROR) {
+        return -1;
+    }
+    return sent;
+#else
+    msghdr msg = {};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = count;
+    while (true) {
+        ssize_t sent = ::sendmsg(socket, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (sent >= 0) {
+            return sent;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return 0;
+        }
+        if (errno != EINTR) {
+            return -1;
+        }
+    }
+#endif
+}
+
+void setNonBlocking(SocketHandle socket, bool enabled) {
+#ifdef _WIN32
+    u_long mode = enabled ? 1 : 0;
+    ioctlsocket(socket, FIONBIO, &mode);
+#else
+    int flags = fcntl(socket, F_GETFL, 0);
+    fcntl(socket, F_SETFL, enabled ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK));
+#endif
+}
+
+// 等待非阻塞 connect 完成：成功返回 1，失败返回 -1，超时返回 0
+int waitConnected(SocketHandle socket, int timeoutMs) {
+#ifdef _WIN32
+    fd_set writeSet;
+    fd_set errorSet;
+    FD_ZERO(&writeSet);
+    FD_ZERO(&errorSet);
+    FD_SET(socket, &writeSet);
+    FD_SET(socket, &errorSet);
+    timeval timeout = { timeoutMs / 1000, (timeoutMs % 1000) * 1000 };
+    int ready = select(0, NULL, &writeSet, &errorSet, &timeout);
+    if (ready <= 0) {
+        return ready < 0 ? -1 : 0;
+    }
+    return FD_ISSET(socket, &errorSet) ? -1 : 1;
+#else
+    pollfd pfd = { socket, POLLOUT, 0 };
+    int ready = ::poll(&pfd, 1, timeoutMs);
+    if (ready <= 0) {
+        return ready < 0 && errno != EINTR ? -1 : 0;
+    }
+    int error = 0;
+    socklen_t length = sizeof(error);
+    if (getsockopt(socket, SOL_SOCKET, SO_ERROR, &error, &length) != 0 || error != 0) {
+        return -1;
+    }
+    return 1;
+#endif
+}
+
+// 等待套接字可写，超时返回 false；Windows 下套接字是阻塞的，不需要等待
+bool waitWritable(SocketHandle socket, int timeoutMs) {
+#ifdef _WIN32
+    (void)socket;
+    (void)timeoutMs;
+    return true;
+#else
+    pollfd pfd = { socket, POLLOUT, 0 };
+    return ::poll(&pfd, 1, timeoutMs) > 0;
+#endif
+}
+
+} // namespace
+
+TcpClient::Source::Source(TcpClient& client, uint16_t portId, const std::string& name,
+                          size_t capacity, std::shared_ptr<PortMetrics> metrics)
+    : client(client), portId(portId), name(name), queue(capacity), drops(0), shed(0), detached(false),
+      metrics(std::move(metrics)) {}
+
+TcpClient::TcpClient(const TcpConfig& config, const std::string& name)
+    : m_config(config), m_name(name), m_framed(config.multiplex),
+      m_running(false), m_connected(false), m_socket(INVALID_SOCKET),
+      m_nextSource(0), m_sourcesChanged(false), m_pending(0),
+      m_sessions(0), m_session(0), m_windowBytes(0), m_replayFrame(0),
+      m_socketSent(0), m_spoolFull(false), m_spillRequested(false), m_spooledBytes(0) {
 #ifdef _WIN32
     WSADATA wsaData;
     WSAStartup(MAKEWORD(2, 2), &wsaData);
@@ -32,6 +166,19 @@ TcpClient::~TcpClient() {
 }
 
 void TcpClient::start() {
+    if (m_config.enabled && m_config.storeAndForward && !m_spool) {
+        auto mb = [](int value) { return static_cast<uint64_t>((std::max)(value, 1)) << 20; };
+        m_spool = std::make_unique<Spool>(std::filesystem::path("spool") / m_name,
+                                          mb(m_config.spoolSegmentMB), mb(m_config.spoolMaxMB));
+        if (m_spool->open()) {
+            m_replayBuffer.resize(kReplayBufferSize);
+            m_replayFrame = m_spool->readOffset();
+            m_spooledBytes = m_spool->pendingBytes();
+        } else {
+            m_spool.reset();
+        }
+    }
+
     m_running = true;
     m_connectThread = std::thread(&TcpClient::connectLoop, this);
     m_processThread = std::thread(&TcpClient::processQueue, this);
@@ -39,7 +186,8 @@ void TcpClient::start() {
 
 void TcpClient::stop() {
     m_running = false;
-    m_queueCV.notify_all();
+    m_queueSignal.notify();
+    m_connectSignal.notify();
     
     if (m_connectThread.joinable()) {
         m_connectThread.join();
@@ -49,36 +197,104 @@ void TcpClient::stop() {
     }
     
     disconnect();
+    if (m_spool) {
+        m_spool->close();
+    }
+    m_window.clear();
+    m_windowBytes = 0;
+    m_retransmit.clear();
+    m_spoolMarks.clear();
+}
+
+std::shared_ptr<TcpClient::Source> TcpClient::attach(uint16_t portId, const std::string& name,
+                                                     size_t capacity,
+                                                     std::shared_ptr<PortMetrics> metrics) {
+    auto source = std::make_shared<Source>(*this, portId, name, capacity, std::move(metrics));
+    std::lock_guard<std::mutex> lock(m_sourcesMutex);
+    m_sources.push_back(source);
+    m_sourcesChanged = true;
+    m_queueSignal.notify();
+    return source;
+}
+
+void TcpClient::detach(const std::shared_ptr<Source>& source) {
+    // 由发送线程取完剩余数据后移除
+    source->detached = true;
+    m_queueSignal.notify();
 }
 
-bool TcpClient::send(const std::string& data) {
+size_t TcpClient::activeSources() const {
+    std::lock_guard<std::mutex> lock(m_sourcesMutex);
+    return static_cast<size_t>(std::count_if(m_sources.begin(), m_sources.end(),
+        [](const std::shared_ptr<Source>& source) { return !source->detached; }));
+}
+
+bool TcpClient::send(Source& source, const ChunkRef& chunk) {
     if (!m_config.enabled) {
         return false;
     }
 
-    std::lock_guard<std::mutex> lock(m_queueMutex);
-    m_dataQueue.push(data);
-    m_queueCV.notify_one();
+    // 先计数再入队，保证发送线程减计数时不会下溢
+    ChunkRef ref(chunk);
+    m_pending.fetch_add(1, std::memory_order_relaxed);
+    if (!source.queue.push(std::move(ref))) {
+        m_pending.fetch_sub(1, std::memory_order_relaxed);
+        source.drops.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    m_queueSignal.notify();
     return true;
 }
 
-void TcpClient::clearQueue() {
-    std::lock_guard<std::mutex> lock(m_queueMutex);
-    std::queue<std::string> empty;
-    std::swap(m_dataQueue, empty);
+QueueStats TcpClient::queueStats(const Source& source) {
+    return { source.queue.size(), source.queue.highWater(), source.queue.capacity(),
+             source.drops.load(std::memory_order_relaxed) };
 }
 
 void TcpClient::connectLoop() {
+    // 指数退避：失败一次间隔加倍，直到 reconnectInterval；连接保持超过最长间隔后才重置
+    auto initialDelay = std::chrono::milliseconds((std::max)(m_config.reconnectInitialMs, 1));
+    auto maxDelay = (std::max)(initialDelay, std::chrono::milliseconds(
+        static_cast<long long>((std::max)(m_config.reconnectInterval, 0)) * 1000));
+    auto delay = initialDelay;
+    std::mt19937 random(std::random_device{}());
+    bool attempted = false;
+    bool wasConnected = false;
+    auto connectedAt = std::chrono::steady_clock::now();
+
     while (m_running) {
-        if (!m_connected) {
-            if (connect()) {
-                m_connected = true;
-            } else {
-                std::this_thread::sleep_for(
-                    std::chrono::seconds(m_config.reconnectInterval));
+        // 已连接时不轮询，由发送线程发现断线后唤醒
+        m_connectSignal.wait([this] { return !m_running || !m_connected; });
+        if (!m_running) {
+            break;
+        }
+        // 连接保持足够久才立即重连，否则（如对端接受后马上断开）同样退避
+        bool backoff = !wasConnected || std::chrono::steady_clock::now() - connectedAt < maxDelay;
+        if (wasConnected && !backoff) {
+            delay = initialDelay;
+        }
+        wasConnected = false;
+        if (backoff && attempted) {
+            // 在 [delay/2, delay] 内随机等待，避免大量客户端同时重连
+            std::uniform_int_distribution<long long> jitter(delay.count() / 2, delay.count());
+            m_connectSignal.waitFor([this] { return !m_running; },
+                                    std::chrono::milliseconds(jitter(random)));
+            delay = (std::min)(delay * 2, maxDelay);
+            if (!m_running) {
+                break;
             }
         }
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        attempted = true;
+
+        if (connect()) {
+            // 先更新连接序号，发送线程看到已连接时一定能看到新的序号
+            m_sessions.fetch_add(1);
+            m_connected = true;
+            wasConnected = true;
+            connectedAt = std::chrono::steady_clock::now();
+            // 唤醒发送线程补发积压数据
+            m_queueSignal.notify();
+        }
     }
 }
 
@@ -106,14 +322,72 @@ bool TcpClient::connect() {
     serverAddr.sin_port = htons(m_config.port);
     inet_pton(AF_INET, m_config.server.c_str(), &serverAddr.sin_addr);
 
+    // 非阻塞连接，最长等待 connectTimeoutMs，不受系统 SYN 重试超时影响
+    setNonBlocking(m_socket, true);
     if (::connect(m_socket, (sockaddr*)&serverAddr, sizeof(serverAddr)) == SOCKET_ERROR) {
-        disconnect();
-        return false;
+#ifdef _WIN32
+        bool pending = WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+        bool pending = errno == EINPROGRESS;
+#endif
+        auto deadline = std::chrono::steady_clock::now() +
+                        std::chrono::milliseconds((std::max)(m_config.connectTimeoutMs, 1));
+        int result = 0;
+        while (pending && result == 0 && m_running) {
+            long long left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now()).count();
+            if (left <= 0) {
+                break;
+            }
+            result = waitConnected(m_socket, static_cast<int>((std::min)(left,
+                static_cast<long long>(kConnectSliceMs))));
+        }
+        if (result != 1) {
+            disconnect();
+            return false;
+        }
     }
+    setNonBlocking(m_socket, false);
 
+    applySocketOptions();
     return true;
 }
 
+void TcpClient::applySocketOptions() {
+    int noDelay = m_config.noDelay ? 1 : 0;
+    setsockopt(m_socket, IPPROTO_TCP, TCP_NODELAY, (const char*)&noDelay, sizeof(noDelay));
+
+    // 空闲连接靠 keepalive 发现断线，有数据时靠发送错误和 TCP_USER_TIMEOUT
+    int keepAlive = m_config.keepAlive ? 1 : 0;
+    setsockopt(m_socket, SOL_SOCKET, SO_KEEPALIVE, (const char*)&keepAlive, sizeof(keepAlive));
+    if (m_config.keepAlive) {
+#ifdef TCP_KEEPIDLE
+        int idle = (std::max)(m_config.keepAliveIdle, 1);
+        setsockopt(m_socket, IPPROTO_TCP, TCP_KEEPIDLE, (const char*)&idle, sizeof(idle));
+#endif
+#ifdef TCP_KEEPINTVL
+        int interval = (std::max)(m_config.keepAliveInterval, 1);
+        setsockopt(m_socket, IPPROTO_TCP, TCP_KEEPINTVL, (const char*)&interval, sizeof(interval));
+#endif
+#ifdef TCP_KEEPCNT
+        int count = (std::max)(m_config.keepAliveCount, 1);
+        setsockopt(m_socket, IPPROTO_TCP, TCP_KEEPCNT, (const char*)&count, sizeof(count));
+#endif
+    }
+#ifdef TCP_USER_TIMEOUT
+    if (m_config.userTimeoutMs > 0) {
+        unsigned int userTimeout = static_cast<unsigned int>(m_config.userTimeoutMs);
+        setsockopt(m_socket, IPPROTO_TCP, TCP_USER_TIMEOUT, &userTimeout, sizeof(userTimeout));
+    }
+#endif
+#ifdef TCP_CORK
+    if (m_config.cork) {
+        int cork = 1;
+        setsockopt(m_socket, IPPROTO_TCP, TCP_CORK, &cork, sizeof(cork));
+    }
+#endif
+}
+
 void TcpClient::disconnect() {
     if (m_socket != INVALID_SOCKET) {
 #ifdef _WIN32
@@ -124,36 +398,530 @@ void TcpClient::disconnect() {
         m_socket = INVALID_SOCKET;
     }
     m_connected = false;
-    clearQueue();  // 断开连接时清空队列
+    m_connectSignal.notify();
 }
 
 void TcpClient::processQueue() {
+    // 只有本线程从队列取数据；未启用存储转发时，未连接期间数据留在队列中等待重连，队列满时由 send() 丢弃并计数
+    m_batch.reserve(kMaxBatchChunks);
+    m_batchSources.reserve(kMaxBatchChunks);
+    size_t maxBytes = static_cast<size_t>((std::max)(m_config.coalesceBytes, 1));
+    auto window = std::chrono::microseconds((std::max)(m_config.coalesceUs, 0));
+
     while (m_running) {
-        std::unique_lock<std::mutex> lock(m_queueMutex);
-        m_queueCV.wait(lock, [this] { 
-            return !m_running || !m_dataQueue.empty(); 
-        });
-
-        while (!m_dataQueue.empty() && m_connected) {
-            std::string data = m_dataQueue.front();
-            m_dataQueue.pop();
-            lock.unlock();
-
-            if (m_socket != INVALID_SOCKET) {
-                if (data.length() > static_cast<size_t>(INT_MAX)) {
-                    LOG_ERROR("TCP", "Data size exceeds maximum send limit");
-                    disconnect();
+        if (m_spool && m_connected && hasBacklog()) {
+            waitForBacklog();
+        } else {
+            m_queueSignal.wait([this] {
+                return !m_running ||
+                       (m_pending.load(std::memory_order_relaxed) > 0 && (m_spool || m_connected)) ||
+                       ((m_framed || m_spool) && m_sessions.load() != m_session) ||
+                       (m_framed && m_connected && m_sourcesChanged);
+            });
+        }
+
+        // 新连接：重新计算字节流位置，多路复用时先发送所有串口的名称
+        if (m_connected && m_sessions.load() != m_session) {
+            m_session = m_sessions.load();
+            m_socketSent = 0;
+            m_sourcesChanged = true;
+        }
+        if (m_framed && m_connected && m_sourcesChanged.exchange(false) && !announcePorts()) {
+            if (m_spool) {
+                handleSendError();
+            } else {
+                LOG_ERROR("TCP", m_name + ": failed to send port names");
+                disconnect();
+            }
+        }
+
+        // 一次取出队列中的全部数据块，凑批窗口内继续等待后续数据
+        if (!m_spool && !m_connected) {
+            continue;
+        }
+        size_t bytes = collectBatch(0);
+        if (bytes > 0 && window.count() > 0) {
+            auto deadline = std::chrono::steady_clock::now() + window;
+            while (m_running && bytes < maxBytes && m_batch.size() < kMaxBatchChunks) {
+                auto now = std::chrono::steady_clock::now();
+                if (now >= deadline) {
                     break;
                 }
-                int result = ::send(m_socket, data.c_str(), static_cast<int>(data.length()), 0);
-                if (result == SOCKET_ERROR) {
-                    LOG_ERROR("TCP", "Send timeout or error, clearing queue");
-                    disconnect();  // 这会清空队列
-                    break;  // 跳出发送循环
-                }
+                m_queueSignal.waitFor([this] {
+                    return !m_running || m_pending.load(std::memory_order_relaxed) > 0;
+                }, deadline - now);
+                bytes = collectBatch(bytes);
+            }
+        }
+
+        if (m_spool) {
+            forwardWithSpool();
+            m_batch.clear();
+            m_batchSources.clear();
+            continue;
+        }
+        if (m_batch.empty()) {
+            continue;
+        }
+
+        if (!m_connected || m_socket == INVALID_SOCKET) {
+            dropBatch(0);
+        } else if (!sendBatch()) {
+            LOG_ERROR("TCP", m_name + ": send timeout or error, dropping queued data");
+            dropBatch(0);
+            disconnect();
+        } else {
+            recordSent(0, m_batch.size());
+        }
+        m_batch.clear();
+        m_batchSources.clear();
+    }
+
+    if (m_spool) {
+        drainToSpool();
+    }
+}
+
+size_t TcpClient::collectBatch(size_t bytes) {
+    size_t maxBytes = static_cast<size_t>((std::max)(m_config.coalesceBytes, 1));
+    std::lock_guard<std::mutex> lock(m_sourcesMutex);
+
+    // 已停止且取空的串口在批次为空时移除，m_batchSources 中不会留下悬空指针
+    if (m_batch.empty()) {
+        m_sources.erase(std::remove_if(m_sources.begin(), m_sources.end(),
+            [](const std::shared_ptr<Source>& source) {
+                return source->detached && source->queue.empty();
+            }), m_sources.end());
+    }
+
+    size_t count = m_sources.size();
+    size_t popped = 0;
+    ChunkRef chunk;
+    for (size_t n = 0; n < count; ++n) {
+        Source& source = *m_sources[(m_nextSource + n) % count];
+        while (bytes < maxBytes && m_batch.size() < kMaxBatchChunks && source.queue.pop(chunk)) {
+            ++popped;
+            if (source.shed.load(std::memory_order_relaxed) > 0) {
+                // 超出内存预算丢弃最旧的数据块（已由采集器计数）
+                source.shed.fetch_sub(1, std::memory_order_relaxed);
+                chunk.reset();
+                continue;
+            }
+            if (m_framed) {
+                // 帧头写入数据区前的预留区，与数据一起连续发送、写入磁盘队列
+                FrameHeader header = { FrameType::Data, source.portId,
+                    static_cast<uint32_t>(chunk.size()), chunk.sequence(),
+                    static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        chunk.time().time_since_epoch()).count()) };
+                encodeFrameHeader(header, chunk.headroom(kFrameHeaderSize));
+            }
+            bytes += wireSize(chunk);
+            m_batch.push_back(std::move(chunk));
+            m_batchSources.push_back(&source);
+        }
+    }
+    if (count > 0) {
+        m_nextSource = (m_nextSource + 1) % count;
+    }
+    m_pending.fetch_sub(popped, std::memory_order_relaxed);
+    return bytes;
+}
+
+const char* TcpClient::wireData(const ChunkRef& chunk) const {
+    return m_framed ? chunk.headroom(kFrameHeaderSize) : chunk.data();
+}
+
+size_t TcpClient::wireSize(const ChunkRef& chunk) const {
+    return chunk.size() + (m_framed ? kFrameHeaderSize : 0);
+}
+
+// m_batch 中 [first, end) 的数据块已全部交给内核
+void TcpClient::recordSent(size_t first, size_t end) {
+    auto now = WallClock::fromSteady(std::chrono::steady_clock::now());
+    for (size_t i = first; i < end; ++i) {
+        PortMetrics* metrics = m_batchSources[i]->metrics.get();
+        if (metrics) {
+            metrics->tcpBytes.add(m_batch[i].size());
+            metrics->tcpLatency.record(now - m_batch[i].time());
+        }
+    }
+}
+
+void TcpClient::dropBatch(size_t first) {
+    for (size_t i = first; i < m_batchSources.size(); ++i) {
+        m_batchSources[i]->drops.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+bool TcpClient::announcePorts() {
+    std::vector<char> frames;
+    {
+        std::lock_guard<std::mutex> lock(m_sourcesMutex);
+        for (const auto& source : m_sources) {
+            if (source->detached) {
+                continue;
+            }
+            FrameHeader header = { FrameType::PortName, source->portId,
+                                   static_cast<uint32_t>(source->name.size()), 0, 0 };
+            size_t offset = frames.size();
+            frames.resize(offset + kFrameHeaderSize + source->name.size());
+            encodeFrameHeader(header, frames.data() + offset);
+            std::copy(source->name.begin(), source->name.end(),
+                      frames.begin() + offset + kFrameHeaderSize);
+        }
+    }
+
+    size_t offset = 0;
+    while (offset < frames.size()) {
+        IoVec iov;
+        setIoVec(iov, frames.data() + offset, frames.size() - offset);
+        long long sent = sendSome(m_socket, &iov, 1);
+        if (sent < 0) {
+            return false;
+        }
+        if (sent == 0 && !waitWritable(m_socket, 2000)) {
+            return false;
+        }
+        offset += static_cast<size_t>(sent);
+        m_socketSent += static_cast<uint64_t>(sent);
+    }
+    uncork();
+    return true;
+}
+
+bool TcpClient::sendBatch() {
+#ifdef _WIN32
+    std::vector<WSABUF> buffers(m_batch.size());
+    for (size_t i = 0; i < m_batch.size(); ++i) {
+        setIoVec(buffers[i], wireData(m_batch[i]), wireSize(m_batch[i]));
+    }
+    DWORD sent = 0;
+    // 阻塞套接字上 WSASend 会发送全部数据或返回错误
+    return WSASend(m_socket, buffers.data(), static_cast<DWORD>(buffers.size()),
+                   &sent, 0, NULL, NULL) != SOCKET_ERROR;
+#else
+    iovec iov[kMaxBatchChunks];
+    size_t count = m_batch.size();
+    for (size_t i = 0; i < count; ++i) {
+        setIoVec(iov[i], wireData(m_batch[i]), wireSize(m_batch[i]));
+    }
+
+    // 一次 sendmsg 发送整批数据，部分发送时跳过已发送的分段继续
+    iovec* next = iov;
+    while (count > 0) {
+        msghdr msg = {};
+        msg.msg_iov = next;
+        msg.msg_iovlen = count;
+        ssize_t sent = ::sendmsg(m_socket, &msg, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+
+        size_t remaining = static_cast<size_t>(sent);
+        while (count > 0 && remaining >= next->iov_len) {
+            remaining -= next->iov_len;
+            ++next;
+            --count;
+        }
+        if (count > 0) {
+            next->iov_base = static_cast<char*>(next->iov_base) + remaining;
+            next->iov_len -= remaining;
+        }
+    }
+
+    uncork();
+    return true;
+#endif
+}
+
+void TcpClient::uncork() {
+#ifdef TCP_CORK
+    if (m_config.cork) {
+        // 解除再恢复 TCP_CORK，立即推出本批末尾不足一个报文段的数据
+        int cork = 0;
+        setsockopt(m_socket, IPPROTO_TCP, TCP_CORK, &cork, sizeof(cork));
+        cork = 1;
+        setsockopt(m_socket, IPPROTO_TCP, TCP_CORK, &cork, sizeof(cork));
+    }
+#endif
+}
+
+// 存储转发：连接正常且没有积压时直接发送，已发送的数据块保留在内存窗口中直到对端确认；
+// 发不出去的数据追加到磁盘队列，重连后先重发断线时未确认的数据，再按顺序回放磁盘队列
+void TcpClient::forwardWithSpool() {
+    bool connected = m_connected && m_socket != INVALID_SOCKET;
+    if (connected) {
+        updateAcks();
+        if (!flushBacklog()) {
+            handleSendError();
+            connected = false;
+        }
+    }
+
+    size_t first = 0;
+    size_t offset = 0;
+    size_t windowLimit = static_cast<size_t>((std::max)(m_config.windowBytes, 1));
+    bool spill = m_spillRequested.exchange(false, std::memory_order_relaxed);
+    if (connected && !spill && !m_batch.empty() && !hasBacklog() && m_windowBytes < windowLimit) {
+        if (!sendDirect(first, offset)) {
+            handleSendError();
+        }
+    }
+    spoolBatch(first, offset);
+    m_spooledBytes.store(m_spool->pendingBytes(), std::memory_order_relaxed);
+}
+
+bool TcpClient::hasBacklog() const {
+    // 磁盘队列中的数据全部确认之前不直接发送，保证断线重发时的顺序
+    return !m_retransmit.empty() || m_spool->pendingBytes() > 0;
+}
+
+void TcpClient::waitForBacklog() {
+    if (m_retransmit.empty() && !m_spool->hasUnread()) {
+        // 数据已全部发出，等待对端确认
+        m_queueSignal.waitFor([this] { return !m_running; },
+                              std::chrono::milliseconds(kBacklogWaitMs));
+        return;
+    }
+    waitWritable(m_socket, kBacklogWaitMs);
+}
+
+uint64_t TcpClient::updateAcks() {
+    // 内核发送队列中的字节（未发送或未确认）之外，其余都已被对端确认
+    uint64_t acked = m_socketSent;
+#ifdef SIOCOUTQ
+    int queued = 0;
+    if (ioctl(m_socket, SIOCOUTQ, &queued) == 0 && queued > 0) {
+        acked -= (std::min)(static_cast<uint64_t>(queued), m_socketSent);
+    }
+#endif
+
+    while (!m_window.empty() && m_window.front().endPos <= acked) {
+        m_windowBytes -= m_window.front().to - m_window.front().from;
+        m_window.pop_front();
+    }
+    while (!m_spoolMarks.empty() && m_spoolMarks.front().socketPos <= acked) {
+        m_spool->acknowledge(m_spoolMarks.front().spoolOffset);
+        m_spoolMarks.pop_front();
+    }
+    return acked;
+}
+
+bool TcpClient::flushBacklog() {
+    IoVec iov[kMaxBatchChunks];
+    while (!m_retransmit.empty()) {
+        size_t count = (std::min)(m_retransmit.size(), kMaxBatchChunks);
+        size_t total = 0;
+        for (size_t i = 0; i < count; ++i) {
+            const Pending& pending = m_retransmit[i];
+            setIoVec(iov[i], wireData(pending.chunk) + pending.from, pending.to - pending.from);
+            total += pending.to - pending.from;
+        }
+
+        long long sent = sendSome(m_socket, iov, count);
+        if (sent < 0) {
+            return false;
+        }
+
+        // 已发出的部分移回发送窗口，等待确认
+        size_t remaining = static_cast<size_t>(sent);
+        while (remaining > 0) {
+            Pending& front = m_retransmit.front();
+            uint32_t part = static_cast<uint32_t>((std::min)(remaining, size_t(front.to - front.from)));
+            m_socketSent += part;
+            m_window.push_back({ front.chunk, front.from, front.from + part, m_socketSent });
+            m_windowBytes += part;
+            front.from += part;
+            remaining -= part;
+            if (front.from == front.to) {
+                m_retransmit.pop_front();
+            }
+        }
+        if (static_cast<size_t>(sent) < total) {
+            uncork();
+            return true;
+        }
+    }
+
+    while (m_spool->hasUnread()) {
+        uint64_t readOffset = m_spool->readOffset();
+        size_t size = m_spool->peek(m_replayBuffer.data(), m_replayBuffer.size());
+        if (size == 0) {
+            continue;
+        }
+        if (m_framed) {
+            size = findReplayFrames(readOffset, size);
+        }
+
+        setIoVec(iov[0], m_replayBuffer.data(), size);
+        long long sent = sendSome(m_socket, iov, 1);
+        if (sent < 0) {
+            return false;
+        }
+        m_spool->consume(static_cast<size_t>(sent));
+        m_socketSent += static_cast<uint64_t>(sent);
+
+        // 多路复用时只在已发出的最后一个帧边界处标记，对端确认半帧时磁盘队列不越过帧头
+        uint64_t position = m_spool->readOffset();
+        uint64_t boundary = position;
+        if (m_framed && !m_replayFrames.empty()) {
+            auto next = std::lower_bound(m_replayFrames.begin(), m_replayFrames.end(), position);
+            m_replayFrame = next != m_replayFrames.end() ? *next : position;
+            boundary = next != m_replayFrames.end() && *next == position ? position :
+                       next != m_replayFrames.begin() ? *(next - 1) : readOffset;
+        }
+        if (boundary > readOffset || !m_framed) {
+            m_spoolMarks.push_back({ m_socketSent - (position - boundary), boundary });
+        }
+        if (static_cast<size_t>(sent) < size) {
+            break;
+        }
+    }
+    uncork();
+    return true;
+}
+
+bool TcpClient::sendDirect(size_t& first, size_t& offset) {
+    IoVec iov[kMaxBatchChunks];
+    for (size_t i = 0; i < m_batch.size(); ++i) {
+        setIoVec(iov[i], wireData(m_batch[i]), wireSize(m_batch[i]));
+    }
+
+    long long sent = sendSome(m_socket, iov, m_batch.size());
+    if (sent < 0) {
+        return false;
+    }
+
+    size_t remaining = static_cast<size_t>(sent);
+    while (first < m_batch.size() && remaining > 0) {
+        size_t size = wireSize(m_batch[first]);
+        size_t part = (std::min)(size, remaining);
+        m_socketSent += part;
+        m_window.push_back({ m_batch[first], 0, static_cast<uint32_t>(part), m_socketSent });
+        m_windowBytes += part;
+        remaining -= part;
+        if (part < size) {
+            offset = part;
+            break;
+        }
+        ++first;
+    }
+    recordSent(0, first);
+    if (m_framed && offset > 0) {
+        // 帧的其余部分不写入磁盘队列，留在重发列表中最先发送；断线时与已发送的部分合成整帧重发
+        m_retransmit.push_back({ m_batch[first], static_cast<uint32_t>(offset),
+                                 static_cast<uint32_t>(wireSize(m_batch[first])), 0 });
+        ++first;
+        offset = 0;
+    }
+    uncork();
+    return true;
+}
+
+void TcpClient::spoolBatch(size_t first, size_t offset) {
+    for (size_t i = first; i < m_batch.size(); ++i) {
+        size_t skip = i == first ? offset : 0;
+        if (!m_spool->append(wireData(m_batch[i]) + skip, wireSize(m_batch[i]) - skip)) {
+            dropBatch(i);
+            if (!m_spoolFull) {
+                LOG_ERROR("TCP", m_name + ": spool full, dropping data");
+                m_spoolFull = true;
+            }
+            return;
+        }
+    }
+    if (first < m_batch.size()) {
+        m_spoolFull = false;
+    }
+}
+
+void TcpClient::handleSendError() {
+    LOG_ERROR("TCP", m_name + ": send error, unacknowledged data will be resent after reconnect");
+
+    requeueUnacked();
+    disconnect();
+}
+
+void TcpClient::requeueUnacked() {
+    // 窗口中未确认的部分放到重发列表最前面；磁盘队列回退到确认位置
+    // 连接已关闭时无法查询确认位置，窗口全部重发
+    uint64_t acked = m_socket != INVALID_SOCKET ? updateAcks() : 0;
+    for (auto it = m_window.rbegin(); it != m_window.rend(); ++it) {
+        Pending pending = *it;
+        uint64_t start = pending.endPos - (pending.to - pending.from);
+        if (start < acked && !m_framed) {
+            pending.from += static_cast<uint32_t>(acked - start);
+        }
+        m_retransmit.push_front(pending);
+    }
+    if (m_framed) {
+        // 接收端在新连接上从帧头开始解析，断线时收到的半帧已被丢弃：
+        // 前一部分已确认（或已从窗口移除）的帧整帧重发
+        const char* chunk = nullptr;
+        uint32_t end = 0;
+        for (Pending& pending : m_retransmit) {
+            if (pending.chunk.data() != chunk || pending.from != end) {
+                pending.from = 0;
             }
+            chunk = pending.chunk.data();
+            end = pending.to;
+        }
+    }
+    m_window.clear();
+    m_windowBytes = 0;
+    m_spoolMarks.clear();
+    m_spool->rewind();
+    m_replayFrame = m_spool->readOffset();
+}
 
-            lock.lock();
+size_t TcpClient::findReplayFrames(uint64_t readOffset, size_t size) {
+    // 磁盘队列按整帧追加，读取位置回退时总是回到帧边界；从 m_replayFrame 起逐个解析帧头，
+    // 返回可发送的长度：到最后一个帧头完整的帧为止，帧头跨越缓冲区末尾的帧留到下次读取
+    m_replayFrames.clear();
+    m_replayFrame = (std::max)(m_replayFrame, readOffset);  // 跳过了无法读取的段，段尾是帧边界
+    uint64_t end = readOffset + size;
+    uint64_t frame = m_replayFrame;
+    while (frame + kFrameHeaderSize <= end) {
+        FrameHeader header;
+        if (!decodeFrameHeader(m_replayBuffer.data() + (frame - readOffset), header)) {
+            LOG_ERROR("TCP", m_name + ": spool data at offset " + std::to_string(frame) +
+                      " is not a frame, sending it unframed");
+            m_replayFrames.clear();
+            return size;
         }
+        m_replayFrames.push_back(frame);
+        frame += kFrameHeaderSize + header.length;
+    }
+    m_replayFrames.push_back(frame);
+    if (frame >= end || frame == readOffset) {
+        // 最后一帧的负载跨越缓冲区末尾，或者段在帧头中间结束（数据不完整）
+        return size;
     }
-} 
\ No newline at end of file
+    return static_cast<size_t>(frame - readOffset);
+}
+
+void TcpClient::drainToSpool() {
+    // 退出时队列中剩余的数据写入磁盘队列，下次启动后补发
+    while (collectBatch(0) > 0) {
+        spoolBatch(0, 0);
+        m_batch.clear();
+        m_batchSources.clear();
+    }
+
+    // 已发送但未确认的数据（可能还在内核发送队列中）和断线时未确认的数据早于磁盘队列中的全部数据，
+    // 写到队列最前面；从磁盘队列回放而未确认的部分随 rewind() 留在队列中
+    requeueUnacked();
+    std::vector<char> unacked;
+    for (const Pending& pending : m_retransmit) {
+        unacked.insert(unacked.end(), wireData(pending.chunk) + pending.from,
+                       wireData(pending.chunk) + pending.to);
+    }
+    m_retransmit.clear();
+    if (!m_spool->prepend(unacked.data(), unacked.size())) {
+        LOG_ERROR("TCP", m_name + ": " + std::to_string(unacked.size()) +
+                  " unacknowledged bytes could not be saved before exit");
+    }
+}
@@ -1,31 +1,104 @@
 #pragma once
 #include "Common.h"
+#include "Chunk.h"
+#include "SpscRing.h"
+#include "Spool.h"
+#include "Metrics.h"
 #include <mutex>
 #include <atomic>
+#include <deque>
+#include <memory>
+#include <string>
 #include <thread>
-#include <queue>
-#include <condition_variable>
+#include <vector>
 
+// 一个 TCP 连接，承载一个或多个串口的数据
+// 多路复用模式下每个数据块带帧头（见 Frame.h），否则按原始字节流转发
 class TcpClient {
 public:
-    TcpClient(const TcpConfig& config);
+    // 一个串口到发送线程的通道
+    struct Source {
+        Source(TcpClient& client, uint16_t portId, const std::string& name, size_t capacity,
+               std::shared_ptr<PortMetrics> metrics);
+
+        TcpClient& client;
+        uint16_t portId;
+        std::string name;
+        SpscRing<ChunkRef> queue;
+        std::atomic<uint64_t> drops;
+        std::atomic<uint64_t> shed;  // 超出内存预算时（dropOldest）发送线程待丢弃的最旧数据块数
+        std::atomic<bool> detached;  // 生产者已停止，发送线程取完剩余数据后移除
+        std::shared_ptr<PortMetrics> metrics;  // 发送字节数和延迟
+    };
+
+    // name 用于日志和存储转发目录 spool/<name>
+    TcpClient(const TcpConfig& config, const std::string& name);
     ~TcpClient();
 
     void start();
     void stop();
-    bool send(const std::string& data);
+
+    std::shared_ptr<Source> attach(uint16_t portId, const std::string& name, size_t capacity,
+                                   std::shared_ptr<PortMetrics> metrics);
+    // 调用前生产者必须已停止；队列中剩余的数据仍会被发送或写入磁盘队列
+    void detach(const std::shared_ptr<Source>& source);
+    size_t activeSources() const;
+
+    bool send(Source& source, const ChunkRef& chunk);  // 每个 Source 单生产者调用，只增加引用计数；队列满时丢弃并返回 false
+    static QueueStats queueStats(const Source& source);
+    uint64_t spooledBytes() const { return m_spooledBytes.load(std::memory_order_relaxed); }
+    uint64_t connects() const { return m_sessions.load(std::memory_order_relaxed); }
+    // 超出内存预算（spill）：下一批数据不直接发送，全部写入磁盘队列，尽快释放内存中的数据块
+    bool canSpill() const { return m_config.storeAndForward; }
+    // 上一次请求还没被发送线程取走时返回 false
+    bool requestSpill() { return !m_spillRequested.exchange(true, std::memory_order_relaxed); }
 
 private:
     void connectLoop();
     bool connect();
     void disconnect();
     void processQueue();
-    void clearQueue();
+    size_t collectBatch(size_t bytes);
+    bool sendBatch();
+    void dropBatch(size_t first);
+    void recordSent(size_t first, size_t end);
+    void applySocketOptions();
+    bool announcePorts();
+    void uncork();
+
+    // 线上的字节：多路复用时包括数据区前就地写入的帧头
+    const char* wireData(const ChunkRef& chunk) const;
+    size_t wireSize(const ChunkRef& chunk) const;
+
+    // 存储转发模式，均只在 processQueue 线程中调用
+    struct Pending {
+        ChunkRef chunk;
+        uint32_t from;    // 数据块线上字节中待发送/已发送的范围 [from, to)
+        uint32_t to;
+        uint64_t endPos;  // 发送后在当前连接字节流中的结束位置
+    };
+    struct SpoolMark {
+        uint64_t socketPos;    // 连接字节流位置
+        uint64_t spoolOffset;  // 对应的 spool 读取位置
+    };
+    void forwardWithSpool();
+    bool hasBacklog() const;
+    void waitForBacklog();
+    uint64_t updateAcks();
+    bool flushBacklog();
+    size_t findReplayFrames(uint64_t readOffset, size_t size);
+    bool sendDirect(size_t& first, size_t& offset);
+    void spoolBatch(size_t first, size_t offset);
+    void handleSendError();
+    void requeueUnacked();
+    void drainToSpool();
 
     TcpConfig m_config;
+    std::string m_name;
+    bool m_framed;
     std::atomic<bool> m_running;
     std::atomic<bool> m_connected;
-    
+
 #ifdef _WIN32
     unsigned long long m_socket;
 #else
@@ -34,7 +107,30 @@ private:
 
     std::thread m_connectThread;
     std::thread m_processThread;
-    std::queue<std::string> m_dataQueue;
-    std::mutex m_queueMutex;
-    std::condition_variable m_queueCV;
-}; 
\ No newline at end of file
+
+    mutable std::mutex m_sourcesMutex;
+    std::vector<std::shared_ptr<Source>> m_sources;
+    size_t m_nextSource;                 // 轮流从各串口开始取数据，避免繁忙串口饿死其他串口
+    std::atomic<bool> m_sourcesChanged;  // 多路复用时需要重新发送串口名称
+    std::atomic<size_t> m_pending;       // 所有串口队列中的数据块总数
+    WakeSignal m_queueSignal;
+    WakeSignal m_connectSignal;          // 断线或停止时唤醒连接线程
+    std::vector<ChunkRef> m_batch;       // 以下仅由 processQueue 线程使用
+    std::vector<Source*> m_batchSources; // m_batch 中每个数据块所属的串口
+
+    std::atomic<uint64_t> m_sessions;  // 每次连接成功加一
+    uint64_t m_session;
+    std::unique_ptr<Spool> m_spool;
+    std::deque<Pending> m_window;      // 已发送但对端尚未确认的数据
+    size_t m_windowBytes;
+    std::deque<Pending> m_retransmit;  // 断线时未确认、重连后需先重发的数据
+    std::deque<SpoolMark> m_spoolMarks;
+    std::vector<char> m_replayBuffer;
+    // 多路复用时磁盘队列中是连续的帧，确认位置只落在帧边界上，断线后从帧头开始重发
+    uint64_t m_replayFrame;                // 不小于读取位置的下一个帧起始位置
+    std::vector<uint64_t> m_replayFrames;  // 本次读取的数据中各帧的起始位置
+    uint64_t m_socketSent;             // 当前连接已交给内核的字节数
+    bool m_spoolFull;
+    std::atomic<bool> m_spillRequested;
+    std::atomic<uint64_t> m_spooledBytes;
+};
\ No newline at end of file
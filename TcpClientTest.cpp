@@ -0,0 +1,340 @@
+// 多路复用 + 存储转发的断线重发测试：本地接收端在帧之间或帧中间断开连接，或者采集端在数据积压时退出后重启，
+// 检查新连接上的字节流从帧头开始、能被 FrameDecoder 完整解析，且从接收端收到的最后一个完整帧之后没有丢失数据
+// 接收端用很小的接收缓冲区并暂停读取，使对端确认位置停在帧中间
+// 用法: TcpClientTest，任何一项不符时返回 1
+#include "Chunk.h"
+#include "FrameDecoder.h"
+#include "TcpClient.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr uint16_t kPortId = 1;
+constexpr size_t kPayload = 333;  // 帧长 357，与缓冲区大小错开，确认位置几乎总在帧中间
+constexpr uint64_t kChunks = 3000;
+constexpr uint64_t kLateChunks = 100;  // 断开后才产生的数据
+constexpr size_t kFrameSize = kFrameHeaderSize + kPayload;
+
+int g_failures = 0;
+
+void check(bool ok, const std::string& name, const std::string& what) {
+    if (!ok) {
+        std::cerr << "FAIL " << name << ": " << what << std::endl;
+        ++g_failures;
+    }
+}
+
+char payloadByte(uint64_t sequence, size_t i) {
+    return static_cast<char>(sequence * 7 + i);
+}
+
+// 解析一个连接上收到的字节流，记录完整的数据帧序号
+struct Stream {
+    FrameDecoder decoder;
+    bool ok = true;
+    bool intact = true;        // 负载与序号一致
+    bool startsWithName = true; // 第一帧是串口名称
+    size_t frames = 0;
+    std::vector<uint64_t> sequences;
+
+    void feed(const char* data, size_t size) {
+        if (!ok) {
+            return;
+        }
+        ok = decoder.feed(data, size, [this](const FrameHeader& header, const char* payload) {
+            if (frames++ == 0 && header.type != FrameType::PortName) {
+                startsWithName = false;
+            }
+            if (header.type != FrameType::Data) {
+                return;
+            }
+            bool same = header.portId == kPortId && header.length == kPayload;
+            for (size_t i = 0; same && i < kPayload; ++i) {
+                same = payload[i] == payloadByte(header.sequence, i);
+            }
+            intact = intact && same;
+            sequences.push_back(header.sequence);
+        });
+    }
+};
+
+class Listener {
+public:
+    ~Listener() {
+        if (m_fd >= 0) {
+            ::close(m_fd);
+        }
+    }
+
+    // 接收缓冲区在 listen 前设置，accept 得到的连接继承
+    bool open(int receiveBuffer) {
+        m_fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        int one = 1;
+        setsockopt(m_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        setsockopt(m_fd, SOL_SOCKET, SO_RCVBUF, &receiveBuffer, sizeof(receiveBuffer));
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t length = sizeof(addr);
+        if (::bind(m_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(m_fd, 4) != 0 ||
+            getsockname(m_fd, reinterpret_cast<sockaddr*>(&addr), &length) != 0) {
+            return false;
+        }
+        m_port = ntohs(addr.sin_port);
+        return true;
+    }
+
+    int accept(int timeoutMs) {
+        pollfd fd = { m_fd, POLLIN, 0 };
+        if (::poll(&fd, 1, timeoutMs) <= 0) {
+            return -1;
+        }
+        return ::accept(m_fd, nullptr, nullptr);
+    }
+
+    int port() const { return m_port; }
+
+private:
+    int m_fd = -1;
+    int m_port = 0;
+};
+
+// 读满 size 字节
+bool readExactly(int fd, char* buffer, size_t size) {
+    while (size > 0) {
+        pollfd pfd = { fd, POLLIN, 0 };
+        if (::poll(&pfd, 1, 5000) <= 0) {
+            return false;
+        }
+        ssize_t count = ::recv(fd, buffer, size, 0);
+        if (count <= 0) {
+            return false;
+        }
+        buffer += count;
+        size -= static_cast<size_t>(count);
+    }
+    return true;
+}
+
+// 读到序号 last 或空闲 idleMs 为止
+void readUntil(int fd, Stream& stream, uint64_t last, int idleMs) {
+    std::vector<char> buffer(64 * 1024);
+    while (stream.ok && (stream.sequences.empty() || stream.sequences.back() < last)) {
+        pollfd pfd = { fd, POLLIN, 0 };
+        if (::poll(&pfd, 1, idleMs) <= 0) {
+            return;
+        }
+        ssize_t count = ::recv(fd, buffer.data(), buffer.size(), 0);
+        if (count <= 0) {
+            return;
+        }
+        stream.feed(buffer.data(), static_cast<size_t>(count));
+    }
+}
+
+// 接收缓冲区中已到达（已被内核确认）但尚未读取的数据
+std::vector<char> peekQueued(int fd) {
+    int queued = 0;
+    ioctl(fd, FIONREAD, &queued);
+    std::vector<char> data(static_cast<size_t>(queued > 0 ? queued : 0));
+    ssize_t count = ::recv(fd, data.data(), data.size(), MSG_PEEK | MSG_DONTWAIT);
+    data.resize(count > 0 ? static_cast<size_t>(count) : 0);
+    return data;
+}
+
+TcpConfig makeConfig(int port) {
+    TcpConfig config{};
+    config.enabled = true;
+    config.server = "127.0.0.1";
+    config.port = port;
+    config.reconnectInterval = 1;
+    config.reconnectInitialMs = 20;
+    config.connectTimeoutMs = 1000;
+    config.coalesceBytes = 64 * 1024;
+    config.noDelay = true;
+    config.storeAndForward = true;
+    config.spoolSegmentMB = 1;
+    config.spoolMaxMB = 64;
+    config.windowBytes = 4 * 1024 * 1024;
+    config.multiplex = true;
+    config.portId = kPortId;
+    return config;
+}
+
+void sendChunks(TcpClient& client, TcpClient::Source& source, ChunkPool& pool, uint64_t from, uint64_t to) {
+    for (uint64_t sequence = from; sequence < to; ++sequence) {
+        ChunkRef chunk = pool.acquire();
+        for (size_t i = 0; i < kPayload; ++i) {
+            chunk.data()[i] = payloadByte(sequence, i);
+        }
+        chunk.setSize(kPayload);
+        chunk.setSequence(sequence);
+        chunk.setTime(std::chrono::system_clock::now());
+        while (!client.send(source, chunk)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+}
+
+// 第一个连接上接收端收到（读取或仍在接收缓冲区中）的最后一个完整帧之后，新连接必须从帧头开始并连续收到其余全部数据
+void checkResent(const std::string& name, const Stream& first, const Stream& second) {
+    check(first.ok && first.intact, name, "first connection did not decode");
+    check(second.ok, name, "resent stream does not start on a frame boundary");
+    check(second.startsWithName, name, "resent stream does not start with the port name");
+    check(second.intact, name, "resent frame payload corrupted");
+    uint64_t received = first.sequences.empty() ? 0 : first.sequences.back() + 1;
+    if (second.sequences.empty()) {
+        check(received == kChunks, name, "nothing resent after sequence " + std::to_string(received));
+        return;
+    }
+    check(second.sequences.front() <= received, name,
+          "lost sequences " + std::to_string(received) + " to " + std::to_string(second.sequences.front()));
+    for (size_t i = 1; i < second.sequences.size(); ++i) {
+        if (second.sequences[i] != second.sequences[i - 1] + 1) {
+            check(false, name, "gap after sequence " + std::to_string(second.sequences[i - 1]));
+            break;
+        }
+    }
+    check(second.sequences.back() == kChunks - 1, name,
+          "stopped at sequence " + std::to_string(second.sequences.back()));
+}
+
+// 接收端读到 cut 字节后关闭连接（连接复位），采集端重连后重发未确认的数据
+void testReconnect(const std::string& name, size_t cut) {
+    Listener listener;
+    if (!listener.open(16 * 1024)) {
+        check(false, name, "listen failed");
+        return;
+    }
+    std::unique_ptr<ChunkPool, ChunkPool::Retire> pool(new ChunkPool());
+    TcpClient client(makeConfig(listener.port()), name);
+    auto source = client.attach(kPortId, "p", kChunks, nullptr);
+    client.start();
+    sendChunks(client, *source, *pool, 0, kChunks - kLateChunks);
+
+    int first = listener.accept(5000);
+    if (first < 0) {
+        check(false, name, "no connection");
+        client.stop();
+        return;
+    }
+    // 暂停读取，接收窗口关闭，采集端的确认位置停在接收缓冲区末尾
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    Stream stream1;
+    std::vector<char> head(cut);
+    check(readExactly(first, head.data(), head.size()), name, "short read");
+    stream1.feed(head.data(), head.size());
+    std::vector<char> queued = peekQueued(first);
+    stream1.feed(queued.data(), queued.size());
+    ::close(first);
+    // 全部数据都已交给内核时采集端要等下一次发送才发现连接已断开
+    sendChunks(client, *source, *pool, kChunks - kLateChunks, kChunks);
+
+    int second = listener.accept(5000);
+    Stream stream2;
+    if (second >= 0) {
+        readUntil(second, stream2, kChunks - 1, 2000);
+        ::close(second);
+    } else {
+        check(false, name, "no reconnect");
+    }
+    checkResent(name, stream1, stream2);
+
+    client.detach(source);
+    client.stop();
+}
+
+// 数据积压时采集端退出：未确认的数据写入磁盘队列，重启后在新连接上从帧头开始重发
+void testRestart() {
+    const std::string name = "restart";
+    Listener listener;
+    if (!listener.open(16 * 1024)) {
+        check(false, name, "listen failed");
+        return;
+    }
+    std::unique_ptr<ChunkPool, ChunkPool::Retire> pool(new ChunkPool());
+    int first = -1;
+    {
+        TcpClient client(makeConfig(listener.port()), name);
+        auto source = client.attach(kPortId, "p", kChunks, nullptr);
+        client.start();
+        sendChunks(client, *source, *pool, 0, kChunks);
+        first = listener.accept(5000);
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        client.detach(source);
+        client.stop();
+    }
+    if (first < 0) {
+        check(false, name, "no connection");
+        return;
+    }
+    // 采集端关闭后内核仍会发出发送缓冲区中的数据，这部分算作已收到
+    Stream stream1;
+    readUntil(first, stream1, kChunks - 1, 300);
+    ::close(first);
+
+    TcpClient client(makeConfig(listener.port()), name);
+    auto source = client.attach(kPortId, "p", kChunks, nullptr);
+    client.start();
+    int second = listener.accept(5000);
+    Stream stream2;
+    if (second >= 0) {
+        readUntil(second, stream2, kChunks - 1, 2000);
+        ::close(second);
+    } else {
+        check(false, name, "no reconnect");
+    }
+    checkResent(name, stream1, stream2);
+    client.detach(source);
+    client.stop();
+}
+
+} // namespace
+
+void onTimeout(int) {
+    const char message[] = "FAIL timed out\n";
+    ssize_t ignored = ::write(STDERR_FILENO, message, sizeof(message) - 1);
+    (void)ignored;
+    std::_Exit(1);
+}
+
+int main() {
+    signal(SIGALRM, onTimeout);
+    signal(SIGPIPE, SIG_IGN);
+    alarm(60);
+
+    // 磁盘队列写在当前目录的 spool/<name> 下
+    std::error_code ec;
+    auto dir = std::filesystem::temp_directory_path() / ("TcpClientTest." + std::to_string(getpid()));
+    std::filesystem::create_directories(dir, ec);
+    std::filesystem::current_path(dir, ec);
+
+    const size_t nameFrame = kFrameHeaderSize + 1;
+    testReconnect("between frames", nameFrame + 2 * kFrameSize);
+    testReconnect("middle of a frame", nameFrame + 2 * kFrameSize + kFrameSize / 2);
+    testRestart();
+
+    std::filesystem::current_path(std::filesystem::temp_directory_path(), ec);
+    std::filesystem::remove_all(dir, ec);
+    if (g_failures > 0) {
+        std::cerr << g_failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All 3 reconnect cases passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,94 @@
+#include "Timestamp.h"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+constexpr int64_t kCalibrateIntervalNs = 1000000000;
+constexpr int kCalibrateSamples = 3;
+
+std::atomic<int64_t> g_offsetNs{ 0 };  // 系统时间 - steady 时间
+std::atomic<int64_t> g_nextCalibrationNs{ 0 };
+
+int64_t steadyNs(std::chrono::steady_clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+int64_t systemNs(std::chrono::system_clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+} // namespace
+
+void WallClock::calibrate() {
+    // 系统时间取在两次 steady 读数之间，按中点对应；取间隔最短（未被调度打断）的一次
+    int64_t best = std::numeric_limits<int64_t>::max();
+    int64_t offset = 0;
+    for (int i = 0; i < kCalibrateSamples; ++i) {
+        int64_t before = steadyNs(std::chrono::steady_clock::now());
+        int64_t system = systemNs(std::chrono::system_clock::now());
+        int64_t after = steadyNs(std::chrono::steady_clock::now());
+        if (after - before < best) {
+            best = after - before;
+            offset = system - (before + (after - before) / 2);
+        }
+    }
+    g_offsetNs.store(offset, std::memory_order_relaxed);
+    g_nextCalibrationNs.store(steadyNs(std::chrono::steady_clock::now()) + kCalibrateIntervalNs,
+                              std::memory_order_relaxed);
+}
+
+std::chrono::system_clock::time_point WallClock::fromSteady(std::chrono::steady_clock::time_point time) {
+    // 第一次使用前完成校准，之后由到期后第一个调用的线程重新校准
+    static const bool calibrated = (calibrate(), true);
+    (void)calibrated;
+
+    int64_t now = steadyNs(time);
+    int64_t next = g_nextCalibrationNs.load(std::memory_order_relaxed);
+    if (now >= next &&
+        g_nextCalibrationNs.compare_exchange_strong(next, now + kCalibrateIntervalNs,
+                                                    std::memory_order_relaxed)) {
+        calibrate();
+    }
+    auto wall = std::chrono::nanoseconds(now + g_offsetNs.load(std::memory_order_relaxed));
+    return std::chrono::system_clock::time_point(
+        std::chrono::duration_cast<std::chrono::system_clock::duration>(wall));
+}
+
+TimestampFormatter::TimestampFormatter(TimestampPrecision precision)
+    : m_precision(precision), m_second(0), m_cachedLen(0) {}
+
+size_t TimestampFormatter::format(std::chrono::system_clock::time_point time, char* out) {
+    int64_t ns = systemNs(time);
+    int64_t fraction = ns % 1000000000;
+    if (fraction < 0) {
+        fraction += 1000000000;
+    }
+    time_t second = static_cast<time_t>((ns - fraction) / 1000000000);
+
+    if (second != m_second || m_cachedLen == 0) {
+        struct tm timeinfo;
+        localtime_s(&timeinfo, &second);
+        m_cachedLen = std::strftime(m_cached, sizeof(m_cached), "[%Y-%m-%d %H:%M:%S", &timeinfo);
+        m_second = second;
+    }
+
+    std::memcpy(out, m_cached, m_cachedLen);
+    size_t length = m_cachedLen;
+    int digits = m_precision == TimestampPrecision::Micro ? 6 :
+                 m_precision == TimestampPrecision::Milli ? 3 : 0;
+    if (digits > 0) {
+        int64_t value = fraction / (digits == 6 ? 1000 : 1000000);
+        out[length] = '.';
+        for (int i = digits; i > 0; --i) {
+            out[length + i] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        }
+        length += digits + 1;
+    }
+    out[length++] = ']';
+    out[length++] = ' ';
+    return length;
+}
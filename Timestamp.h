@@ -0,0 +1,32 @@
+#pragma once
+#include "Common.h"
+#include <chrono>
+#include <cstddef>
+#include <ctime>
+
+// 单调时钟到系统时间的换算
+// 读取返回后立即记录 steady_clock，之后再换算成系统时间，不受读取线程后续处理和休眠的影响；
+// 两个时钟的差值每秒重新校准一次，系统时间被调整（NTP）后一秒内跟上
+class WallClock {
+public:
+    static std::chrono::system_clock::time_point fromSteady(std::chrono::steady_clock::time_point time);
+    static void calibrate();
+};
+
+// 文本格式的时间戳前缀，同一秒内复用已格式化的日期时间，只追加小数部分，
+// 每秒最多调用一次 localtime
+class TimestampFormatter {
+public:
+    static constexpr size_t kMaxLength = 40;
+
+    explicit TimestampFormatter(TimestampPrecision precision = TimestampPrecision::Second);
+
+    // 写入 "[2024-01-18 12:34:56.123] "（精度决定小数位数），out 至少 kMaxLength 字节，返回长度
+    size_t format(std::chrono::system_clock::time_point time, char* out);
+
+private:
+    TimestampPrecision m_precision;
+    time_t m_second;   // m_cached 对应的秒
+    char m_cached[32]; // "[2024-01-18 12:34:56"
+    size_t m_cachedLen;
+};
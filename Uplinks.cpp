@@ -0,0 +1,85 @@
+#include "Uplinks.h"
+#include "Logger.h"
+#include <filesystem>
+
+Uplinks::~Uplinks() {
+    stop();
+}
+
+std::shared_ptr<TcpClient::Source> Uplinks::attach(const PortConfig& config,
+                                                   std::shared_ptr<PortMetrics> metrics) {
+    const TcpConfig& tcp = config.tcpForward;
+    std::string portName = std::filesystem::path(config.name).filename().string();
+
+    // 连接的名称同时用作日志前缀和磁盘队列目录
+    std::string name = tcp.multiplex ? tcp.server + "_" + std::to_string(tcp.port) : portName;
+    std::string key = (tcp.multiplex ? "mux:" : "port:") + name;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_stopped.wait(lock, [this, &key] { return m_stopping.count(key) == 0; });
+    auto it = m_clients.find(key);
+    bool created = it == m_clients.end();
+    if (created) {
+        it = m_clients.emplace(key, std::make_unique<TcpClient>(tcp, name)).first;
+    }
+
+    auto source = it->second->attach(static_cast<uint16_t>(tcp.portId), config.name,
+                                     static_cast<size_t>(config.queueCapacity), std::move(metrics));
+    if (created) {
+        it->second->start();
+    }
+    return source;
+}
+
+void Uplinks::detach(const std::shared_ptr<TcpClient::Source>& source) {
+    std::vector<Client> stopping;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto it = m_clients.begin(); it != m_clients.end(); ++it) {
+            if (it->second.get() != &source->client) {
+                continue;
+            }
+            it->second->detach(source);
+            if (it->second->activeSources() == 0) {
+                m_stopping.insert(it->first);
+                stopping.emplace_back(it->first, std::move(it->second));
+                m_clients.erase(it);
+            }
+            break;
+        }
+    }
+    stopClients(stopping);
+}
+
+void Uplinks::stop() {
+    std::vector<Client> stopping;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto& client : m_clients) {
+            m_stopping.insert(client.first);
+            stopping.emplace_back(client.first, std::move(client.second));
+        }
+        m_clients.clear();
+    }
+    stopClients(stopping);
+}
+
+void Uplinks::stopClients(std::vector<Client>& clients) {
+    if (clients.empty()) {
+        return;
+    }
+    // 停止时发送线程把各串口剩余的数据发出或写入磁盘队列
+    for (auto& client : clients) {
+        client.second->stop();
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& client : clients) {
+        m_stopping.erase(client.first);
+    }
+    m_stopped.notify_all();
+}
+
+size_t Uplinks::connections() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_clients.size();
+}
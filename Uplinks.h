@@ -0,0 +1,41 @@
+#pragma once
+#include "SerialPort.h"
+#include "TcpClient.h"
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+// TCP 转发连接的管理：multiplex 的串口按 server:port 共用一个连接，
+// 其余串口各自一个连接。连接在第一个串口接入时创建，最后一个串口离开时关闭；
+// 共用连接的发送参数（凑批、存储转发等）取第一个接入串口的配置
+class Uplinks {
+public:
+    Uplinks() = default;
+    ~Uplinks();
+
+    Uplinks(const Uplinks&) = delete;
+    Uplinks& operator=(const Uplinks&) = delete;
+
+    std::shared_ptr<TcpClient::Source> attach(const PortConfig& config,
+                                              std::shared_ptr<PortMetrics> metrics);
+    // 调用前串口的读取必须已停止
+    void detach(const std::shared_ptr<TcpClient::Source>& source);
+    void stop();
+
+    size_t connections() const;
+
+private:
+    using Client = std::pair<std::string, std::unique_ptr<TcpClient>>;
+    void stopClients(std::vector<Client>& clients);
+
+    // TcpClient::stop() 要发完或保存剩余数据，可能需要几秒，在锁外调用；
+    // 正在停止的连接的 key 记在 m_stopping 中，同一连接的 attach() 等它停止后再新建（共用磁盘队列目录）
+    mutable std::mutex m_mutex;
+    std::condition_variable m_stopped;
+    std::map<std::string, std::unique_ptr<TcpClient>> m_clients;
+    std::set<std::string> m_stopping;
+};
@@ -1,286 +1,162 @@
 #include "SerialPort.h"
 #include "Config.h"
-#include "TcpClient.h"
+#include "PortCollector.h"
+#include "PortSet.h"
+#include "ConfigWatcher.h"
+#include "Uplinks.h"
+#include "Reactor.h"
 #include "Logger.h"
+#include "Scheduling.h"
+#include "MetricsServer.h"
+#include "StatusView.h"
+#include <algorithm>
 #include <iostream>
 #include <thread>
 #include <filesystem>
-#include <fstream>
 #include <chrono>
-#include <iomanip>
-#include <mutex>
-#include <sstream>
-#include <algorithm>
+#include <cstring>
 #include <vector>
 #include <memory>
+#include <atomic>
+#include <csignal>
 #ifdef _WIN32
 #include <windows.h>
-#endif
-
-#define _CRT_SECURE_NO_WARNINGS
-
-std::mutex console_mutex;
-std::vector<std::unique_ptr<bool>> portDataFlags;
-std::vector<std::chrono::steady_clock::time_point> lastDataTimes;
-
-// 颜色定义
-enum class Color {
-    Red = 12,
-    Yellow = 14,
-    Green = 10,
-    White = 15
-};
-
-// 设置控制台文本颜色
-void setTextColor(Color color) {
-#ifdef _WIN32
-    HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
-    SetConsoleTextAttribute(hConsole, static_cast<WORD>(color));
-#else
-    switch (color) {
-        case Color::Red:    std::cout << "\033[31m"; break;
-        case Color::Yellow: std::cout << "\033[33m"; break;
-        case Color::Green:  std::cout << "\033[32m"; break;
-        case Color::White:  std::cout << "\033[37m"; break;
-    }
-#endif
-}
-
-// 清除控制台
-void clearConsole() {
-#ifdef _WIN32
-    HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
-    COORD coordScreen = {0, 0};
-    DWORD cCharsWritten;
-    CONSOLE_SCREEN_BUFFER_INFO csbi;
-    DWORD dwConSize;
-
-    GetConsoleScreenBufferInfo(hConsole, &csbi);
-    dwConSize = csbi.dwSize.X * csbi.dwSize.Y;
-    FillConsoleOutputCharacter(hConsole, ' ', dwConSize, coordScreen, &cCharsWritten);
-    GetConsoleScreenBufferInfo(hConsole, &csbi);
-    FillConsoleOutputAttribute(hConsole, csbi.wAttributes, dwConSize, coordScreen, &cCharsWritten);
-    SetConsoleCursorPosition(hConsole, coordScreen);
+#include <io.h>
 #else
-    std::cout << "\033[2J\033[1;1H";
+#include <unistd.h>
 #endif
-}
 
-// 移动光标到指定位置
-void gotoxy(int x, int y) {
-#ifdef _WIN32
-    COORD coord;
-    coord.X = x;
-    coord.Y = y;
-    SetConsoleCursorPosition(GetStdHandle(STD_OUTPUT_HANDLE), coord);
-#else
-    printf("\033[%d;%dH", y + 1, x + 1);
-#endif
-}
+#define _CRT_SECURE_NO_WARNINGS
 
-std::string getDateString() {
-    auto now = std::chrono::system_clock::now();
-    auto time = std::chrono::system_clock::to_time_t(now);
-    struct tm timeinfo;
-    localtime_s(&timeinfo, &time);
-    
-    std::ostringstream oss;
-    oss << std::put_time(&timeinfo, "%Y%m%d");
-    return oss.str();
-}
+std::atomic<bool> g_running(true);
 
-bool isEmptyOrWhitespace(const std::vector<char>& buffer) {
-    return std::all_of(buffer.begin(), buffer.end(), 
-        [](char c) { return std::isspace(static_cast<unsigned char>(c)); });
+// 收到退出信号后停止状态显示循环，由 main 关闭各串口并刷新缓冲数据
+void onSignal(int) {
+    g_running = false;
 }
 
-// 添加数据速率统计结构
-struct PortStats {
-    size_t bytesReceived;
-    std::chrono::steady_clock::time_point lastUpdate;
-    double bytesPerSecond;
-    int packetsInLastSecond;
-    std::chrono::steady_clock::time_point lastPacketTime;
-    bool isActive;  // 添加活动状态标志
-};
-
-std::vector<PortStats> portStats;
-
-void displayStatus(const std::vector<PortConfig>& configs) {
-    // 初始化统计数据
-    portStats.resize(configs.size());
-    lastDataTimes.resize(configs.size());
-    auto now = std::chrono::steady_clock::now();
-    
-    for (size_t i = 0; i < configs.size(); ++i) {
-        portStats[i].bytesReceived = 0;
-        portStats[i].lastUpdate = now;
-        portStats[i].bytesPerSecond = 0.0;
-        portStats[i].packetsInLastSecond = 0;
-        portStats[i].lastPacketTime = now;
-        portStats[i].isActive = false;
-        lastDataTimes[i] = now;
+// 统计接口的内容：每个指标一组，组内按串口输出样本
+std::string renderMetrics(const PortSet& ports, const DiskWriter& diskWriter) {
+    PortSet::ReloadStats reload = ports.reloadStats();
+    auto portsLock = ports.lock();
+    const auto& collectors = ports.collectors();
+    std::vector<std::string> labels;
+    for (const auto& collector : collectors) {
+        labels.push_back(PrometheusText::label("port", collector->getConfig().name));
     }
 
-    while (true) {
-        {
-            std::lock_guard<std::mutex> lock(console_mutex);
-            clearConsole();
-
-            // 显示表头
-            setTextColor(Color::White);
-            std::cout << "Serial Port Collector v1.0.2" << std::endl;
-            std::cout << std::string(50, '-') << std::endl;
-            std::cout << std::setw(4) << "No."
-                      << std::setw(8) << "Port"
-                      << std::setw(10) << "Baud"
-                      << std::setw(12) << "Status"
-                      << std::setw(16) << "Speed(B/s)" << std::endl;
-            std::cout << std::string(50, '-') << std::endl;
-
-            // 显示每个串口的状态
-            for (size_t i = 0; i < configs.size(); ++i) {
-                std::cout << std::setw(4) << i + 1
-                          << std::setw(8) << configs[i].name
-                          << std::setw(10) << configs[i].baudRate;
-
-                auto currentTime = std::chrono::steady_clock::now();
-                auto timeSinceLastData = std::chrono::duration_cast<std::chrono::seconds>(
-                    currentTime - lastDataTimes[i]).count();
-
-                // 根据超时时间和活动状态判断显示状态
-                if (timeSinceLastData >= configs[i].timeout) {
-                    setTextColor(Color::Red);
-                    std::cout << std::setw(12) << "Offline";
-                    portStats[i].isActive = false;
-                    portStats[i].bytesPerSecond = 0.0;  // 清零速率
-                }
-                else if (portStats[i].isActive) {
-                    setTextColor(Color::Green);
-                    std::cout << std::setw(12) << "Active";
-                }
-                else {
-                    setTextColor(Color::Yellow);
-                    std::cout << std::setw(12) << "Waiting";
-                    portStats[i].bytesPerSecond = 0.0;  // 清零速率
-                }
-
-                setTextColor(Color::White);
-                std::cout << std::setw(16) << std::fixed << std::setprecision(1) 
-                          << portStats[i].bytesPerSecond << std::endl;
-            }
+    PrometheusText text;
+    auto counter = [&](const char* name, const char* help, auto value) {
+        text.family(name, "counter", help);
+        for (size_t i = 0; i < collectors.size(); ++i) {
+            text.sample(name, labels[i], static_cast<uint64_t>(value(*collectors[i])));
         }
-        std::this_thread::sleep_for(std::chrono::seconds(1));
-
-        // 检查每个端口的数据接收情况
-        for (size_t i = 0; i < configs.size(); ++i) {
-            auto currentTime = std::chrono::steady_clock::now();
-            auto timeSinceLastData = std::chrono::duration_cast<std::chrono::seconds>(
-                currentTime - lastDataTimes[i]).count();
-            
-            // 如果超过1秒没有新数据，清零速率
-            if (timeSinceLastData > 1) {
-                portStats[i].bytesPerSecond = 0.0;
-            }
+    };
+    auto gauge = [&](const char* name, const char* help, auto value) {
+        text.family(name, "gauge", help);
+        for (size_t i = 0; i < collectors.size(); ++i) {
+            text.sample(name, labels[i], static_cast<uint64_t>(value(*collectors[i])));
         }
+    };
+    auto histogram = [&](const char* name, const char* help, auto value) {
+        text.family(name, "histogram", help);
+        for (size_t i = 0; i < collectors.size(); ++i) {
+            text.histogram(name, labels[i], value(collectors[i]->metrics()));
+        }
+    };
+
+    counter("serial_bytes_read_total", "Bytes read from the serial port.",
+            [](const PortCollector& c) { return c.metrics().bytesRead.load(); });
+    counter("serial_chunks_read_total", "Chunks (or frames) read from the serial port.",
+            [](const PortCollector& c) { return c.metrics().chunksRead.load(); });
+    counter("serial_read_errors_total", "Failed reads.",
+            [](const PortCollector& c) { return c.metrics().readErrors.load(); });
+    counter("serial_framing_errors_total", "Invalid frame lengths skipped while resynchronizing.",
+            [](const PortCollector& c) { return c.metrics().framingErrors.load(); });
+    counter("serial_disk_drops_total", "Chunks dropped because the disk queue was full.",
+            [](const PortCollector& c) { return c.diskQueueStats().drops; });
+    counter("serial_tcp_drops_total", "Chunks dropped because the TCP queue was full.",
+            [](const PortCollector& c) { return c.tcpQueueStats().drops; });
+    counter("serial_tcp_bytes_total", "Bytes handed to the TCP socket without spooling.",
+            [](const PortCollector& c) { return c.metrics().tcpBytes.load(); });
+    counter("serial_tcp_connects_total", "TCP connections established.",
+            [](const PortCollector& c) { return c.tcpConnects(); });
+    counter("serial_budget_drops_total",
+            "Chunks dropped by memoryPolicy because a memory budget was exceeded.",
+            [](const PortCollector& c) { return c.metrics().budgetDrops.load(); });
+    text.family("serial_budget_blocked_seconds_total", "counter",
+                "Time the reader waited for memory with memoryPolicy block.");
+    for (size_t i = 0; i < collectors.size(); ++i) {
+        text.sample("serial_budget_blocked_seconds_total", labels[i],
+                    collectors[i]->metrics().budgetBlockedUs.load() / 1e6);
     }
-}
-
-void saveToFile(const PortConfig& config, const std::vector<char>& buffer) {
-    auto now = std::chrono::system_clock::now();
-    auto time = std::chrono::system_clock::to_time_t(now);
-    
-    std::filesystem::path dirPath = "data";
-    dirPath /= config.name;
-    std::filesystem::create_directories(dirPath);
-
-    std::string filename = getDateString() + ".data";
-    auto filepath = dirPath / filename;
-
-    std::ofstream file(filepath, std::ios::app);
-    
-    if (config.addTimestamp) {
-        struct tm timeinfo;
-        localtime_s(&timeinfo, &time);
-        file << std::put_time(&timeinfo, "[%Y-%m-%d %H:%M:%S] ");
-    }
-    
-    file.write(buffer.data(), buffer.size());
-    if (buffer.back() != '\n') {
-        file << std::endl;
+    gauge("serial_disk_queue_depth", "Chunks waiting for the disk writer.",
+          [](const PortCollector& c) { return c.diskQueueStats().depth; });
+    gauge("serial_tcp_queue_depth", "Chunks waiting for the TCP sender.",
+          [](const PortCollector& c) { return c.tcpQueueStats().depth; });
+    gauge("serial_spool_bytes", "Bytes held in the store-and-forward spool.",
+          [](const PortCollector& c) { return c.spooledBytes(); });
+    gauge("serial_memory_bytes", "Memory held by the port's data chunks.",
+          [](const PortCollector& c) { return c.memoryBytes(); });
+    histogram("serial_read_latency_seconds", "Estimated time from first byte arrival to read() return.",
+              [](const PortMetrics& m) -> const Histogram& { return m.readLatency; });
+    histogram("serial_disk_latency_seconds", "Time from read() return to the data file buffer.",
+              [](const PortMetrics& m) -> const Histogram& { return m.diskLatency; });
+    histogram("serial_tcp_latency_seconds", "Time from read() return to the TCP socket.",
+              [](const PortMetrics& m) -> const Histogram& { return m.tcpLatency; });
+
+    text.family("serial_config_reloads_total", "counter", "Configuration reloads applied.");
+    text.sample("serial_config_reloads_total", "", reload.reloads);
+    text.family("serial_config_reload_seconds", "gauge", "Time taken by the last configuration reload.");
+    text.sample("serial_config_reload_seconds", "", reload.lastDurationUs / 1e6);
+    text.family("serial_config_reload_lost_bytes_total", "counter",
+                "Estimated upper bound of bytes lost while ports were closed for reconfiguration.");
+    text.sample("serial_config_reload_lost_bytes_total", "", reload.lostBytes);
+    if (const MemoryBudget* memory = ports.memory()) {
+        text.family("serial_memory_used_bytes", "gauge", "Memory held by the data chunks of all ports.");
+        text.sample("serial_memory_used_bytes", "", static_cast<uint64_t>(memory->used()));
+        text.family("serial_memory_budget_bytes", "gauge", "Global memory budget, 0 for unlimited.");
+        text.sample("serial_memory_budget_bytes", "", static_cast<uint64_t>(memory->limit()));
     }
-}
 
-void collectData(const PortConfig& config, size_t portIndex) {
-    SerialPort port(config);
-    if (!port.open()) {
-        LOG_ERROR(config.name, "Failed to open port");
-        return;
+    if (const DiskBackend* backend = diskWriter.backend()) {
+        DiskBackend::Stats disk = backend->stats();
+        std::string label = PrometheusText::label("backend", backend->name());
+        text.family("serial_disk_backend_writes_total", "counter", "Blocks written by the disk backend.");
+        text.sample("serial_disk_backend_writes_total", label, disk.writes);
+        text.family("serial_disk_backend_bytes_total", "counter", "Bytes written by the disk backend.");
+        text.sample("serial_disk_backend_bytes_total", label, disk.bytes);
+        text.family("serial_disk_backend_syscalls_total", "counter",
+                    "pwrite or io_uring_enter calls made by the disk backend.");
+        text.sample("serial_disk_backend_syscalls_total", label, disk.syscalls);
     }
+    return text.str();
+}
 
-    // 创建 TCP 客户端
-    TcpClient tcpClient(config.tcpForward);
-    if (config.tcpForward.enabled) {
-        tcpClient.start();
-        LOG_ERROR(config.name, "TCP forwarding enabled -> " + 
-                  config.tcpForward.server + ":" + 
-                  std::to_string(config.tcpForward.port));
+// 没有状态显示时只等待退出信号
+void waitForSignal() {
+    while (g_running) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
     }
+}
 
-    std::vector<char> buffer;
-    bool lastReadFailed = false;
-    
-    while (true) {
-        bool readResult = port.read(buffer);
-        if (readResult && !buffer.empty()) {
-            if (isEmptyOrWhitespace(buffer)) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(10));
-                continue;
-            }
-
-            // 更新数据包统计和状态
-            portStats[portIndex].packetsInLastSecond++;
-            portStats[portIndex].isActive = true;  // 设置活动状态
-            lastDataTimes[portIndex] = std::chrono::steady_clock::now();
-            
-            // 保存到文件
-            saveToFile(config, buffer);
-
-            // TCP 转发
-            if (config.tcpForward.enabled) {
-                std::string data(buffer.begin(), buffer.end());
-                tcpClient.send(data);
-            }
-
-            // 更新数据速率统计
-            portStats[portIndex].bytesReceived += buffer.size();
-            auto timeDiff = std::chrono::duration_cast<std::chrono::seconds>(
-                std::chrono::steady_clock::now() - portStats[portIndex].lastUpdate).count();
-            
-            if (timeDiff >= 1) {
-                portStats[portIndex].bytesPerSecond = 
-                    static_cast<double>(portStats[portIndex].bytesReceived) / timeDiff;
-                portStats[portIndex].bytesReceived = 0;
-                portStats[portIndex].lastUpdate = std::chrono::steady_clock::now();
-            }
+int main(int argc, char* argv[]) {
+    std::ios_base::sync_with_stdio(false);
+    std::cout.tie(nullptr);
 
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    bool headless = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--headless") == 0) {
+            headless = true;
         } else {
-            if (!readResult && !lastReadFailed) {
-                LOG_ERROR(config.name, "Read failed - Further errors will be suppressed");
-                lastReadFailed = true;
-            }
-            std::this_thread::sleep_for(std::chrono::seconds(1));
+            std::cerr << "Usage: " << argv[0] << " [--headless]" << std::endl;
+            return 1;
         }
     }
-}
-
-int main() {
-    std::ios_base::sync_with_stdio(false);
-    std::cout.tie(nullptr);
 
     std::vector<PortConfig> configs;
-    if (!Config::load("config.json", configs)) {
+    CollectorConfig collectorConfig;
+    if (!Config::load("config.json", configs, collectorConfig)) {
         return 1;
     }
 
@@ -289,30 +165,83 @@ int main() {
         return 1;
     }
 
-    // 初始化端口数据标志和最后接收时间
-    portDataFlags.resize(configs.size());
-    lastDataTimes.resize(configs.size());
-    auto currentTime = std::chrono::steady_clock::now();
-    
-    for (size_t i = 0; i < configs.size(); ++i) {
-        portDataFlags[i] = std::make_unique<bool>(false);
-        lastDataTimes[i] = currentTime;  // 使用 steady_clock 的时间点
+    // 之后创建的线程继承主线程的设置：写盘、TCP、压缩、统计接口等线程运行在 bulkScheduling 的 CPU 上，
+    // 串口读取线程和 Reactor 线程启动时再设置自己的调度
+    captureDefaultAffinity();
+    if (collectorConfig.lockMemory) {
+        lockProcessMemory();
+    }
+    applyScheduling(collectorConfig.bulkScheduling, "Collector");
+    Logger::getInstance();  // 日志线程在这里创建，不继承读取线程的实时优先级
+
+    // 所有 Event 模式的串口由固定数量的 epoll 线程采集，线程数不随串口数量增长
+    ReactorPool reactors(static_cast<size_t>(collectorConfig.reactorThreads), collectorConfig.reactorScheduling);
+    bool reactorsStarted = reactors.start();
+
+    // 所有串口的数据块内存计入全局预算，须比写盘线程和 TCP 连接活得更久
+    MemoryBudget memory(static_cast<size_t>((std::max)(collectorConfig.memoryBudgetMB, 0)) * 1024 * 1024);
+
+    // 所有串口共用一个写盘线程；diskBackend 为 uring 时共用一个 io_uring 批量提交
+    DiskWriter diskWriter(DiskBackend::create(
+        collectorConfig.diskBackend, collectorConfig.directIo,
+        static_cast<unsigned>((std::max)(collectorConfig.uringEntries, 1)),
+        static_cast<size_t>((std::max)(collectorConfig.uringBufferMB, 0)) * 1024 * 1024));
+    diskWriter.start();
+
+    // TCP 转发连接，multiplex 的串口按 server:port 共用
+    Uplinks uplinks;
+
+    // Event 模式注册到 epoll；其他模式或不支持 epoll 时使用独立读取线程
+    PortSet ports(diskWriter, uplinks, reactorsStarted ? &reactors : nullptr, &memory);
+
+    // 本地统计接口，未配置端口和套接字时不启动
+    MetricsServer metricsServer([&ports, &diskWriter] { return renderMetrics(ports, diskWriter); });
+    if (collectorConfig.metricsPort > 0 || !collectorConfig.metricsSocket.empty()) {
+        metricsServer.start(collectorConfig.metricsAddress, collectorConfig.metricsPort,
+                            collectorConfig.metricsSocket);
     }
 
-    // 创建状态显示线程
-    std::thread statusThread(displayStatus, std::ref(configs));
+    ports.apply(configs);
 
-    // 创建数据采集线程
-    std::vector<std::thread> threads;
-    for (size_t i = 0; i < configs.size(); ++i) {
-        threads.emplace_back(collectData, std::ref(configs[i]), i);
-    }
+    // 配置文件变化后只重建受影响的串口；collector 部分（线程数、统计接口、写盘后端、调度）需要重启才生效
+    ConfigWatcher watcher("config.json", [&ports, &collectorConfig] {
+        std::vector<PortConfig> reloaded;
+        CollectorConfig reloadedCollector;
+        if (!std::filesystem::exists("config.json")) {
+            return;  // 文件被删除时 load 会写入默认配置，这里保持当前串口不变
+        }
+        if (!Config::load("config.json", reloaded, reloadedCollector) || reloaded.empty()) {
+            LOG_ERROR("Config", "Invalid config.json, keeping the running configuration");
+            return;
+        }
+        if (reloadedCollector != collectorConfig) {
+            LOG_ERROR("Config", "Changes to the collector section take effect after restart");
+        }
+        ports.apply(reloaded);
+    });
+    watcher.start();
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
 
-    // 等待线程结束
-    statusThread.join();
-    for (auto& thread : threads) {
-        thread.join();
+    // 作为服务运行（headless 或输出不是终端）时不显示状态，运行状态通过统计接口查看
+#ifdef _WIN32
+    bool console = _isatty(_fileno(stdout)) != 0;
+#else
+    bool console = isatty(STDOUT_FILENO) != 0;
+#endif
+    if (headless || collectorConfig.headless || !console) {
+        waitForSignal();
+    } else {
+        StatusView view(ports);
+        view.run(g_running);
     }
+    watcher.stop();
+    metricsServer.stop();
+
+    ports.stopAll();
+    uplinks.stop();
+    diskWriter.stop();
 
     return 0;
-} 
\ No newline at end of file
+}